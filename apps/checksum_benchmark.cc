@@ -0,0 +1,86 @@
+#include "util.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+constexpr size_t bytes_per_run = 1024 * 1024 * 1024;
+
+//! Where results go, so that the compiler keeps the work that computes them
+static volatile uint16_t sink;
+
+//! The checksum one byte at a time (how InternetChecksum::add used to work), for comparison
+static uint16_t bytewise_checksum(const string_view data) {
+    uint32_t sum = 0;
+    bool parity = false;
+    for (const char ch : data) {
+        uint16_t val = uint8_t(ch);
+        if (not parity) {
+            val <<= 8;
+        }
+        sum += val;
+        parity = not parity;
+    }
+    while (sum > 0xffff) {
+        sum = (sum >> 16) + (sum & 0xffff);
+    }
+    return ~sum;
+}
+
+//! Checksums `bytes_per_run` bytes in pieces of `len` bytes, and reports GB/s
+template <typename ChecksumT>
+void main_loop(const string &name, const size_t len, const ChecksumT &checksum) {
+    string data(len, 0);
+    for (auto &ch : data) {
+        ch = rand();
+    }
+
+    const size_t iterations = bytes_per_run / len;
+    const auto first_time = high_resolution_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        data[0] = char(i);  // keep the compiler from hoisting the work out of the loop
+        sink = checksum(data);
+    }
+    const auto final_time = high_resolution_clock::now();
+
+    const auto duration = duration_cast<nanoseconds>(final_time - first_time).count();
+    const double gigabytes_per_second = double(iterations * len) / double(duration);
+
+    cout << fixed << setprecision(2);
+    cout << setw(8) << name << ", " << setw(5) << len << "-byte buffers: " << setw(6) << gigabytes_per_second
+         << " GB/s\n";
+}
+
+int main() {
+    try {
+        const vector<pair<string, InternetChecksum::Kernel>> kernels = {{"scalar", InternetChecksum::Kernel::Scalar},
+                                                                         {"sse2", InternetChecksum::Kernel::SSE2},
+                                                                         {"avx2", InternetChecksum::Kernel::AVX2}};
+
+        for (const size_t len : {64, 1500, 65536}) {
+            main_loop("bytewise", len, bytewise_checksum);
+            for (const auto &[name, kernel] : kernels) {
+                if (not InternetChecksum::supported(kernel)) {
+                    continue;
+                }
+                main_loop(name, len, [kernel = kernel](const string_view data) {
+                    InternetChecksum check(0, kernel);
+                    check.add(data);
+                    return check.value();
+                });
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,218 @@
+#include "destination_cache.hh"
+#include "dir_24_8.hh"
+#include "linear_prefix_table.hh"
+#include "poptrie.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+constexpr size_t table_size = 1'000'000;
+constexpr size_t lookups_per_run = 20'000'000;
+
+//! Where results go, so that the compiler keeps the work that computes them
+static volatile uint32_t sink;
+
+//! A synthetic table with roughly the prefix lengths of a full BGP table: mostly /24s, then /22s and
+//! /23s, a spread of shorter prefixes, and a few longer than /24
+static vector<pair<uint32_t, uint8_t>> synthetic_table(mt19937 &rng) {
+    const vector<pair<uint8_t, double>> lengths = {{8, 0.0002}, {12, 0.002}, {14, 0.005}, {16, 0.013}, {18, 0.02},
+                                                   {19, 0.03},  {20, 0.05},  {21, 0.05},  {22, 0.11},  {23, 0.10},
+                                                   {24, 0.6},   {28, 0.01},  {32, 0.0098}};
+    vector<double> weights;
+    for (const auto &length : lengths) {
+        weights.push_back(length.second);
+    }
+    discrete_distribution<size_t> pick_length(weights.begin(), weights.end());
+
+    vector<pair<uint32_t, uint8_t>> table;
+    table.reserve(table_size);
+    for (size_t i = 0; i < table_size; i++) {
+        // keep prefixes out of 0/8 and the multicast and reserved space, like real unicast routes
+        const uint32_t prefix = 0x0100'0000 + uint32_t(rng()) % 0xdf00'0000;
+        table.emplace_back(prefix, lengths[pick_length(rng)].first);
+    }
+    return table;
+}
+
+//! A skewed trace: destinations drawn from `flows` addresses in the table's prefixes, the `k`th most
+//! popular with probability proportional to 1/k (a Zipf distribution, like the flows of real traffic)
+static vector<uint32_t> zipf_addresses(mt19937 &rng, const vector<uint32_t> &covered, const size_t flows) {
+    vector<double> weights;
+    for (size_t k = 1; k <= flows; k++) {
+        weights.push_back(1.0 / double(k));
+    }
+    discrete_distribution<size_t> pick_flow(weights.begin(), weights.end());
+
+    vector<uint32_t> addresses(covered.size());
+    for (auto &address : addresses) {
+        address = covered[pick_flow(rng)];
+    }
+    return addresses;
+}
+
+//! Looks up each of `addresses` in turn, `count` lookups in all, and reports ns per lookup and Mpps
+template <typename TableT>
+void main_loop(const string &name, const TableT &table, const vector<uint32_t> &addresses, const size_t count) {
+    const auto first_time = high_resolution_clock::now();
+    for (size_t i = 0; i < count; i++) {
+        sink = table.lookup(addresses[i % addresses.size()]).value_or(0);
+    }
+    const auto final_time = high_resolution_clock::now();
+
+    const auto duration = duration_cast<nanoseconds>(final_time - first_time).count();
+    cout << fixed << setprecision(1);
+    cout << "    " << left << setw(38) << name << right << setw(10) << double(duration) / count << " ns/lookup"
+         << setw(10) << 1000.0 * count / duration << " Mpps\n";
+}
+
+//! Like main_loop, but looks the addresses up `batch` at a time with the batched lookup
+template <typename TableT>
+void batch_loop(const string &name, const TableT &table, const vector<uint32_t> &addresses, const size_t count) {
+    constexpr size_t batch = 32;
+    vector<optional<uint32_t>> values(batch);
+    const auto first_time = high_resolution_clock::now();
+    for (size_t i = 0; i < count; i += batch) {
+        table.lookup(&addresses[i % addresses.size()], values.data(), batch);
+        sink = values[0].value_or(0);
+    }
+    const auto final_time = high_resolution_clock::now();
+
+    const auto duration = duration_cast<nanoseconds>(final_time - first_time).count();
+    cout << fixed << setprecision(1);
+    cout << "    " << left << setw(38) << name << right << setw(10) << double(duration) / count << " ns/lookup"
+         << setw(10) << 1000.0 * count / duration << " Mpps\n";
+}
+
+//! Like batch_loop, but looks the addresses up in a DestinationCache of `sets` sets first, and only
+//! those that miss in the table, as Router does; also reports the share that hit
+template <typename TableT>
+void cached_loop(const string &name,
+                 const TableT &table,
+                 const size_t sets,
+                 const vector<uint32_t> &addresses,
+                 const size_t count) {
+    constexpr size_t batch = 32;
+    DestinationCache cache{sets};
+    cache.validate(1);
+    vector<optional<uint32_t>> values(batch), found(batch);
+    vector<uint32_t> missed(batch);
+    vector<size_t> missed_index(batch);
+    const auto first_time = high_resolution_clock::now();
+    for (size_t i = 0; i < count; i += batch) {
+        const uint32_t *next = &addresses[i % addresses.size()];
+        const size_t misses = cache.lookup(next, values.data(), missed_index.data(), batch);
+        for (size_t k = 0; k < misses; k++) {
+            missed[k] = next[missed_index[k]];
+        }
+        if (misses > 0) {
+            table.lookup(missed.data(), found.data(), misses);
+            for (size_t k = 0; k < misses; k++) {
+                values[missed_index[k]] = found[k];
+                cache.insert(missed[k], found[k]);
+            }
+        }
+        sink = values[0].value_or(0);
+    }
+    const auto final_time = high_resolution_clock::now();
+
+    const auto duration = duration_cast<nanoseconds>(final_time - first_time).count();
+    cout << fixed << setprecision(1);
+    cout << "    " << left << setw(38) << name << right << setw(10) << double(duration) / count << " ns/lookup"
+         << setw(10) << 1000.0 * count / duration << " Mpps" << setw(8)
+         << 100.0 * cache.hits() / (cache.hits() + cache.misses()) << "% hits\n";
+}
+
+int main() {
+    try {
+        mt19937 rng(12345);
+        const auto table = synthetic_table(rng);
+
+        Poptrie poptrie;
+        LinearPrefixTable linear;
+        for (size_t i = 0; i < table.size(); i++) {
+            poptrie.insert(table[i].first, table[i].second, i);
+            linear.insert(table[i].first, table[i].second, i);
+        }
+
+        // DIR-24-8 is built as it goes, so its build time is that of the insertions
+        Dir24_8 dir_24_8;
+        const auto insert_start = high_resolution_clock::now();
+        for (size_t i = 0; i < table.size(); i++) {
+            dir_24_8.insert(table[i].first, table[i].second, i);
+        }
+        const auto insert_end = high_resolution_clock::now();
+        cout << "DIR-24-8 of " << dir_24_8.size() << " prefixes: built in "
+             << duration_cast<milliseconds>(insert_end - insert_start).count() << " ms, "
+             << dir_24_8.memory_usage() / (1024 * 1024) << " MiB\n";
+
+        const auto build_start = high_resolution_clock::now();
+        poptrie.build();
+        const auto build_end = high_resolution_clock::now();
+        cout << "Poptrie of " << poptrie.size() << " prefixes: built in "
+             << duration_cast<milliseconds>(build_end - build_start).count() << " ms, "
+             << poptrie.memory_usage() / (1024 * 1024) << " MiB\n";
+
+        // uniformly random addresses, addresses inside the table's prefixes (which reach deeper nodes),
+        // and a skewed trace of those, which mostly hits in the cache
+        vector<uint32_t> random_addresses(1 << 20), covered_addresses(1 << 20);
+        for (auto &address : random_addresses) {
+            address = rng();
+        }
+        for (auto &address : covered_addresses) {
+            const auto &[prefix, length] = table[rng() % table.size()];
+            address = prefix ^ (length == 32 ? 0 : uint32_t(rng()) >> length);
+        }
+
+        const auto skewed_addresses = zipf_addresses(rng, covered_addresses, 100'000);
+        const auto very_skewed_addresses = zipf_addresses(rng, covered_addresses, 10'000);
+
+        cout << "Lookups:\n";
+        main_loop("poptrie, random addresses", poptrie, random_addresses, lookups_per_run);
+        main_loop("poptrie, addresses in the table", poptrie, covered_addresses, lookups_per_run);
+        main_loop("poptrie, skewed addresses", poptrie, skewed_addresses, lookups_per_run);
+        main_loop("DIR-24-8, random addresses", dir_24_8, random_addresses, lookups_per_run);
+        main_loop("DIR-24-8, addresses in the table", dir_24_8, covered_addresses, lookups_per_run);
+        main_loop("DIR-24-8, skewed addresses", dir_24_8, skewed_addresses, lookups_per_run);
+
+        // the address traces are a whole number of batches long
+        cout << "Batched lookups:\n";
+        batch_loop("poptrie, random addresses", poptrie, random_addresses, lookups_per_run);
+        batch_loop("poptrie, addresses in the table", poptrie, covered_addresses, lookups_per_run);
+        batch_loop("poptrie, skewed addresses", poptrie, skewed_addresses, lookups_per_run);
+        batch_loop("DIR-24-8, random addresses", dir_24_8, random_addresses, lookups_per_run);
+        batch_loop("DIR-24-8, addresses in the table", dir_24_8, covered_addresses, lookups_per_run);
+        batch_loop("DIR-24-8, skewed addresses", dir_24_8, skewed_addresses, lookups_per_run);
+
+        // skewed traces of 100k and 10k destinations, through destination caches of 1k to 16k entries
+        cout << "Batched lookups through a destination cache:\n";
+        for (const size_t sets : {256, 1024, 4096}) {
+            const string entries = to_string(sets * DestinationCache::WAYS / 1024) + "k";
+            cached_loop("poptrie, skewed, " + entries + " cached", poptrie, sets, skewed_addresses, lookups_per_run);
+            cached_loop(
+                "poptrie, very skewed, " + entries + " cached", poptrie, sets, very_skewed_addresses, lookups_per_run);
+            cached_loop("DIR-24-8, skewed, " + entries + " cached", dir_24_8, sets, skewed_addresses, lookups_per_run);
+            cached_loop("DIR-24-8, very skewed, " + entries + " cached",
+                        dir_24_8,
+                        sets,
+                        very_skewed_addresses,
+                        lookups_per_run);
+        }
+        batch_loop("poptrie, very skewed addresses", poptrie, very_skewed_addresses, lookups_per_run);
+        batch_loop("DIR-24-8, very skewed addresses", dir_24_8, very_skewed_addresses, lookups_per_run);
+        main_loop("linear scan, addresses in the table", linear, covered_addresses, 100);
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,104 @@
+#include "multi_queue_tun_stack.hh"
+#include "socket.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+constexpr size_t num_connections = 16;
+constexpr size_t bytes_per_connection = 4 * 1024 * 1024;
+constexpr uint16_t server_port = 9090;
+
+//! The kernel's TCP sends `bytes_per_connection` over each of `num_connections` connections
+//! to a MultiQueueTunStack with `num_queues` queues on the device `devname`, listening at `server`
+void main_loop(const string &devname, const string &server, const size_t num_queues) {
+    ShardedRuntimeConfig cfg;
+    cfg.num_shards = num_queues;
+
+    atomic<size_t> bytes_received{0};
+    vector<vector<FourTuple>> accepted(num_queues);  // each element only touched by its shard's thread
+    MultiQueueTunStack stack(devname, cfg, [&](ShardedTCPRuntime::Shard &shard) {
+        auto &connections = accepted[shard.index()];
+        while (const auto tuple = shard.listener().accept()) {
+            connections.push_back(*tuple);
+        }
+        for (const auto &tuple : connections) {
+            auto &inbound = shard.listener().connection(tuple).inbound_stream();
+            const size_t available = inbound.buffer_size();
+            if (available) {
+                inbound.pop_output(available);
+                bytes_received += available;
+            }
+        }
+    });
+    stack.start();
+
+    const auto first_time = high_resolution_clock::now();
+    vector<thread> clients;
+    for (size_t i = 0; i < num_connections; i++) {
+        clients.emplace_back([&] {
+            TCPSocket sock;
+            sock.connect({server, server_port});
+            const string block(65536, 'x');
+            for (size_t written = 0; written < bytes_per_connection; written += block.size()) {
+                sock.write(block);
+            }
+            while (bytes_received.load() < num_connections * bytes_per_connection) {
+                this_thread::sleep_for(milliseconds(1));
+            }
+        });
+    }
+
+    while (bytes_received.load() < num_connections * bytes_per_connection) {
+        this_thread::sleep_for(microseconds(100));
+    }
+    const auto final_time = high_resolution_clock::now();
+    for (auto &client : clients) {
+        client.join();
+    }
+    stack.stop();
+
+    const auto duration = duration_cast<nanoseconds>(final_time - first_time).count();
+    const auto gigabits_per_second = num_connections * bytes_per_connection * 8.0 / double(duration);
+
+    uint64_t drops = 0;
+    for (size_t i = 0; i < num_queues; i++) {
+        drops += stack.runtime().shard(i).ring_drops();
+    }
+
+    cout << fixed << setprecision(2);
+    cout << setw(2) << num_queues << " queue" << (num_queues == 1 ? " " : "s") << ": " << gigabits_per_second
+         << " Gbit/s over " << num_connections << " connections (" << drops << " ring drops)\n";
+}
+
+//! \param[in] argv[1] is the TUN device, created with `multi_queue` (default: tun144)
+//! \param[in] argv[2] is the address the stack answers on, routed to the device (default: 169.254.144.9)
+//! \param[in] argv[3] is the largest number of queues to try (default: the number of cores)
+int main(int argc, char *argv[]) {
+    try {
+        const string devname = argc > 1 ? argv[1] : "tun144";
+        const string server = argc > 2 ? argv[2] : "169.254.144.9";
+        const size_t cores = max(1U, thread::hardware_concurrency());
+        const size_t max_queues = argc > 3 ? stoul(argv[3]) : cores;
+
+        cerr << "Multi-queue TUN benchmark on " << devname << " (" << cores << " cores)\n";
+        for (size_t num_queues = 1; num_queues <= max_queues; num_queues *= 2) {
+            main_loop(devname, server, num_queues);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -2,9 +2,15 @@
 #include "router.hh"
 #include "util.hh"
 
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <list>
+#include <optional>
+#include <string>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
 using namespace std;
 
@@ -150,7 +156,7 @@ class Host {
 
 class Network {
   private:
-    Router _router{};
+    Router _router;
 
     size_t default_id, eth0_id, eth1_id, eth2_id, uun3_id, hs4_id, mit5_id;
 
@@ -206,8 +212,9 @@ class Network {
     }
 
   public:
-    Network()
-        : default_id(_router.add_interface({random_router_ethernet_address(), {"171.67.76.46"}}))
+    explicit Network(const Router::LPM engine)
+        : _router(engine)
+        , default_id(_router.add_interface({random_router_ethernet_address(), {"171.67.76.46"}}))
         , eth0_id(_router.add_interface({random_router_ethernet_address(), {"10.0.0.1"}}))
         , eth1_id(_router.add_interface({random_router_ethernet_address(), {"172.16.0.1"}}))
         , eth2_id(_router.add_interface({random_router_ethernet_address(), {"192.168.0.1"}}))
@@ -270,12 +277,12 @@ class Network {
     }
 };
 
-void network_simulator() {
+void network_simulator(const Router::LPM engine) {
     const string green = "\033[32;1m", normal = "\033[m";
 
     cerr << green << "Constructing network." << normal << "\n";
 
-    Network network;
+    Network network{engine};
 
     cout << green << "\n\nTesting traffic between two ordinary hosts (applesauce to cherrypie)..." << normal << "\n\n";
     {
@@ -344,9 +351,309 @@ void network_simulator() {
     cout << "\n\n\033[32;1mCongratulations! All datagrams were routed successfully.\033[m\n";
 }
 
-int main() {
+//! \brief A star of `ports` subnets, 10.k.0.0/16, each with one host that floods the host on the next
+//! subnet with datagrams, forwarded either by route() in this thread or by a worker thread per interface
+//! \details This thread plays every host: it feeds frames in, answers the router's ARP requests, and
+//! checks that every datagram comes out of the right interface.
+//! \returns the aggregate forwarding rate, in datagrams per second
+double forwarding_rate(const size_t ports, const size_t datagrams, const bool parallel) {
+    Router router;
+    vector<EthernetAddress> router_eth, host_eth;
+    vector<EthernetFrame> traffic;  // what each host sends
+    for (size_t k = 0; k < ports; k++) {
+        router_eth.push_back(random_router_ethernet_address());
+        host_eth.push_back(random_host_ethernet_address());
+        const string subnet = "10." + to_string(k) + ".0.";
+        router.add_interface({router_eth[k], Address(subnet + "1")});
+        router.add_route(ip(subnet + "0"), 16, {}, k);
+
+        InternetDatagram dgram;
+        dgram.header().src = ip(subnet + "2");
+        dgram.header().dst = ip("10." + to_string((k + 1) % ports) + ".0.2");
+        dgram.payload() = string(64, 'x');
+        dgram.header().len = dgram.header().hlen * 4 + dgram.payload().size();
+        EthernetFrame frame;
+        frame.header() = {router_eth[k], host_eth[k], EthernetHeader::TYPE_IPv4};
+        frame.payload() = dgram.serialize().concatenate();
+        traffic.push_back(move(frame));
+    }
+
+    // frames go in and out through the workers' rings, or straight through the interfaces
+    const auto deliver = [&](const size_t k, const EthernetFrame &frame) {
+        if (parallel) {
+            EthernetFrame copy = frame;
+            return router.deliver_frame(k, move(copy));
+        }
+        router.interface(k).recv_frame(frame);
+        return true;
+    };
+    const auto collect = [&](const size_t k) -> optional<EthernetFrame> {
+        if (parallel) {
+            return router.collect_frame(k);
+        }
+        auto &frames = router.interface(k).frames_out();
+        if (frames.empty()) {
+            return {};
+        }
+        EthernetFrame frame = move(frames.front());
+        frames.pop();
+        return frame;
+    };
+
+    // each host announces itself first (with an ARP request for the router), so that no datagram
+    // waits for (or is dropped while) the router resolves its address
+    for (size_t k = 0; k < ports; k++) {
+        ARPMessage announcement;
+        announcement.opcode = ARPMessage::OPCODE_REQUEST;
+        announcement.sender_ethernet_address = host_eth[k];
+        announcement.sender_ip_address = ip("10." + to_string(k) + ".0.2");
+        announcement.target_ip_address = ip("10." + to_string(k) + ".0.1");
+        EthernetFrame frame;
+        frame.header() = {ETHERNET_BROADCAST, host_eth[k], EthernetHeader::TYPE_ARP};
+        frame.payload() = announcement.serialize();
+        router.interface(k).recv_frame(frame);
+        router.interface(k).frames_out() = {};  // (the router's reply)
+    }
+
+    if (parallel) {
+        router.start_workers();
+    }
+    size_t sent = 0, received = 0;
+    const auto start = chrono::steady_clock::now();
+    while (received + router.egress_drops() < datagrams) {
+        for (size_t k = 0; k < ports and sent < datagrams; k++) {
+            sent += deliver(k, traffic[k]);
+        }
+        if (not parallel) {
+            router.route();
+        }
+
+        for (size_t k = 0; k < ports; k++) {
+            while (auto frame = collect(k)) {
+                if (frame->header().type == EthernetHeader::TYPE_ARP) {
+                    ARPMessage request;
+                    if (request.parse(frame->payload().concatenate()) != ParseResult::NoError or
+                        request.opcode != ARPMessage::OPCODE_REQUEST) {
+                        throw runtime_error("router sent a bad ARP request: " + summary(*frame));
+                    }
+                    ARPMessage reply;
+                    reply.opcode = ARPMessage::OPCODE_REPLY;
+                    reply.sender_ethernet_address = host_eth[k];
+                    reply.sender_ip_address = request.target_ip_address;
+                    reply.target_ethernet_address = request.sender_ethernet_address;
+                    reply.target_ip_address = request.sender_ip_address;
+                    EthernetFrame reply_frame;
+                    reply_frame.header() = {router_eth[k], host_eth[k], EthernetHeader::TYPE_ARP};
+                    reply_frame.payload() = reply.serialize();
+                    while (not deliver(k, reply_frame)) {
+                        this_thread::yield();
+                    }
+                    continue;
+                }
+
+                InternetDatagram dgram;
+                if (dgram.parse(frame->payload().concatenate()) != ParseResult::NoError or
+                    (dgram.header().dst & 0xffff'0000) != ip("10." + to_string(k) + ".0.0")) {
+                    throw runtime_error("router sent a datagram out the wrong interface: " + summary(*frame));
+                }
+                received++;
+            }
+        }
+
+        if (chrono::steady_clock::now() - start > chrono::seconds(60)) {
+            throw runtime_error("forwarding stalled after " + to_string(received) + " datagrams");
+        }
+    }
+    const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    router.stop_workers();
+
+    if (router.egress_drops() > 0) {
+        cout << "    (" << router.egress_drops() << " datagrams dropped at full egress rings)\n";
+    }
+    return received / elapsed.count();
+}
+
+void parallel_forwarding(const size_t ports, const size_t datagrams) {
+    const string green = "\033[32;1m", normal = "\033[m";
+
+    cout << green << "Forwarding " << datagrams << " datagrams among " << ports << " subnets..." << normal << "\n";
+    const double sequential = forwarding_rate(ports, datagrams, false);
+    cout << "    route() in one thread:         " << sequential / 1e6 << " Mpps\n";
+    const double parallel = forwarding_rate(ports, datagrams, true);
+    cout << "    a worker thread per interface: " << parallel / 1e6 << " Mpps (on "
+         << thread::hardware_concurrency() << " cores)\n";
+
+    cout << "\n\033[32;1mCongratulations! All datagrams were routed successfully.\033[m\n";
+}
+
+//! Pass the frames `from` has sent to `to`, calling `observe` on each; returns how many there were
+template <typename ObserveT>
+size_t transfer(AsyncNetworkInterface &from, AsyncNetworkInterface &to, ObserveT &&observe) {
+    size_t count = 0;
+    for (auto &frames = from.frames_out(); not frames.empty(); frames.pop(), count++) {
+        frames.front().payload() = frames.front().payload().concatenate();
+        observe(frames.front());
+        to.recv_frame(move(frames.front()));
+    }
+    return count;
+}
+
+//! \brief Two routers joined by two parallel links, with a multipath route over both
+//! \details Host 10.0.0.2, behind router A, sends to host 10.9.0.2, behind router B, on many TCP
+//! flows. Each flow must stay on one link (so that it stays in order), the flows must spread over
+//! both, and changing the links' weights, or taking a link away and back, must only move the flows
+//! that have to move.
+void dual_link() {
+    const string green = "\033[32;1m", normal = "\033[m";
+    constexpr unsigned FLOWS = 1000;
+    constexpr unsigned ROUNDS = 5;
+
+    // every flow's first datagram waits for ARP, so each interface lets a datagram per flow wait
+    Router a, b;
+    AsyncNetworkInterface host_a{random_host_ethernet_address(), Address("10.0.0.2"), FLOWS};
+    AsyncNetworkInterface host_b{random_host_ethernet_address(), Address("10.9.0.2"), FLOWS};
+    a.add_interface({random_router_ethernet_address(), Address("10.0.0.1"), FLOWS});
+    a.add_interface({random_router_ethernet_address(), Address("10.1.0.1"), FLOWS});
+    a.add_interface({random_router_ethernet_address(), Address("10.2.0.1"), FLOWS});
+    b.add_interface({random_router_ethernet_address(), Address("10.1.0.2"), FLOWS});
+    b.add_interface({random_router_ethernet_address(), Address("10.2.0.2"), FLOWS});
+    b.add_interface({random_router_ethernet_address(), Address("10.9.0.1"), FLOWS});
+
+    a.add_route(ip("10.0.0.0"), 24, {}, 0);
+    b.add_route(ip("10.9.0.0"), 16, {}, 2);
+    b.add_multipath_route(ip("10.0.0.0"), 24, {{Address("10.1.0.1"), 0}, {Address("10.2.0.1"), 1}});
+
+    // sends ROUNDS datagrams on each flow, and returns the link (1 or 2) each flow took
+    unsigned sequence = 0;
+    vector<unsigned> last_received(FLOWS, 0);
+    const auto send_flows = [&]() {
+        vector<unsigned> link(FLOWS, 0);
+        const auto observe = [&](const unsigned on_link) {
+            return [&, on_link](const EthernetFrame &frame) {
+                InternetDatagram dgram;
+                if (frame.header().type != EthernetHeader::TYPE_IPv4 or
+                    dgram.parse(frame.payload().concatenate()) != ParseResult::NoError) {
+                    return;
+                }
+                const unsigned flow = uint8_t(dgram.payload().concatenate()[0]) << 8 |
+                                      uint8_t(dgram.payload().concatenate()[1]);
+                if (link[flow] != 0 and link[flow] != on_link) {
+                    throw runtime_error("flow " + to_string(flow) + " was split over both links");
+                }
+                link[flow] = on_link;
+            };
+        };
+
+        for (unsigned round = 0; round < ROUNDS; round++) {
+            sequence++;
+            for (unsigned flow = 0; flow < FLOWS; flow++) {
+                // a TCP header's ports (source port = flow), then a sequence number
+                string segment(8, 0);
+                segment[0] = char(flow >> 8);
+                segment[1] = char(flow);
+                segment[3] = 80;
+                segment[7] = char(sequence);
+                InternetDatagram dgram;
+                dgram.header().src = ip("10.0.0.2");
+                dgram.header().dst = ip("10.9.0.2");
+                dgram.payload() = move(segment);
+                dgram.header().len = dgram.header().hlen * 4 + dgram.payload().size();
+                host_a.send_datagram(dgram, Address("10.0.0.1"));
+            }
+
+            // until nothing moves: hosts and routers exchange frames, and the routers route
+            while (true) {
+                size_t moved = 0;
+                moved += transfer(host_a, a.interface(0), [](const EthernetFrame &) {});
+                moved += transfer(a.interface(0), host_a, [](const EthernetFrame &) {});
+                moved += transfer(a.interface(1), b.interface(0), observe(1));
+                moved += transfer(b.interface(0), a.interface(1), [](const EthernetFrame &) {});
+                moved += transfer(a.interface(2), b.interface(1), observe(2));
+                moved += transfer(b.interface(1), a.interface(2), [](const EthernetFrame &) {});
+                moved += transfer(b.interface(2), host_b, [](const EthernetFrame &) {});
+                moved += transfer(host_b, b.interface(2), [](const EthernetFrame &) {});
+                a.route();
+                b.route();
+                if (moved == 0) {
+                    break;
+                }
+            }
+
+            // host B must have every datagram of the round, each flow's in order
+            for (auto &received = host_b.datagrams_out(); not received.empty(); received.pop()) {
+                const string payload = received.front().payload().concatenate();
+                const unsigned flow = uint8_t(payload[0]) << 8 | uint8_t(payload[1]);
+                if (uint8_t(payload[7]) != uint8_t(last_received[flow] + 1)) {
+                    throw runtime_error("flow " + to_string(flow) + " lost or reordered a datagram");
+                }
+                last_received[flow]++;
+            }
+            for (unsigned flow = 0; flow < FLOWS; flow++) {
+                if (last_received[flow] != sequence) {
+                    throw runtime_error("flow " + to_string(flow) + " did not arrive");
+                }
+            }
+        }
+        return link;
+    };
+
+    const auto on_link = [](const vector<unsigned> &link, const unsigned which) {
+        return count(link.begin(), link.end(), which);
+    };
+    const auto moved = [](const vector<unsigned> &before, const vector<unsigned> &after) {
+        size_t count = 0;
+        for (size_t flow = 0; flow < before.size(); flow++) {
+            count += before[flow] != after[flow];
+        }
+        return count;
+    };
+
+    cout << green << "Spreading " << FLOWS << " flows over two equal links..." << normal << "\n";
+    a.add_multipath_route(ip("10.9.0.0"), 16, {{Address("10.1.0.2"), 1}, {Address("10.2.0.2"), 2}});
+    const auto even = send_flows();
+    cout << "    link 1: " << on_link(even, 1) << " flows, link 2: " << on_link(even, 2) << " flows\n";
+    if (on_link(even, 1) < FLOWS * 4 / 10 or on_link(even, 2) < FLOWS * 4 / 10) {
+        throw runtime_error("flows were not spread over both links");
+    }
+
+    cout << green << "Reweighting the links 3:1..." << normal << "\n";
+    a.add_multipath_route(ip("10.9.0.0"), 16, {{Address("10.1.0.2"), 1, 3}, {Address("10.2.0.2"), 2, 1}});
+    const auto weighted = send_flows();
+    cout << "    link 1: " << on_link(weighted, 1) << " flows, link 2: " << on_link(weighted, 2) << " flows; "
+         << moved(even, weighted) << " flows moved\n";
+    for (unsigned flow = 0; flow < FLOWS; flow++) {
+        if (even[flow] == 1 and weighted[flow] != 1) {
+            throw runtime_error("a flow left the link whose share grew");
+        }
+    }
+
+    cout << green << "Taking link 2 away, and back..." << normal << "\n";
+    a.add_multipath_route(ip("10.9.0.0"), 16, {{Address("10.1.0.2"), 1}});
+    const auto single = send_flows();
+    a.add_multipath_route(ip("10.9.0.0"), 16, {{Address("10.1.0.2"), 1}, {Address("10.2.0.2"), 2}});
+    const auto restored = send_flows();
+    cout << "    link 1: " << on_link(restored, 1) << " flows, link 2: " << on_link(restored, 2) << " flows; "
+         << moved(single, restored) << " flows moved back\n";
+    if (on_link(single, 2) != 0 or moved(single, restored) != size_t(on_link(restored, 2))) {
+        throw runtime_error("flows moved that did not have to");
+    }
+
+    cout << "\n\033[32;1mCongratulations! All datagrams were routed successfully.\033[m\n";
+}
+
+int main(int argc, char *argv[]) {
     try {
-        network_simulator();
+        const string mode = argc > 1 ? argv[1] : "";
+        if (mode == "parallel" and argc <= 4) {
+            parallel_forwarding(argc > 2 ? stoul(argv[2]) : 4, argc > 3 ? stoul(argv[3]) : 100'000);
+        } else if (mode == "ecmp" and argc == 2) {
+            dual_link();
+        } else if ((mode.empty() or mode == "dir-24-8") and argc <= 2) {
+            network_simulator(mode.empty() ? Router::LPM::Poptrie : Router::LPM::Dir24_8);
+        } else {
+            cerr << "Usage: " << argv[0] << " [dir-24-8 | ecmp | parallel [ports] [datagrams]]\n";
+            return EXIT_FAILURE;
+        }
     } catch (const exception &e) {
         cerr << "\n\n\n";
         cerr << "\033[31;1mError: " << e.what() << "\033[m\n";
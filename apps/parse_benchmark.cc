@@ -0,0 +1,120 @@
+#include "ipv4_datagram.hh"
+#include "ipv4_header.hh"
+#include "tcp_header.hh"
+#include "tcp_over_ip.hh"
+#include "tcp_segment.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+constexpr size_t datagrams_per_run = 4'000'000;
+
+//! Where results go, so that the compiler keeps the work that computes them
+static volatile uint32_t sink;
+
+//! A serialized TCP/IPv4 datagram from 10.0.0.2:`sport` to 10.0.0.1:`dport`
+static Buffer make_datagram(const uint16_t sport, const uint16_t dport, const size_t payload_size) {
+    TCPSegment seg;
+    seg.header().sport = sport;
+    seg.header().dport = dport;
+    seg.header().ack = true;
+    seg.payload() = Buffer{string(payload_size, 'x')};
+
+    IPv4Datagram dgram;
+    dgram.header().src = 0x0a000002;
+    dgram.header().dst = 0x0a000001;
+    dgram.header().len = IPv4Header::LENGTH + TCPHeader::LENGTH + payload_size;
+    dgram.payload() = seg.serialize(dgram.header().pseudo_cksum());
+    return dgram.serialize().concatenate();
+}
+
+//! Runs `handle` on each of `datagrams` in turn, `datagrams_per_run` times in all, and reports ns per datagram
+template <typename HandlerT>
+void main_loop(const string &name, const vector<Buffer> &datagrams, const HandlerT &handle) {
+    const auto first_time = high_resolution_clock::now();
+    for (size_t i = 0; i < datagrams_per_run; i++) {
+        sink = handle(datagrams[i % datagrams.size()]);
+    }
+    const auto final_time = high_resolution_clock::now();
+
+    const auto duration = duration_cast<nanoseconds>(final_time - first_time).count();
+    cout << fixed << setprecision(1);
+    cout << "    " << left << setw(36) << name << right << setw(7) << double(duration) / datagrams_per_run
+         << " ns/datagram\n";
+}
+
+//! Reading the ports: parsing the whole datagram and segment through NetParser, or looking at header views
+static void ports(const size_t payload_size) {
+    const vector<Buffer> datagrams = {make_datagram(5000, 80, payload_size)};
+    cout << "Reading the ports of " << payload_size << "-byte segments:\n";
+
+    main_loop("NetParser (IPv4Datagram, TCPSegment)", datagrams, [](const Buffer &raw) -> uint32_t {
+        IPv4Datagram dgram;
+        if (dgram.parse(raw) != ParseResult::NoError) {
+            return 0;
+        }
+        TCPSegment seg;
+        if (seg.parse(dgram.payload(), dgram.header().pseudo_cksum()) != ParseResult::NoError) {
+            return 0;
+        }
+        return (seg.header().sport << 16) | seg.header().dport;
+    });
+
+    main_loop("header views", datagrams, [](const Buffer &raw) -> uint32_t {
+        const auto ip_header = IPv4HeaderView::from(raw);
+        if (not ip_header) {
+            return 0;
+        }
+        const auto tcp_header = TCPHeaderView::from(ip_header->payload());
+        if (not tcp_header) {
+            return 0;
+        }
+        return (tcp_header->sport() << 16) | tcp_header->dport();
+    });
+}
+
+//! Receiving, when only one datagram in `n` is for the connection (the rest are for other ports)
+static void filtering(const size_t n) {
+    TCPOverIPv4Adapter adapter;
+    adapter.config_mut().source = {"10.0.0.1", 80};
+    adapter.config_mut().destination = {"10.0.0.2", 5000};
+
+    vector<Buffer> datagrams;
+    for (size_t i = 0; i < n; i++) {
+        datagrams.push_back(make_datagram(5000, i == 0 ? 80 : 81 + i, 1000));
+    }
+    cout << "Receiving 1000-byte segments, 1 in " << n << " for the connection:\n";
+
+    main_loop("parse, then unwrap_tcp_in_ip", datagrams, [&](const Buffer &raw) -> uint32_t {
+        IPv4Datagram dgram;
+        if (dgram.parse(raw) != ParseResult::NoError) {
+            return 0;
+        }
+        return adapter.unwrap_tcp_in_ip(dgram).has_value();
+    });
+
+    main_loop("receive (early demux first)", datagrams, [&](const Buffer &raw) -> uint32_t {
+        return adapter.receive(raw).has_value();
+    });
+}
+
+int main() {
+    try {
+        ports(0);
+        ports(1460);
+        filtering(1);
+        filtering(10);
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,141 @@
+#include "sharded_tcp_runtime.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+constexpr size_t num_connections = 64;
+constexpr size_t bytes_per_connection = 1024 * 1024;
+
+static FourTuple reversed(const FourTuple &t) {
+    return {t.remote_address, t.remote_port, t.local_address, t.local_port};
+}
+
+//! Transfer `bytes_per_connection` over each of `num_connections` connections, with clients
+//! and servers each split into `num_shards` shards
+void main_loop(const size_t num_shards) {
+    ShardedRuntimeConfig cfg;
+    cfg.num_shards = num_shards;
+    cfg.num_producers = num_shards;
+    cfg.ring_capacity = 16384;
+
+    const uint32_t client_address = Address("10.0.0.2").ipv4_numeric();
+    const uint32_t server_address = Address("10.0.0.1").ipv4_numeric();
+    vector<FourTuple> tuples;
+    for (uint16_t i = 0; i < num_connections; i++) {
+        tuples.push_back({client_address, uint16_t(40000 + i), server_address, 80});
+    }
+
+    const string block(TCPConfig::DEFAULT_CAPACITY, 'x');
+    atomic<size_t> bytes_received{0};
+
+    // per-shard state, each element only touched by its shard's thread
+    vector<unordered_map<FourTuple, size_t, FourTupleHash>> bytes_to_send(num_shards);
+    vector<char> clients_started(num_shards, false);
+    vector<vector<FourTuple>> accepted(num_shards);
+
+    unique_ptr<ShardedTCPRuntime> servers, clients;
+
+    servers = make_unique<ShardedTCPRuntime>(
+        cfg,
+        [&](ShardedTCPRuntime::Shard &shard, const FourTuple &tuple, TCPSegment &&seg) {
+            clients->deliver(shard.index(), reversed(tuple), move(seg));
+        },
+        [&](ShardedTCPRuntime::Shard &shard) {
+            auto &connections = accepted[shard.index()];
+            while (const auto tuple = shard.listener().accept()) {
+                connections.push_back(*tuple);
+            }
+            for (const auto &tuple : connections) {
+                auto &inbound = shard.listener().connection(tuple).inbound_stream();
+                const size_t available = inbound.buffer_size();
+                if (available) {
+                    inbound.pop_output(available);
+                    bytes_received += available;
+                }
+            }
+        });
+
+    clients = make_unique<ShardedTCPRuntime>(
+        cfg,
+        [&](ShardedTCPRuntime::Shard &shard, const FourTuple &tuple, TCPSegment &&seg) {
+            servers->deliver(shard.index(), reversed(tuple), move(seg));
+        },
+        [&](ShardedTCPRuntime::Shard &shard) {
+            auto &remaining = bytes_to_send[shard.index()];
+            if (not clients_started[shard.index()]) {
+                clients_started[shard.index()] = true;
+                for (const auto &tuple : tuples) {
+                    if (clients->shard_for(tuple) == shard.index()) {
+                        shard.listener().connect(tuple);
+                        remaining[tuple] = bytes_per_connection;
+                    }
+                }
+            }
+            for (auto &[tuple, bytes] : remaining) {
+                if (bytes == 0) {
+                    continue;
+                }
+                auto &connection = shard.listener().connection(tuple);
+                const size_t want = min(bytes, connection.remaining_outbound_capacity());
+                if (want) {
+                    bytes -= connection.write(block.substr(0, want));
+                }
+            }
+        });
+
+    const auto first_time = high_resolution_clock::now();
+    servers->start();
+    clients->start();
+
+    while (bytes_received.load() < num_connections * bytes_per_connection) {
+        this_thread::sleep_for(microseconds(100));
+    }
+
+    const auto final_time = high_resolution_clock::now();
+    clients->stop();
+    servers->stop();
+
+    const auto duration = duration_cast<nanoseconds>(final_time - first_time).count();
+    const auto gigabits_per_second = num_connections * bytes_per_connection * 8.0 / double(duration);
+
+    uint64_t drops = 0;
+    for (size_t i = 0; i < num_shards; i++) {
+        drops += servers->shard(i).ring_drops() + clients->shard(i).ring_drops();
+    }
+
+    cout << fixed << setprecision(2);
+    cout << setw(2) << num_shards << " shard" << (num_shards == 1 ? " " : "s") << ": " << gigabits_per_second
+         << " Gbit/s over " << num_connections << " connections (" << drops << " ring drops)\n";
+}
+
+//! \param[in] argv[1] is the largest number of shards to try (default: half the cores, since
+//!                    clients and servers each get that many threads)
+int main(int argc, char *argv[]) {
+    try {
+        const size_t cores = max(1U, thread::hardware_concurrency());
+        const size_t max_shards = argc > 1 ? stoul(argv[1]) : max<size_t>(1, cores / 2);
+
+        cerr << "Sharded runtime benchmark on " << cores << " cores\n";
+        for (size_t num_shards = 1; num_shards <= max_shards; num_shards *= 2) {
+            main_loop(num_shards);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,131 @@
+#include "tcp_listener.hh"
+#include "util.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <random>
+#include <string>
+
+using namespace std;
+using namespace std::chrono;
+
+constexpr size_t tick_ms = 10;                  // simulated time per step
+constexpr size_t steps = 1000;                  // 10 simulated seconds
+constexpr size_t spoofed_syns_per_step = 1000;  // 100,000 spoofed SYNs per second
+constexpr size_t clients_per_step = 1;          // legitimate connection attempts per step
+constexpr size_t client_deadline_ms = 3000;     // attempts not established by then count as failures
+
+struct Client {
+    TCPConnection connection;
+    size_t started_ms;
+};
+
+void main_loop(const bool use_cookies) {
+    TCPConfig cfg;
+    TCPListenerConfig listener_cfg;
+    if (not use_cookies) {
+        listener_cfg.syn_cookie_threshold = numeric_limits<size_t>::max();
+    }
+    TCPListener listener{cfg, listener_cfg};
+
+    auto rd = get_random_generator();
+    const uint32_t server_address = Address("10.0.0.1").ipv4_numeric();
+    const uint32_t client_address = Address("192.168.0.1").ipv4_numeric();
+
+    map<uint16_t, Client> clients;  // keyed by the client's port
+    uint16_t next_client_port = 1024;
+    size_t attempts = 0, established = 0, total_latency_ms = 0, peak_syn_queue = 0;
+
+    const auto first_time = high_resolution_clock::now();
+
+    for (size_t step = 0; step < steps; step++) {
+        const size_t now_ms = step * tick_ms;
+
+        // the flood: SYNs from random (spoofed) sources that will never answer
+        for (size_t i = 0; i < spoofed_syns_per_step; i++) {
+            FourTuple tuple{server_address, 80, uint32_t(rd()), uint16_t(rd())};
+            TCPSegment syn;
+            syn.header().syn = true;
+            syn.header().seqno = WrappingInt32{uint32_t(rd())};
+            listener.segment_received(tuple, syn);
+        }
+
+        // legitimate clients
+        if (step + client_deadline_ms / tick_ms < steps) {
+            for (size_t i = 0; i < clients_per_step; i++) {
+                auto &client = clients.emplace(next_client_port++, Client{TCPConnection{cfg}, now_ms}).first->second;
+                client.connection.connect();
+                attempts++;
+            }
+        }
+
+        // exchange segments; anything addressed to a spoofed source disappears
+        for (auto &[port, client] : clients) {
+            const FourTuple tuple{server_address, 80, client_address, port};
+            while (not client.connection.segments_out().empty()) {
+                listener.segment_received(tuple, client.connection.segments_out().front());
+                client.connection.segments_out().pop();
+            }
+        }
+        while (not listener.segments_out().empty()) {
+            const auto &[tuple, seg] = listener.segments_out().front();
+            if (tuple.remote_address == client_address) {
+                auto it = clients.find(tuple.remote_port);
+                if (it != clients.end()) {
+                    it->second.connection.segment_received(seg);
+                }
+            }
+            listener.segments_out().pop();
+        }
+        peak_syn_queue = max(peak_syn_queue, listener.syn_queue_size());
+
+        // retire clients the server has accepted (or that gave up)
+        while (const auto accepted = listener.accept()) {
+            auto it = clients.find(accepted->remote_port);
+            established++;
+            total_latency_ms += now_ms - it->second.started_ms;
+            clients.erase(it);
+        }
+        for (auto it = clients.begin(); it != clients.end();) {
+            if (now_ms - it->second.started_ms >= client_deadline_ms) {
+                it = clients.erase(it);
+            } else {
+                it->second.connection.tick(tick_ms);
+                ++it;
+            }
+        }
+
+        listener.tick(tick_ms);
+    }
+
+    const auto final_time = high_resolution_clock::now();
+    const auto duration = duration_cast<nanoseconds>(final_time - first_time).count();
+
+    const auto syns = spoofed_syns_per_step * steps + attempts;
+    const auto &stats = listener.stats();
+
+    cout << fixed << setprecision(2);
+    cout << "SYN cookies " << (use_cookies ? "enabled " : "disabled") << ": " << established << "/" << attempts
+         << " legitimate connections established ("
+         << 100.0 * double(established) / double(attempts) << "%), mean handshake "
+         << (established ? double(total_latency_ms) / double(established) : 0.0) << " ms\n";
+    cout << "                     peak SYN queue " << peak_syn_queue << ", " << stats.syn_queue_drops
+         << " SYNs dropped, " << stats.cookies_sent << " cookies sent, " << stats.cookies_accepted
+         << " accepted, " << syns * 1000.0 / double(duration) << " M SYNs/s processed\n";
+}
+
+int main() {
+    try {
+        main_loop(false);
+        main_loop(true);
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
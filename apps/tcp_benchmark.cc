@@ -1,4 +1,7 @@
+#include "ipv4_datagram.hh"
+#include "packet_pool.hh"
 #include "tcp_connection.hh"
+#include "tcp_over_ip.hh"
 
 #include <chrono>
 #include <cstdlib>
@@ -11,9 +14,29 @@ using namespace std::chrono;
 
 constexpr size_t len = 100 * 1024 * 1024;
 
-void move_segments(TCPConnection &x, TCPConnection &y, vector<TCPSegment> &segments, const bool reorder) {
+//! Sends a segment through IPv4 serialization and parsing, checksums included, as a TCPOverIPv4 adapter would
+TCPSegment over_the_wire(TCPSegment &seg) {
+    static const FourTuple tuple{0x0a000001, 1234, 0x0a000002, 5678};
+    InternetDatagram dgram;
+    if (dgram.parse(tcp_segment_to_ip(tuple, seg).serialize().concatenate()) != ParseResult::NoError) {
+        throw runtime_error("datagram failed to parse");
+    }
+    FourTuple received_tuple;
+    auto received = tcp_segment_from_ip(dgram, received_tuple);
+    if (not received) {
+        throw runtime_error("segment failed to parse");
+    }
+    return move(received.value());
+}
+
+void move_segments(
+    TCPConnection &x, TCPConnection &y, vector<TCPSegment> &segments, const bool reorder, const bool checksum) {
     while (not x.segments_out().empty()) {
-        segments.emplace_back(move(x.segments_out().front()));
+        if (checksum) {
+            segments.emplace_back(over_the_wire(x.segments_out().front()));
+        } else {
+            segments.emplace_back(move(x.segments_out().front()));
+        }
         x.segments_out().pop();
     }
     if (reorder) {
@@ -28,7 +51,7 @@ void move_segments(TCPConnection &x, TCPConnection &y, vector<TCPSegment> &segme
     segments.clear();
 }
 
-void main_loop(const bool reorder) {
+void main_loop(const bool reorder, const bool checksum = false) {
     TCPConfig config;
     TCPConnection x{config}, y{config};
 
@@ -46,6 +69,7 @@ void main_loop(const bool reorder) {
     string string_received;
     string_received.reserve(len);
 
+    const auto first_stats = PacketPool::stats();
     const auto first_time = high_resolution_clock::now();
 
     auto loop = [&] {
@@ -66,8 +90,8 @@ void main_loop(const bool reorder) {
 
         // exchange segments between x and y but in reverse order
         vector<TCPSegment> segments;
-        move_segments(x, y, segments, reorder);
-        move_segments(y, x, segments, false);
+        move_segments(x, y, segments, reorder, checksum);
+        move_segments(y, x, segments, false, checksum);
 
         // read output from y
         const auto available_output = y.inbound_stream().buffer_size();
@@ -89,15 +113,22 @@ void main_loop(const bool reorder) {
     }
 
     const auto final_time = high_resolution_clock::now();
+    const auto final_stats = PacketPool::stats();
 
     const auto duration = duration_cast<nanoseconds>(final_time - first_time).count();
 
     const auto gigabits_per_second = len * 8.0 / double(duration);
 
     cout << fixed << setprecision(2);
-    cout << "CPU-limited throughput" << (reorder ? " with reordering: " : "                : ") << gigabits_per_second
+    const string conditions = reorder ? " with reordering" : (checksum ? " with checksums" : "");
+    cout << "CPU-limited throughput" << left << setw(16) << conditions << right << ": " << gigabits_per_second
          << " Gbit/s\n";
 
+    const auto allocations = final_stats.allocations - first_stats.allocations;
+    const auto reuses = final_stats.reuses - first_stats.reuses;
+    cout << "    packet pool: " << allocations << " allocations, " << 100.0 * reuses / max(allocations, uint64_t(1))
+         << "% from free lists\n";
+
     while (x.active() or y.active()) {
         loop();
     }
@@ -107,6 +138,7 @@ int main() {
     try {
         main_loop(false);
         main_loop(true);
+        main_loop(false, true);
     } catch (const exception &e) {
         cerr << e.what() << "\n";
         return EXIT_FAILURE;
@@ -0,0 +1,90 @@
+#include "tcp_config.hh"
+#include "tcp_sponge_socket.hh"
+#include "util.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+
+using namespace std;
+using namespace std::chrono;
+
+using DataChannel = TCPOverUDPSpongeSocket::DataChannel;
+
+constexpr size_t write_size = 16384;
+
+//! Send `len` bytes from a client to a server over loopback UDP, with both sockets using `channel`
+//! to move bytes between the application and the TCP thread, and UDP GSO/GRO if `offload`
+void main_loop(const size_t len, const DataChannel channel, const bool offload) {
+    TCPConfig c_tcp;
+    c_tcp.rt_timeout = 100;  // keep the client's linger short
+
+    UDPSocket server_udp;
+    server_udp.bind({"127.0.0.1", "0"});
+    FdAdapterConfig c_server;
+    c_server.source = server_udp.local_address();
+    FdAdapterConfig c_client;
+    c_client.destination = c_server.source;
+
+    size_t bytes_received = 0;
+    high_resolution_clock::time_point final_time;
+    TCPOverUDPSpongeSocket server(TCPOverUDPSocketAdapter(move(server_udp), offload), channel);
+    thread server_thread([&] {
+        server.listen_and_accept(c_tcp, c_server);
+        string data;
+        while (not server.eof()) {
+            server.read(data);
+            bytes_received += data.size();
+        }
+        final_time = high_resolution_clock::now();
+        server.wait_until_closed();
+    });
+
+    TCPOverUDPSpongeSocket client(TCPOverUDPSocketAdapter(UDPSocket{}, offload), channel);
+    const auto first_time = high_resolution_clock::now();
+    client.connect(c_tcp, c_client);
+    const string block(write_size, 'x');
+    for (size_t written = 0; written < len; written += write_size) {
+        client.write(block);
+    }
+    client.shutdown(SHUT_WR);
+
+    server_thread.join();
+    client.wait_until_closed();
+
+    if (bytes_received != len) {
+        throw runtime_error("received " + to_string(bytes_received) + " bytes, expected " + to_string(len));
+    }
+
+    const auto duration = duration_cast<nanoseconds>(final_time - first_time).count();
+    const auto gigabits_per_second = len * 8.0 / double(duration);
+
+    cout << fixed << setprecision(2);
+    cout << (channel == DataChannel::SocketPair ? "  socket pair" : "shared memory")
+         << (offload ? ", GSO/GRO: " : ",  no GSO: ") << gigabits_per_second << " Gbit/s\n";
+}
+
+//! \param[in] argv[1] is the number of MiB to transfer (default 16)
+int main(int argc, char *argv[]) {
+    try {
+        const size_t mebibytes = argc > 1 ? stoul(argv[1]) : 16;
+        const size_t len = mebibytes * 1024 * 1024;
+
+        cerr << "Transferring " << mebibytes << " MiB over loopback UDP\n";
+        if (not UDPSocket{}.gso_supported()) {
+            cerr << "(UDP GSO not supported by this kernel; GSO/GRO runs fall back to plain sendmmsg)\n";
+        }
+        for (const bool offload : {false, true}) {
+            main_loop(len, DataChannel::SocketPair, offload);
+            main_loop(len, DataChannel::SharedMemory, offload);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -4,3 +4,9 @@ macro (add_sponge_exec exec_name)
     add_executable ("${exec_name}" "${exec_name}.cc")
     target_link_libraries ("${exec_name}" ${ARGN} sponge ${LIBPTHREAD})
 endmacro (add_sponge_exec)
+
+# A program that never shares packets between threads can drop the atomic reference counts in Buffer
+option (SPONGE_NONATOMIC_REFCOUNT "Use non-atomic reference counts for packet buffers (single-threaded programs only)" OFF)
+if (SPONGE_NONATOMIC_REFCOUNT)
+    add_definitions (-DSPONGE_NONATOMIC_REFCOUNT)
+endif ()
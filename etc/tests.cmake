@@ -42,6 +42,32 @@ add_test(NAME t_webget               COMMAND "${PROJECT_SOURCE_DIR}/tests/webget
 add_test(NAME arp_network_interface    COMMAND net_interface)
 
 add_test(NAME router_test    COMMAND network_simulator)
+add_test(NAME router_test_dir_24_8 COMMAND network_simulator dir-24-8)
+add_test(NAME router_parallel COMMAND network_simulator parallel 4 20000)
+add_test(NAME router_ecmp COMMAND network_simulator ecmp)
+
+add_test(NAME t_listener_syn_cookie  COMMAND tcp_listener_syn_cookie)
+add_test(NAME t_listener_time_wait   COMMAND tcp_listener_time_wait)
+add_test(NAME t_sharded_runtime      COMMAND sharded_tcp_runtime)
+add_test(NAME t_shm_byte_ring        COMMAND shm_byte_ring)
+add_test(NAME t_udp_socket_batch     COMMAND udp_socket_batch)
+add_test(NAME t_tcp_segment_ip       COMMAND tcp_segment_ip)
+add_test(NAME t_virtio_net_header    COMMAND virtio_net_header)
+add_test(NAME t_internet_checksum    COMMAND internet_checksum)
+add_test(NAME t_packet_pool          COMMAND packet_pool)
+add_test(NAME t_small_vector         COMMAND small_vector)
+add_test(NAME t_packet_buffer        COMMAND packet_buffer)
+add_test(NAME t_header_view          COMMAND header_view)
+add_test(NAME t_tcp_early_demux      COMMAND tcp_early_demux)
+add_test(NAME t_poptrie              COMMAND poptrie)
+add_test(NAME t_dir_24_8             COMMAND dir_24_8)
+add_test(NAME t_router_rcu           COMMAND router_rcu)
+add_test(NAME t_mpsc_ring            COMMAND mpsc_ring)
+add_test(NAME t_resilient_hash_table COMMAND resilient_hash_table)
+add_test(NAME t_destination_cache    COMMAND destination_cache)
+add_test(NAME t_flat_ip_map          COMMAND flat_ip_map)
+add_test(NAME t_arp_pending_queue    COMMAND arp_pending_queue)
+add_test(NAME t_ethernet_header_template COMMAND ethernet_header_template)
 
 add_test(NAME t_tcp_parser           COMMAND tcp_parser "${PROJECT_SOURCE_DIR}/tests/ipv4_parser.data")
 add_test(NAME t_ipv4_parser          COMMAND ipv4_parser "${PROJECT_SOURCE_DIR}/tests/ipv4_parser.data")
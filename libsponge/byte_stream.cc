@@ -19,7 +19,9 @@ using namespace std;
 //这里相当于是python中的实例化类，并且在:后进行成员初始化列表init(),该列表的内容是在byte_stream.cc中private下的成员
 //size_t 是一个无符号整数类型，通常用于表示对象的大小或数组的索引
 ByteStream::ByteStream(const size_t capacity): 
-    _queue(),
+    _buffer(capacity, 0),
+    _head(0),
+    _buffer_size(0),
     _capacity_size(capacity),
     _written_size(0),
     _read_size(0),
@@ -30,18 +32,23 @@ size_t ByteStream::write(const string &data) {
     /*
     1、判断是否结束输入
     2、计算要写入的数据大小，是在传入的data大小和缓冲区总量-队列大小中，较小的写入管道
-    3、将要写入的值添加到队列_queue后
+    3、将要写入的值复制到环形缓冲区的尾部,到达_buffer末尾时从头继续(最多分两段复制)
     4、返回要写入的数据大小
     */
     if (_end_input)
         return 0;
 
-    size_t write_size = min(data.size(), _capacity_size - _queue.size());
+    size_t write_size = min(data.size(), _capacity_size - _buffer_size);
     //统计全部已经写入的数据大小
     _written_size += write_size;
 
-    for (size_t i = 0; i < write_size; i++)
-        _queue.push_back(data[i]);
+    if (write_size == 0)
+        return 0;
+    const size_t tail = (_head + _buffer_size) % _capacity_size;
+    const size_t first_part = min(write_size, _capacity_size - tail);
+    data.copy(_buffer.data() + tail, first_part);
+    data.copy(_buffer.data(), write_size - first_part, first_part);
+    _buffer_size += write_size;
 
     return write_size;
 }
@@ -49,7 +56,8 @@ size_t ByteStream::write(const string &data) {
 bool ByteStream::write_char(char datum) {
     if (input_ended() || remaining_capacity() == 0)
         return false;
-    _queue.push_back(datum);
+    _buffer[(_head + _buffer_size) % _capacity_size] = datum;
+    _buffer_size++;
     _written_size++;
     return true;
 }
@@ -68,8 +76,10 @@ string ByteStream::peek_output(const size_t len) const {
     1、确认能取的数据大小
     2、返回队列中该长度的数据
     */
-    size_t pop_size = min(len, _queue.size());
-    return string(_queue.begin(),_queue.begin() + pop_size);
+    size_t pop_size = min(len, _buffer_size);
+    string ret(pop_size, 0);
+    _copy_out(ret.data(), pop_size, nullptr);
+    return ret;
 }
 
 //! \param[in] len bytes will be removed from the output side of the buffer
@@ -77,12 +87,14 @@ void ByteStream::pop_output(const size_t len) {
     /*
     1、确认要弹出的数据大小，从len和队列中取最小的
     2、累计到已读取的总字节数中
-    3、循环弹出队列
+    3、移动读位置_head
     */
-    size_t pop_size = min(len, _queue.size());
+    size_t pop_size = min(len, _buffer_size);
+    if (pop_size == 0)
+        return;
     _read_size += pop_size;
-    for (size_t i = 0; i < pop_size; i++)
-        _queue.pop_front();
+    _head = (_head + pop_size) % _capacity_size;
+    _buffer_size -= pop_size;
 }
 
 //! Read (i.e., copy and then pop) the next "len" bytes of the stream
@@ -99,22 +111,49 @@ std::string ByteStream::read(const size_t len) {
     return data;
 }
 
+//! \param[in] len bytes will be popped and returned
+//! \details Each byte is read once, both to copy it and to sum it (see InternetChecksum::add_copy)
+Buffer ByteStream::read_checksummed(const size_t len) {
+    const size_t read_size = min(len, _buffer_size);
+    string data(read_size, 0);
+    InternetChecksum check;
+    _copy_out(data.data(), read_size, &check);
+    this->pop_output(read_size);
+    return Buffer(move(data), uint16_t(~check.value()));
+}
+
+void ByteStream::_copy_out(char *dst, const size_t len, InternetChecksum *check) const {
+    // 可读数据可能在_buffer末尾折返,分两段复制
+    if (len == 0)
+        return;
+    const size_t first_part = min(len, _capacity_size - _head);
+    const string_view first(_buffer.data() + _head, first_part);
+    const string_view second(_buffer.data(), len - first_part);
+    if (check) {
+        check->add_copy(dst, first);
+        check->add_copy(dst + first_part, second);
+    } else {
+        first.copy(dst, first.size());
+        second.copy(dst + first_part, second.size());
+    }
+}
+
 void ByteStream::end_input() { _end_input = true; }
 
 bool ByteStream::input_ended() const { return _end_input; }
 
-size_t ByteStream::buffer_size() const { return _queue.size(); }
+size_t ByteStream::buffer_size() const { return _buffer_size; }
 
-bool ByteStream::buffer_empty() const { return _queue.empty(); }
+bool ByteStream::buffer_empty() const { return _buffer_size == 0; }
 
 /*
 1、确保写管道中已关闭
 2、并且确保缓冲区中没有数据
 */
-bool ByteStream::eof() const { return _end_input && _queue.empty(); }
+bool ByteStream::eof() const { return _end_input && _buffer_size == 0; }
 
 size_t ByteStream::bytes_written() const { return _written_size; }
 
 size_t ByteStream::bytes_read() const { return _read_size; }
 
-size_t ByteStream::remaining_capacity() const { return _capacity_size - _queue.size(); }
+size_t ByteStream::remaining_capacity() const { return _capacity_size - _buffer_size; }
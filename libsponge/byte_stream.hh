@@ -1,7 +1,9 @@
 #ifndef SPONGE_LIBSPONGE_BYTE_STREAM_HH
 #define SPONGE_LIBSPONGE_BYTE_STREAM_HH
 
-#include <deque>
+#include "buffer.hh"
+#include "util.hh"
+
 #include <string>
 
 //! \brief An in-order byte stream.
@@ -17,7 +19,9 @@ class ByteStream {
     // all, but if any of your tests are taking longer than a second,
     // that's a sign that you probably want to keep exploring
     // different approaches.
-    std::deque<char> _queue;  //用于存储字节流的缓冲区，FIFO队列
+    std::string _buffer;      //用于存储字节流的环形缓冲区,大小为_capacity_size
+    size_t _head;             //下一个可读字节在_buffer中的位置
+    size_t _buffer_size;      //缓冲区中的字节数
     size_t _capacity_size;    //缓冲区总容量
     size_t _written_size;     //已经写入的总字节数
     size_t _read_size;        //已读取的总字节数
@@ -25,6 +29,9 @@ class ByteStream {
     bool _error{};            //标志字节流是否发生错误
     //!< Flag indicating that the stream suffered an error.
 
+    //! Copy the first `len` bytes of the buffer to `dst`, adding them to `check` if it is given
+    void _copy_out(char *dst, const size_t len, InternetChecksum *check) const;
+
   public:
     //! Construct a stream with room for `capacity` bytes.
     ByteStream(const size_t capacity);
@@ -64,6 +71,10 @@ class ByteStream {
     //! \returns a string
     std::string read(const size_t len);
 
+    //! Read the next "len" bytes of the stream, summing them for the Internet checksum as they are copied
+    //! \returns a Buffer that knows its Buffer::cksum_partial()
+    Buffer read_checksummed(const size_t len);
+
     //! \returns `true` if the stream input has ended
     bool input_ended() const;
 
@@ -20,8 +20,11 @@ using namespace std;
 
 //! \param[in] ethernet_address Ethernet (what ARP calls "hardware") address of the interface
 //! \param[in] ip_address IP (what ARP calls "protocol") address of the interface
-NetworkInterface::NetworkInterface(const EthernetAddress &ethernet_address, const Address &ip_address)
-    : _ethernet_address(ethernet_address), _ip_address(ip_address) {
+//! \param[in] pending_limit the number of datagrams that may wait for each next hop being resolved
+NetworkInterface::NetworkInterface(const EthernetAddress &ethernet_address,
+                                   const Address &ip_address,
+                                   const size_t pending_limit)
+    : _pending_limit(pending_limit), _ethernet_address(ethernet_address), _ip_address(ip_address) {
     cerr << "DEBUG: Network interface has Ethernet address " << to_string(_ethernet_address) << " and IP address "
          << ip_address.ip() << "\n";
 }
@@ -33,52 +36,47 @@ NetworkInterface::NetworkInterface(const EthernetAddress &ethernet_address, cons
 void NetworkInterface::send_datagram(const InternetDatagram &dgram, const Address &next_hop) {
     /*
         1、获取下一跳IP地址
-        2、遍历Arp表，如果没有进行arp广播
-        3、如果在已发送未回应的arp列表中没有，在构造arp包，避免5秒内多次发送相同arp包
-        4、构造arp请求、arp操作码、发送端mac地址、发送端ip地址、接收端mac地址-置空，接收端ip地址
-        5、构建以太网帧、填充以太网头
-        6、ARP请求序列化后作为以太网帧的payload
-        7、将填充完毕的以太网帧推入_frames_out通道,等待被传输
-        8、记录当前发送的ARP请求包, key=下一跳IP地址,val=该ARP请求的过期时间
+        2、查Arp表，如果已解析，直接发送
+        3、如果表中没有，新建一个正在查询的条目并进行arp广播(正在查询的不再广播, 避免5秒内多次发送相同arp包)
+        4、将该 ip 包加入该邻居的等待队列中, 队列满则丢弃
     */
+    // step 1
     const uint32_t next_hop_ip = next_hop.ipv4_numeric();
-    const auto &arp_iter = _arp_table.find(next_hop_ip);
-    // 遍历arp表
-    if (arp_iter == _arp_table.end()) {
-        // 遍历等待列表
-        if (_waiting_arp_response_ip_addr.find(next_hop_ip) == _waiting_arp_response_ip_addr.end()) {
-            // 构造arp包
-            ARPMessage arp_request;
-            arp_request.opcode = ARPMessage::OPCODE_REQUEST;
-            arp_request.sender_ethernet_address = _ethernet_address;
-            arp_request.sender_ip_address = _ip_address.ipv4_numeric();
-            arp_request.target_ethernet_address = {};
-            arp_request.target_ip_address = next_hop_ip;
 
-            // 构造以太帧
-            EthernetFrame eth_frame;
-            eth_frame.header() = {
-                                    /*dst*/  ETHERNET_BROADCAST,
-                                    /*src*/  _ethernet_address,
-                                    /*type*/ EthernetHeader::TYPE_ARP,};
-            // arp请求序列化
-            eth_frame.payload() = arp_request.serialize();
-            _frames_out.push(eth_frame);
-            // 记录ARP请求包
-            _waiting_arp_response_ip_addr[next_hop_ip] = _arp_response_default_ttl;
-        }
-        // 将该 ip 包加入等待队列中
-        _waiting_arp_internet_datagrams.push_back({next_hop, dgram});
-    } else {
-        // arp 表中有目标ip-mac对应关系，直接生成以太网帧
-        EthernetFrame eth_frame;
-        eth_frame.header() = {
-                                /*dst*/  arp_iter->second.eth_addr,
-                                /*src*/  _ethernet_address,
-                                /*type*/  EthernetHeader::TYPE_IPv4};
-        eth_frame.payload() = dgram.serialize();
-        _frames_out.push(eth_frame);
+    // step 2
+    ARP_Entry *arp_entry = _arp_table.find(next_hop_ip);
+    if (arp_entry != nullptr and arp_entry->eth_addr.has_value()) {
+        send_ipv4_frame(dgram, *arp_entry);
+        return;
+    }
+
+    // step 3
+    if (arp_entry == nullptr) {
+        arp_entry = &_arp_table.insert_or_assign(next_hop_ip, {});
+        send_arp_request(next_hop_ip, *arp_entry);
+    }
+
+    // step 4
+    if (arp_entry->pending.size() >= _pending_limit) {
+        _pending_drops++;
+        return;
     }
+    arp_entry->pending.push_back(dgram);
+    _pending_datagrams++;
+}
+
+//! \param[in] dgram the IPv4 datagram to be sent
+//! \param[in] neighbor the ARP table entry of the next hop
+void NetworkInterface::send_ipv4_frame(const InternetDatagram &dgram, const ARP_Entry &neighbor) {
+    // 以太网头部对发给同一邻居的帧都一样, 共享条目中预先序列化好的头部, 无需每帧再构造和序列化
+    EthernetFrame eth_frame;
+    eth_frame.set_header({
+                            /*dst*/  neighbor.eth_addr.value(),
+                            /*src*/  _ethernet_address,
+                            /*type*/  EthernetHeader::TYPE_IPv4},
+                         neighbor.eth_header);
+    eth_frame.payload() = dgram.serialize();
+    _frames_out.push(move(eth_frame));
 }
 
 //! \param[in] frame the incoming Ethernet frame
@@ -139,61 +137,85 @@ optional<InternetDatagram> NetworkInterface::recv_frame(const EthernetFrame &fra
         }
         // 无论是请求还是回应，都会更新arp表
         if (is_valid_arp_request || is_valid_arp_response) {
-            _arp_table[src_ip_addr] = {src_eth_addr, _arp_entry_default_ttl};
-
-            for (auto iter = _waiting_arp_internet_datagrams.begin(); iter != _waiting_arp_internet_datagrams.end(); /**/) {
-                if (iter->first.ipv4_numeric() == src_ip_addr) {
-                    // 重新发送
-                    send_datagram(iter->second, iter->first);
-                    iter = _waiting_arp_internet_datagrams.erase(iter);                
-                } else {
-                    ++iter;                    
-                }
+            const uint64_t expiry = _time_ms + _arp_entry_default_ttl;
+            ARP_Entry *entry = _arp_table.find(src_ip_addr);
+            if (entry == nullptr) {
+                entry = &_arp_table.insert_or_assign(src_ip_addr, {});
+            }
+            if (entry->eth_addr != src_eth_addr) {
+                entry->eth_addr = src_eth_addr;
+                // 地址变化时才重新生成以太网头部
+                entry->eth_header =
+                    EthernetHeader{src_eth_addr, _ethernet_address, EthernetHeader::TYPE_IPv4}.serialize();
             }
-            _waiting_arp_response_ip_addr.erase(src_ip_addr);
+            entry->expiry = expiry;
+            _arp_entry_timers.emplace(expiry, src_ip_addr);
+
+            // 一次性发出等待该邻居的报文(按到达顺序), 地址已知, 无需再查表
+            for (const auto &dgram : entry->pending) {
+                send_ipv4_frame(dgram, *entry);
+            }
+            _pending_datagrams -= entry->pending.size();
+            entry->pending.clear();
+            entry->pending.shrink_to_fit();
         }
     }
     return nullopt;
 }
 
+//! \param[in] target_ip the IP address to ask for the Ethernet address of
+//! \param[in] entry the ARP table entry of `target_ip`, which is being resolved
+void NetworkInterface::send_arp_request(const uint32_t target_ip, ARP_Entry &entry) {
+    // 构造arp包
+    ARPMessage arp_request;
+    arp_request.opcode = ARPMessage::OPCODE_REQUEST;
+    arp_request.sender_ethernet_address = _ethernet_address;
+    arp_request.sender_ip_address = _ip_address.ipv4_numeric();
+    arp_request.target_ethernet_address = {};
+    arp_request.target_ip_address = target_ip;
+
+    // 构造以太帧
+    EthernetFrame eth_frame;
+    eth_frame.header() = {
+                            /*dst*/  ETHERNET_BROADCAST,
+                            /*src*/  _ethernet_address,
+                            /*type*/ EthernetHeader::TYPE_ARP,};
+    // arp请求序列化
+    eth_frame.payload() = arp_request.serialize();
+    _frames_out.push(eth_frame);
+
+    // 记录ARP请求的重发时刻
+    entry.expiry = _time_ms + _arp_response_default_ttl;
+    _arp_request_timers.emplace(entry.expiry, target_ip);
+}
+
 //! \param[in] ms_since_last_tick the number of milliseconds since the last call to this method
 void NetworkInterface::tick(const size_t ms_since_last_tick) {
     /*
-        1、循环清理arp_table中过期的条目
-        2、循环清理arp等待队列中过期条目，并且重新发送arp请求
+        1、推进时间
+        2、处理到期的arp条目定时器, 删除过期的条目(条目刷新过则定时器已作废)
+        3、处理到期的arp请求定时器, 仍未收到响应的重新发送arp请求
     */
-   for (auto iter = _arp_table.begin(); iter != _arp_table.end(); /**/) {
-        if (iter->second.ttl <= ms_since_last_tick) {
-            iter = _arp_table.erase(iter);
-        } else {
-            iter->second.ttl -= ms_since_last_tick;
-            ++iter;
+    // step 1
+    _time_ms += ms_since_last_tick;
+
+    // step 2
+    while (not _arp_entry_timers.empty() and _arp_entry_timers.front().first <= _time_ms) {
+        const auto [expiry, ip_addr] = _arp_entry_timers.front();
+        _arp_entry_timers.pop();
+        const ARP_Entry *entry = _arp_table.find(ip_addr);
+        if (entry != nullptr and entry->eth_addr.has_value() and entry->expiry == expiry) {
+            _arp_table.erase(ip_addr);
         }
-   }
-
-   for (auto iter = _waiting_arp_response_ip_addr.begin(); iter != _waiting_arp_response_ip_addr.end(); /**/) {
-        if (iter->second <= ms_since_last_tick) {
-            // 重新构造arp请求包,广播包
-            ARPMessage arp_request;
-            arp_request.opcode = ARPMessage::OPCODE_REQUEST;
-            arp_request.sender_ethernet_address = _ethernet_address;
-            arp_request.sender_ip_address = _ip_address.ipv4_numeric();
-            arp_request.target_ethernet_address = {};
-            arp_request.target_ip_address = iter->first;
-
-            // 构造以太帧
-            EthernetFrame eth_frame;
-            eth_frame.header() = {
-                                    /*dst*/  ETHERNET_BROADCAST,
-                                    /*src*/  _ethernet_address,
-                                    /*type*/ EthernetHeader::TYPE_ARP};
-            eth_frame.payload() = arp_request.serialize();
-            _frames_out.push(eth_frame);
+    }
 
-            iter->second = _arp_response_default_ttl;
-        } else {
-            iter->second -= ms_since_last_tick;
-            ++iter;
+    // step 3
+    while (not _arp_request_timers.empty() and _arp_request_timers.front().first <= _time_ms) {
+        const auto [resend_at, ip_addr] = _arp_request_timers.front();
+        _arp_request_timers.pop();
+        ARP_Entry *entry = _arp_table.find(ip_addr);
+        if (entry != nullptr and not entry->eth_addr.has_value() and entry->expiry == resend_at) {
+            send_arp_request(ip_addr, *entry);
         }
-   }
+    }
 }
@@ -2,13 +2,15 @@
 #define SPONGE_LIBSPONGE_NETWORK_INTERFACE_HH
 
 #include "ethernet_frame.hh"
+#include "flat_ip_map.hh"
 #include "tcp_over_ip.hh"
 #include "tun.hh"
 
-#include <list>
-#include <map>
+#include <cstdint>
 #include <optional>
 #include <queue>
+#include <utility>
+#include <vector>
 
 //! \brief A "network interface" that connects IP (the internet layer, or network layer)
 //! with Ethernet (the network access layer, or link layer).
@@ -33,23 +35,37 @@
 //! and learns or replies as necessary.
 class NetworkInterface {
   private:
-    //! ARP 条目, 该结构体包括，EthernetAddress类型的以太网地址和存活时间ttl
+    //! ARP 条目: 已解析的邻居, 或正在查询(已发送ARP请求, 还没有响应)的邻居
     struct ARP_Entry {
-        EthernetAddress eth_addr;
-        size_t ttl;
+        std::optional<EthernetAddress> eth_addr{};  //!< 以太网地址, 正在查询时为空
+        Buffer eth_header{};  //!< 已解析: 发给该邻居的IPv4帧的以太网头部, 预先序列化好, 由这些帧共享
+        uint64_t expiry{0};  //!< 已解析: 过期时刻; 正在查询: 重发ARP请求的时刻 (绝对时间, 见_time_ms)
+        std::vector<InternetDatagram> pending{};  //!< 正在查询时, 等待发给该邻居的 IP 报文(按到达顺序)
     };
-    //! ARP 表
-    std::map<uint32_t, ARP_Entry> _arp_table{};
+    //! ARP 表: 开放寻址的扁平哈希表, 查找为O(1)
+    FlatIpMap<ARP_Entry> _arp_table{};
     // 默认 ARP 条目过期时间 30s
     const size_t _arp_entry_default_ttl = 30 * 1000;
-
-    //! 正在查询的 ARP 报文。如果发送了 ARP 请求后，在过期时间内没有返回响应，则丢弃等待的 IP 报文
-    std::map<uint32_t, size_t> _waiting_arp_response_ip_addr{};
-    // 默认 ARP 请求过期时间 5s
+    // 默认 ARP 请求过期时间 5s, 在过期时间内没有返回响应则重发请求
     const size_t _arp_response_default_ttl = 5 * 1000;
 
-    //! 等待 ARP 报文返回的待处理 IP 报文
-    std::list<std::pair<Address, InternetDatagram>> _waiting_arp_internet_datagrams{};
+    //! 每个正在查询的邻居最多等待的 IP 报文数, 超过时丢弃新到的报文
+    size_t _pending_limit;
+    //! 正在等待 ARP 响应的 IP 报文数
+    size_t _pending_datagrams{0};
+    //! 因为等待队列满而丢弃的 IP 报文数
+    uint64_t _pending_drops{0};
+
+    //! \brief 定时器: (到期时刻, IP地址), 按到期时刻排列
+    //! \details 同一种定时器的时长都一样, 后设置的一定后到期, 所以先进先出的队列就是精确的定时器轮,
+    //! tick() 只需处理到期的定时器。条目刷新时不删除旧定时器, 它到期时与条目的时刻不符, 忽略即可
+    //!@{
+    std::queue<std::pair<uint64_t, uint32_t>> _arp_entry_timers{};
+    std::queue<std::pair<uint64_t, uint32_t>> _arp_request_timers{};
+    //!@}
+
+    //! 自创建以来经过的时间(毫秒)
+    uint64_t _time_ms{0};
 
     //! Ethernet (known as hardware, network-access-layer, or link-layer) address of the interface
     // 当前虚拟网卡的MAC地址
@@ -64,9 +80,21 @@ class NetworkInterface {
     // 网络适配器只需要把组装好的以太网帧丢入这个队列即可
     std::queue<EthernetFrame> _frames_out{};
 
+    //! 广播查询 `target_ip` 的 ARP 请求, 并设置其条目 `entry` 重发请求的时刻和定时器
+    void send_arp_request(const uint32_t target_ip, ARP_Entry &entry);
+
+    //! 把 IP 报文封装成以太网帧发给已解析的邻居 `neighbor`
+    void send_ipv4_frame(const InternetDatagram &dgram, const ARP_Entry &neighbor);
+
   public:
+    //! Datagrams that may wait for each unresolved next hop, by default
+    static constexpr size_t DEFAULT_PENDING_LIMIT = 100;
+
     //! \brief Construct a network interface with given Ethernet (network-access-layer) and IP (internet-layer) addresses
-    NetworkInterface(const EthernetAddress &ethernet_address, const Address &ip_address);
+    //! \param[in] pending_limit is how many datagrams may wait for each next hop being resolved; more are dropped
+    NetworkInterface(const EthernetAddress &ethernet_address,
+                     const Address &ip_address,
+                     const size_t pending_limit = DEFAULT_PENDING_LIMIT);
 
     //! \brief Access queue of Ethernet frames awaiting transmission
     std::queue<EthernetFrame> &frames_out() { return _frames_out; }
@@ -86,6 +114,12 @@ class NetworkInterface {
 
     //! \brief Called periodically when time elapses
     void tick(const size_t ms_since_last_tick);
+
+    //! Datagrams waiting for their next hop's Ethernet address
+    size_t pending_datagrams() const { return _pending_datagrams; }
+
+    //! Datagrams dropped because too many were already waiting for their next hop's Ethernet address
+    uint64_t pending_drops() const { return _pending_drops; }
 };
 
 #endif  // SPONGE_LIBSPONGE_NETWORK_INTERFACE_HH
@@ -1,6 +1,14 @@
 #include "router.hh"
 
+#include "util.hh"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <iostream>
+#include <numeric>
+#include <string_view>
+#include <utility>
 
 using namespace std;
 
@@ -20,6 +28,88 @@ void DUMMY_CODE(Targs &&.../* unused */) {}
 
 using namespace std;
 
+//! The `length` high-order bits of `prefix` (the rest cleared)
+static uint32_t masked(const uint32_t prefix, const uint8_t length) {
+    return length == 0 ? 0 : prefix & (0xffff'ffffU << (32 - length));
+}
+
+unique_ptr<Router::RouteTable> Router::make_table(const LPM engine) {
+    auto table = make_unique<RouteTable>();
+    if (engine == LPM::Dir24_8) {
+        table->prefixes.emplace<Dir24_8>();
+    }
+    return table;
+}
+
+//! A random 64-bit seed
+static uint64_t random_seed() {
+    auto rng = get_random_generator();
+    return uint64_t(rng()) << 32 | rng();
+}
+
+//! \brief A hash of the flow a datagram belongs to: its addresses and protocol, and, for TCP and UDP,
+//! its ports (unless it is a fragment, since only the first fragment has them)
+static uint64_t flow_hash(const InternetDatagram &dgram, const uint64_t seed) {
+    const IPv4Header &header = dgram.header();
+    uint64_t ports = header.proto;
+    if ((header.proto == IPv4Header::PROTO_TCP or header.proto == IPv4Header::PROTO_UDP) and not header.mf and
+        header.offset == 0 and not dgram.payload().buffers().empty()) {
+        const string_view segment = dgram.payload().buffers().front().str();
+        if (segment.size() >= 4) {
+            ports |= uint64_t(uint8_t(segment[0])) << 40 | uint64_t(uint8_t(segment[1])) << 32 |
+                     uint64_t(uint8_t(segment[2])) << 24 | uint64_t(uint8_t(segment[3])) << 16;
+        }
+    }
+
+    // mix with the finalizer of SplitMix64, so that every input bit affects every output bit
+    uint64_t hash = (uint64_t(header.src) << 32 | header.dst) ^ seed;
+    hash = (hash ^ (hash >> 30) ^ ports) * 0xbf58'476d'1ce4'e5b9;
+    hash = (hash ^ (hash >> 27)) * 0x94d0'49bb'1331'11eb;
+    return hash ^ (hash >> 31);
+}
+
+Router::Router(const LPM engine, const optional<size_t> route_cache_sets)
+    : _hash_seed(random_seed())
+    , _engine(engine)
+    , _routes(make_table(engine))
+    , _route_cache_sets(route_cache_sets.value_or(engine == LPM::Poptrie ? DEFAULT_ROUTE_CACHE_SETS : 0))
+    , _route_cache(_route_cache_sets) {}
+
+//! \param[in] route_prefix The prefix
+//! \param[in] prefix_length The prefix's length
+//! \param[in] next_hops The route's next hops
+//! \param[in] old The route this one replaces, if any
+Router::RouterTableEntry Router::make_entry(const uint32_t route_prefix,
+                                            const uint8_t prefix_length,
+                                            const vector<NextHop> &next_hops,
+                                            const RouterTableEntry *old) {
+    if (next_hops.empty()) {
+        throw runtime_error("Router: a route needs a next hop");
+    }
+    if (next_hops.size() == 1) {
+        return {route_prefix, prefix_length, next_hops, {}};
+    }
+
+    vector<unsigned> weights;
+    for (const auto &hop : next_hops) {
+        weights.push_back(hop.weight);
+    }
+    if (not old) {
+        return {route_prefix, prefix_length, next_hops, ResilientHashTable(weights)};
+    }
+
+    // 每个新的下一跳在旧路由中的位置, 旧路由只有一个下一跳时它拥有所有的桶
+    vector<size_t> previous;
+    for (const auto &hop : next_hops) {
+        const auto same = find_if(old->next_hops.begin(), old->next_hops.end(), [&](const NextHop &old_hop) {
+            return old_hop.address == hop.address and old_hop.interface_num == hop.interface_num;
+        });
+        previous.push_back(same == old->next_hops.end() ? ResilientHashTable::NEW : same - old->next_hops.begin());
+    }
+    const ResilientHashTable old_flow_hops = old->flow_hops ? *old->flow_hops : ResilientHashTable({1});
+    return {route_prefix, prefix_length, next_hops, ResilientHashTable(old_flow_hops, weights, previous)};
+}
+
 //! \param[in] route_prefix The "up-to-32-bit" IPv4 address prefix to match the datagram's destination address against
 //! \param[in] prefix_length For this route to be applicable, how many high-order (most-significant) bits of the route_prefix will need to match the corresponding bits of the datagram's destination address?
 //! \param[in] next_hop The IP address of the next hop. Will be empty if the network is directly attached to the router (in which case, the next hop address should be the datagram's final destination).
@@ -31,58 +121,342 @@ void Router::add_route(const uint32_t route_prefix,
         cerr << "DEBUG: adding route " << Address::from_ipv4_numeric(route_prefix).ip() << "/" << int(prefix_length)
          << " => " << (next_hop.has_value() ? next_hop->ip() : "(direct)") << " on interface " << interface_num << "\n";
 
-        _router_table.push_back({route_prefix, prefix_length, next_hop, interface_num});
+        update_routes({{true, route_prefix, prefix_length, next_hop, interface_num}});
+}
+
+//! \param[in] route_prefix The "up-to-32-bit" IPv4 address prefix to match the datagram's destination address against
+//! \param[in] prefix_length How many high-order bits of the route_prefix must match
+//! \param[in] next_hops The next hops to spread the prefix's flows over
+void Router::add_multipath_route(const uint32_t route_prefix,
+                                 const uint8_t prefix_length,
+                                 const vector<NextHop> &next_hops) {
+    update_routes({{true, route_prefix, prefix_length, {}, 0, next_hops}});
 }
 
-//! \param[in] dgram The datagram to be routed
-void Router::route_one_datagram(InternetDatagram &dgram) {
+//! \param[in] route_prefix The prefix whose routes to remove (its bits past `prefix_length` are ignored)
+//! \param[in] prefix_length The prefix's length
+void Router::remove_route(const uint32_t route_prefix, const uint8_t prefix_length) {
+    update_routes({{false, route_prefix, prefix_length}});
+}
+
+//! \param[in] changes The changes to make, in order
+void Router::update_routes(const vector<RouteChange> &changes) {
     /*
-        1、从数据报头部获取目的ip信息
-        2、初始化最大路由条目
-        3、循环找匹配路由规则：如果前缀全为0，说明匹配所有地址，或者将路由前缀和目的地址异或，再右移32-子网掩码长度，如果都为0说明成功匹配
-        4、如果当前最大路由条目是初始的，或者当前最大路由条目的长度小于新匹配的路由规则长度，更新最长匹配规则
-        5、如果存在最匹配的，并且数据包仍然存活，则将其转发
-        6、获取下一个的地址和网络接口
-        7、数据报转发
+        1、在当前快照的副本上按顺序做出修改
+        2、只有添加时, 在查找表上增量插入新条目: 优先复用已没有读者的旧快照(见RcuSnapshot::recycle),
+           它的查找表只缺它之后添加的条目, 否则复制当前的查找表(DIR-24-8要复制64 MiB);
+           有删除时(两种查找表都不支持删除), 用剩下的条目重建查找表
+        3、原子地发布新快照(代数加一, 各目的地址缓存见到后作废其中的结果),
+           旧快照等正在使用它的route()结束后再释放
     */
-    const uint32_t dst_ip_addr = dgram.header().dst;
-    auto max_matched_entry = _router_table.end();
+    const RouteTable &current = _routes.writer_view();
+
+    // step 1
+    vector<RouterTableEntry> entries = current.entries;
+    bool removed = false;
+    for (const auto &change : changes) {
+        if (change.add and change.next_hops.empty()) {
+            entries.push_back(make_entry(
+                change.route_prefix, change.prefix_length, {{change.next_hop, change.interface_num}}, nullptr));
+            continue;
+        }
 
-    for (auto iter = _router_table.begin(); iter != _router_table.end(); iter++) {
-        if (iter->prefix_length == 0 || (iter->route_prefix ^ dst_ip_addr) >> (32 - iter->prefix_length) == 0) {
-            if (max_matched_entry == _router_table.end() || max_matched_entry->prefix_length < iter->prefix_length) {
-                max_matched_entry = iter;
+        // 删除该前缀的路由; 多路径路由则取代其中生效的(第一条)那条, 位置不变
+        const uint32_t prefix = masked(change.route_prefix, change.prefix_length);
+        vector<RouterTableEntry> kept;
+        bool replaced = false;
+        for (const auto &entry : entries) {
+            if (entry.prefix_length != change.prefix_length or
+                masked(entry.route_prefix, entry.prefix_length) != prefix) {
+                kept.push_back(entry);
+            } else if (change.add and not replaced) {
+                kept.push_back(make_entry(change.route_prefix, change.prefix_length, change.next_hops, &entry));
+                replaced = true;
+            } else {
+                removed = true;
             }
         }
+        if (change.add and not replaced) {
+            kept.push_back(make_entry(change.route_prefix, change.prefix_length, change.next_hops, nullptr));
+        }
+        entries = move(kept);
+    }
+
+    // step 2
+    unique_ptr<RouteTable> next = removed ? nullptr : _routes.recycle();
+    // 读者每次route()只持有快照很短时间, 稍等它放下上一个快照, 比复制整个查找表快得多
+    const auto give_up = chrono::steady_clock::now() + RECYCLE_WAIT;
+    while (not removed and not next and _routes.retired() > 0 and chrono::steady_clock::now() < give_up) {
+        this_thread::yield();
+        next = _routes.recycle();
     }
+    size_t first_new = 0;
+    if (removed) {
+        next = make_table(_engine);
+        _rebuilt_generation = current.generation + 1;
+    } else if (next and next->generation >= _rebuilt_generation) {
+        // 自它以来只添加过条目(或原位替换), 它的条目是新条目的前缀
+        first_new = next->entries.size();
+    } else {
+        next = make_unique<RouteTable>(RouteTable{0, {}, current.prefixes});
+        first_new = current.entries.size();
+    }
+    for (size_t i = first_new; i < entries.size(); i++) {
+        visit([&](auto &prefixes) { prefixes.insert(entries[i].route_prefix, entries[i].prefix_length, i); },
+              next->prefixes);
+    }
+    visit(
+        [](auto &prefixes) {
+            if (prefixes.stale()) {
+                prefixes.build();
+            }
+        },
+        next->prefixes);
+    next->entries = move(entries);
+
+    // step 3
+    next->generation = current.generation + 1;
+    _routes.publish(move(next));
+}
+
+//! \param[in] table The routes to route by
+//! \param[in] cache The destination cache of the calling thread
+//! \param[in] batch The datagrams to be routed (at most ROUTE_BATCH)
+//! \param[in] send Sends a datagram from an interface to a next hop
+template <typename SendT>
+void Router::route_batch(const RouteTable &table,
+                         DestinationCache &cache,
+                         vector<InternetDatagram> &batch,
+                         SendT &&send) {
+    /*
+        1、从每个数据报头部获取目的ip信息
+        2、先查目的地址缓存, 未命中的再在Poptrie(或DIR-24-8表)中一起查找最长匹配的路由条目,
+           并放入缓存 (原先的线性扫描见LinearPrefixTable)
+        3、选出下一跳(多路径路由按流的哈希选), 按出接口分组,
+           同一接口的数据报连续发送(保持它们原来的顺序)
+        4、如果存在最匹配的，并且数据包仍然存活，则将其转发
+    */
+    const size_t count = batch.size();
+
+    // step 1, 只读访问头部,以免数据报丢弃已知正确的校验和(见IPv4Datagram::header)
+    array<uint32_t, ROUTE_BATCH> dst_ip_addrs{};
+    for (size_t i = 0; i < count; i++) {
+        dst_ip_addrs[i] = as_const(batch[i]).header().dst;
+    }
+
+    // step 2
+    array<optional<uint32_t>, ROUTE_BATCH> max_matched_entries{};
+    array<size_t, ROUTE_BATCH> missed{};
+    cache.validate(table.generation);
+    const size_t misses = cache.lookup(dst_ip_addrs.data(), max_matched_entries.data(), missed.data(), count);
+    array<uint32_t, ROUTE_BATCH> missed_addrs{};
+    for (size_t k = 0; k < misses; k++) {
+        missed_addrs[k] = dst_ip_addrs[missed[k]];
+    }
+    if (misses > 0) {
+        array<optional<uint32_t>, ROUTE_BATCH> found{};
+        visit([&](const auto &prefixes) { prefixes.lookup(missed_addrs.data(), found.data(), misses); },
+              table.prefixes);
+        for (size_t k = 0; k < misses; k++) {
+            max_matched_entries[missed[k]] = found[k];
+            cache.insert(missed_addrs[k], found[k]);
+        }
+    }
+
+    // step 3, 没有匹配的排在最后(反正要丢弃)
+    array<const NextHop *, ROUTE_BATCH> hops{};
+    for (size_t i = 0; i < count; i++) {
+        if (max_matched_entries[i].has_value()) {
+            const RouterTableEntry &entry = table.entries[max_matched_entries[i].value()];
+            hops[i] = &entry.next_hops[entry.flow_hops ? entry.flow_hops->select(flow_hash(batch[i], _hash_seed)) : 0];
+        }
+    }
+    const auto interface_of = [&](const size_t i) { return hops[i] ? hops[i]->interface_num : _interfaces.size(); };
+    array<uint8_t, ROUTE_BATCH> order{};
+    iota(order.begin(), order.begin() + count, 0);
+    stable_sort(order.begin(), order.begin() + count, [&](const uint8_t a, const uint8_t b) {
+        return interface_of(a) < interface_of(b);
+    });
+
+    // step 4, ttl在数据包头部
+    // TTL减一时增量更新校验和(RFC 1624),无需重新计算整个头部
+    for (size_t k = 0; k < count; k++) {
+        InternetDatagram &dgram = batch[order[k]];
+        const NextHop *hop = hops[order[k]];
+        if (not hop || as_const(dgram).header().ttl <= 1) {
+            continue;  // 其他情况丢弃
+        }
 
-    // step 5, ttl在数据包头部
-    if (max_matched_entry != _router_table.end() && dgram.header().ttl-- > 1) {
-        const optional <Address> next_hop = max_matched_entry->next_hop;
-        AsyncNetworkInterface &interface = _interfaces[max_matched_entry->interface_idx];
+        dgram.decrement_ttl();
+        const optional <Address> &next_hop = hop->address;
 
         // 如果有下一跳进行转发
         if (next_hop.has_value()) {
-            interface.send_datagram(dgram, next_hop.value());
+            send(hop->interface_num, dgram, next_hop.value());
         } else {
             // 目的主机和当前主机在同一局域中
-            interface.send_datagram(dgram, Address::from_ipv4_numeric(dst_ip_addr));
+            send(hop->interface_num, dgram, Address::from_ipv4_numeric(dst_ip_addrs[order[k]]));
         }
     }
-    // 其他情况丢弃
-
 }
 
 void Router::route() {
+    if (_running) {
+        throw runtime_error("Router: route() called while the workers are running");
+    }
+
+    // 取得当前路由表快照(无锁), 路由期间即使路由被修改它也保持有效
+    const auto table = _routes.read();
+
     // Go through all the interfaces, and route every incoming datagram to its proper outgoing interface.
     // &是引用，可以直接修改_interfaces容器中的元素
+    // 每次从队列中取出最多ROUTE_BATCH个数据报一起路由
+    const auto send = [&](const size_t out, InternetDatagram &dgram, const Address &next_hop) {
+        _interfaces[out].send_datagram(dgram, next_hop);
+    };
     for (auto &interface : _interfaces) {
         auto &queue = interface.datagrams_out();
-        while (not queue.empty())
-        {
-            route_one_datagram(queue.front());
-            queue.pop();
+        while (not queue.empty()) {
+            while (not queue.empty() and _batch.size() < ROUTE_BATCH) {
+                _batch.push_back(move(queue.front()));
+                queue.pop();
+            }
+            route_batch(*table, _route_cache, _batch, send);
+            _batch.clear();
+        }
+    }
+}
+
+uint64_t Router::route_cache_hits() const {
+    uint64_t hits = _route_cache.hits();
+    for (const auto &worker : _workers) {
+        hits += worker->route_cache.hits();
+    }
+    return hits;
+}
+
+uint64_t Router::route_cache_misses() const {
+    uint64_t misses = _route_cache.misses();
+    for (const auto &worker : _workers) {
+        misses += worker->route_cache.misses();
+    }
+    return misses;
+}
+
+size_t Router::lpm_memory_usage() const {
+    const auto table = _routes.read();
+    return visit([](const auto &prefixes) { return prefixes.memory_usage(); }, table->prefixes);
+}
+
+void Router::start_workers(const size_t ring_capacity) {
+    if (_running) {
+        throw runtime_error("Router: workers already running");
+    }
+    _workers.clear();
+    for (size_t i = 0; i < _interfaces.size(); i++) {
+        _workers.push_back(make_unique<Worker>(ring_capacity, _route_cache_sets));
+    }
+    // 所有工作线程的环都建好后再启动, 它们可能立刻互相转发
+    _running = true;
+    for (size_t i = 0; i < _workers.size(); i++) {
+        _workers[i]->thread = thread([this, i] { run_worker(i); });
+    }
+}
+
+void Router::stop_workers() {
+    _running = false;
+    for (auto &worker : _workers) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
         }
     }
 }
 
+bool Router::deliver_frame(const size_t interface_num, EthernetFrame &&frame) {
+    return _workers.at(interface_num)->inbound.push(move(frame));
+}
+
+optional<EthernetFrame> Router::collect_frame(const size_t interface_num) {
+    return _workers.at(interface_num)->outbound.pop();
+}
+
+uint64_t Router::egress_drops() const {
+    uint64_t drops = 0;
+    for (const auto &worker : _workers) {
+        drops += worker->egress_drops;
+    }
+    return drops;
+}
+
+//! \param[in] interface_num The interface this worker owns
+void Router::run_worker(const size_t interface_num) {
+    /*
+        1、接收送达本接口的帧(ARP请求和应答也在这里处理)
+        2、成批路由收到的数据报, 放入出接口工作线程的egress环(环满则丢弃)
+        3、发送其他工作线程路由到本接口的数据报(需要时由本线程发ARP请求)
+        4、把本接口发出的帧放入outbound环
+        5、按实际经过的时间推进本接口的ARP计时
+    */
+    Worker &worker = *_workers[interface_num];
+    AsyncNetworkInterface &interface = _interfaces[interface_num];
+    vector<InternetDatagram> batch;
+    const auto hand_over = [&](const size_t out, InternetDatagram &dgram, const Address &next_hop) {
+        if (not _workers[out]->egress.push({move(dgram), next_hop})) {
+            _workers[out]->egress_drops++;
+        }
+    };
+    auto last_tick = chrono::steady_clock::now();
+
+    while (_running.load(memory_order_acquire)) {
+        bool busy = false;
+
+        // step 1
+        for (size_t i = 0; i < ROUTE_BATCH; i++) {
+            auto frame = worker.inbound.pop();
+            if (not frame) {
+                break;
+            }
+            interface.recv_frame(*frame);
+            busy = true;
+        }
+
+        // step 2
+        auto &queue = interface.datagrams_out();
+        if (not queue.empty()) {
+            const auto table = _routes.read();
+            while (not queue.empty()) {
+                while (not queue.empty() and batch.size() < ROUTE_BATCH) {
+                    batch.push_back(move(queue.front()));
+                    queue.pop();
+                }
+                route_batch(*table, worker.route_cache, batch, hand_over);
+                batch.clear();
+            }
+            busy = true;
+        }
+
+        // step 3
+        while (auto egress = worker.egress.pop()) {
+            interface.send_datagram(egress->dgram, egress->next_hop);
+            busy = true;
+        }
+
+        // step 4, outbound环满时留在frames_out中下次再放
+        auto &frames = interface.frames_out();
+        while (not frames.empty() and worker.outbound.push(move(frames.front()))) {
+            frames.pop();
+        }
+
+        // step 5
+        const auto now = chrono::steady_clock::now();
+        const auto elapsed = chrono::duration_cast<chrono::milliseconds>(now - last_tick);
+        if (elapsed.count() > 0) {
+            interface.tick(elapsed.count());
+            last_tick += elapsed;
+        }
+
+        if (not busy) {
+            this_thread::yield();
+        }
+    }
+}
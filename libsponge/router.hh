@@ -1,10 +1,23 @@
 #ifndef SPONGE_LIBSPONGE_ROUTER_HH
 #define SPONGE_LIBSPONGE_ROUTER_HH
 
+#include "destination_cache.hh"
+#include "dir_24_8.hh"
+#include "mpsc_ring.hh"
 #include "network_interface.hh"
+#include "poptrie.hh"
+#include "rcu_snapshot.hh"
+#include "resilient_hash_table.hh"
+#include "spsc_ring.hh"
 
+#include <atomic>
+#include <chrono>
+#include <memory>
 #include <optional>
 #include <queue>
+#include <stdexcept>
+#include <thread>
+#include <variant>
 
 //! \brief A wrapper for NetworkInterface that makes the host-side
 //! interface asynchronous: instead of returning received datagrams
@@ -44,31 +57,137 @@ class AsyncNetworkInterface : public NetworkInterface {
 //! performs longest-prefix-match routing between them.
 // 需实现一下 IP 最长匹配并将数据包转发即可
 class Router {
+  public:
+    //! Longest-prefix-match engines
+    enum class LPM {
+        Poptrie,  //!< A compressed trie (see Poptrie): small, but rebuilt whole on every change to the routes
+        Dir24_8   //!< A DIR-24-8 table (see Dir24_8): two memory accesses at most, but 64 MiB however few routes
+    };
+
+    //! One of the next hops of a route
+    struct NextHop {
+        std::optional<Address> address;  //!< Empty if the network is directly attached
+        size_t interface_num;            //!< The interface to send out on
+        unsigned weight{1};              //!< The next hop's share of the route's flows, relative to the others
+    };
+
+    //! A change to the routes: a route to add, or (if `add` is false) a prefix whose routes to remove
+    struct RouteChange {
+        bool add;
+        uint32_t route_prefix;
+        uint8_t prefix_length;
+        std::optional<Address> next_hop{};
+        size_t interface_num{0};
+        //! \brief If not empty, a multipath route to add instead (`next_hop` and `interface_num` are ignored)
+        //! \details It replaces the prefix's routes, and the flows of next hops that it keeps stay on them
+        std::vector<NextHop> next_hops{};
+    };
+
+  private:
     //! The router's collection of network interfaces
     // 路由器的网络接口集合
     std::vector<AsyncNetworkInterface> _interfaces{};
 
-    //! Send a single datagram from the appropriate outbound interface to the next hop,
-    //! as specified by the route with the longest prefix_length that matches the
-    //! datagram's destination address.
-    // 路由一个数据报
-    void route_one_datagram(InternetDatagram &dgram);
+    //! Datagrams routed together by route_batch()
+    static constexpr size_t ROUTE_BATCH = 32;
+
+    // route_batch()的数据报, 复用以免每批重新分配
+    std::vector<InternetDatagram> _batch{};
 
     // 路由表的条目
     struct RouterTableEntry {
-        const uint32_t route_prefix;            // 目标网络的前缀
-        const uint8_t prefix_length;            // 子网掩码长度
-        const std::optional<Address> next_hop;  // 下一条地址，可选
-        const size_t interface_idx;             // 负责转发数据的接口编号
+        const uint32_t route_prefix;                        // 目标网络的前缀
+        const uint8_t prefix_length;                        // 子网掩码长度
+        const std::vector<NextHop> next_hops;               // 下一跳(地址可选)及其接口编号
+        const std::optional<ResilientHashTable> flow_hops;  // 多于一个下一跳时: 按流的哈希选择下一跳
+    };
+
+    //! An entry for a route; if it replaces `old`, the flows of the next hops they share stay on them
+    static RouterTableEntry make_entry(const uint32_t route_prefix,
+                                       const uint8_t prefix_length,
+                                       const std::vector<NextHop> &next_hops,
+                                       const RouterTableEntry *old);
+
+    // 流哈希的种子, 每个路由器不同, 以免串联的路由器都把同样的流分到同一条路径上
+    uint64_t _hash_seed;
+
+    // 路由表快照: 发布后不再修改, 修改路由时复制一份改好再整体替换(见RcuSnapshot)
+    struct RouteTable {
+        uint64_t generation{0};  // 每次修改路由加一, 目的地址缓存据此作废旧的查找结果
+        std::vector<RouterTableEntry> entries{};
+        // 最长前缀匹配: 从目的地址查到entries中的条目下标, 查找耗时与路由表大小无关
+        std::variant<Poptrie, Dir24_8> prefixes{};
+    };
+
+    LPM _engine;
+    RcuSnapshot<RouteTable> _routes;
+    // 修改路由时, 最多等待这么久让route()放下上一个快照以便复用它(复制DIR-24-8的查找表要几十毫秒)
+    static constexpr std::chrono::microseconds RECYCLE_WAIT{1000};
+    // 最近一次重建查找表的路由表代数: 在它之前的快照, 查找表与现在的条目对不上, 不能复用
+    uint64_t _rebuilt_generation{0};
+
+    // 目的地址缓存(见DestinationCache)的组数, 以及route()用的缓存; 每个工作线程另有自己的缓存
+    size_t _route_cache_sets;
+    DestinationCache _route_cache;
+
+    //! An empty route table, which looks up with `engine`
+    static std::unique_ptr<RouteTable> make_table(const LPM engine);
+
+    //! Route each of a batch of datagrams by `table`, looking destinations up in `cache` first, and
+    //! hand each that survives to `send(interface_num, dgram, next_hop)`
+    // 成批路由数据报: 先一起查表(预取让缓存未命中相互重叠),再按出接口成批发送
+    template <typename SendT>
+    void route_batch(const RouteTable &table,
+                     DestinationCache &cache,
+                     std::vector<InternetDatagram> &batch,
+                     SendT &&send);
+
+    // 并行转发: 每个接口一个工作线程, 由它独占该接口(包括ARP状态)
+    struct Egress {
+        InternetDatagram dgram;
+        Address next_hop;
+    };
+    struct Worker {
+        MPSCRing<EthernetFrame> inbound;   // 送达该接口的帧(任意线程放入)
+        MPSCRing<Egress> egress;           // 其他工作线程路由到该接口、等它发送的数据报
+        SPSCRing<EthernetFrame> outbound;  // 该接口发出的帧(由一个外部线程取走)
+        std::atomic<uint64_t> egress_drops{0};
+        DestinationCache route_cache;
+        std::thread thread{};
+
+        Worker(const size_t capacity, const size_t route_cache_sets)
+            : inbound(capacity), egress(capacity), outbound(capacity), route_cache(route_cache_sets) {}
     };
-    std::vector<RouterTableEntry> _router_table{};
+    std::vector<std::unique_ptr<Worker>> _workers{};
+    std::atomic<bool> _running{false};
+
+    //! The loop of interface `interface_num`'s worker thread
+    void run_worker(const size_t interface_num);
 
   public:
+    //! Sets of the destination cache in front of a Poptrie, by default (16k destinations, 256 KiB)
+    static constexpr size_t DEFAULT_ROUTE_CACHE_SETS = 4096;
+
+    //! \param[in] engine is the longest-prefix-match engine to route with
+    //! \param[in] route_cache_sets is the number of sets of the destination cache (see DestinationCache) that
+    //! route() and each worker thread keep in front of the engine, 0 for none; by default DEFAULT_ROUTE_CACHE_SETS
+    //! in front of a Poptrie, and none in front of DIR-24-8, which is at least as fast as the cache by itself
+    explicit Router(const LPM engine = LPM::Poptrie, const std::optional<size_t> route_cache_sets = {});
+
+    //! Stops the worker threads, if they are running
+    ~Router() { stop_workers(); }
+
+    Router(const Router &other) = delete;
+    Router &operator=(const Router &other) = delete;
+
     //! Add an interface to the router
     //! \param[in] interface an already-constructed network interface
     //! \returns The index of the interface after it has been added to the router
     // 添加路由接口
     size_t add_interface(AsyncNetworkInterface &&interface) {
+        if (_running) {
+            throw std::runtime_error("Router: can't add an interface while the workers are running");
+        }
         _interfaces.push_back(std::move(interface));
         return _interfaces.size() - 1;
     }
@@ -76,14 +195,78 @@ class Router {
     //! Access an interface by index
     AsyncNetworkInterface &interface(const size_t N) { return _interfaces.at(N); }
 
-    //! Add a route (a forwarding rule)
+    //! \brief Add a route (a forwarding rule)
+    //! \details Each call is a separate update_routes(), which copies the route entries; load many
+    //! routes at once with a single update_routes() instead
     void add_route(const uint32_t route_prefix,
                    const uint8_t prefix_length,
                    const std::optional<Address> next_hop,
                    const size_t interface_num);
 
-    //! Route packets between the interfaces
+    //! Remove the routes for a prefix
+    void remove_route(const uint32_t route_prefix, const uint8_t prefix_length);
+
+    //! \brief Add a multipath route: each flow (by its addresses, protocol and ports) takes one of the
+    //! next hops, in proportion to their weights, so that flows spread out but each stays in order
+    //! \details Replaces the routes for the prefix; flows on next hops that the new route keeps stay on
+    //! them where the weights allow (see ResilientHashTable)
+    void add_multipath_route(const uint32_t route_prefix,
+                             const uint8_t prefix_length,
+                             const std::vector<NextHop> &next_hops);
+
+    //! \brief Make a batch of changes to the routes, which take effect together
+    //! \details The changes are made to a copy of the routes, off the forwarding path, and the copy is then
+    //! swapped in atomically, so route() may run in another thread meanwhile; it never waits for the change.
+    //! Changes must come from one thread at a time. Changes that only add routes are made to the previous
+    //! copy instead, to spare copying the lookup table (64 MiB for DIR-24-8), if route() lets go of it within
+    //! RECYCLE_WAIT; the router keeps that copy for the purpose, so it holds two lookup tables.
+    void update_routes(const std::vector<RouteChange> &changes);
+
+    //! Number of replaced route tables still held by route() calls in progress
+    size_t retired_route_tables() const { return _routes.retired(); }
+
+    //! \brief Route packets between the interfaces
+    //! \details Routes with a snapshot of the routes, without taking any lock
     void route();
+
+    //! \name Parallel forwarding
+    //! Instead of route(), a worker thread per interface can forward. Each worker owns its interface
+    //! (its ARP state included): it takes in frames delivered to the interface, routes the datagrams
+    //! among them and hands each to the worker of its egress interface over a lock-free MPSC ring, and
+    //! sends the datagrams handed to it. Frames go in and out through deliver_frame() and collect_frame();
+    //! while the workers run, nothing else may touch the interfaces.
+    //!@{
+
+    //! \brief Start a worker thread per interface
+    //! \param[in] ring_capacity is the number of frames (or datagrams) each of a worker's rings holds
+    void start_workers(const size_t ring_capacity = 1024);
+
+    //! Stop and join the worker threads (frames they sent can still be collected)
+    void stop_workers();
+
+    //! \brief Deliver a frame to an interface (any thread)
+    //! \returns `false` if the interface's inbound ring is full, in which case `frame` is left untouched
+    bool deliver_frame(const size_t interface_num, EthernetFrame &&frame);
+
+    //! \brief Take a frame that an interface sent (one thread per interface)
+    std::optional<EthernetFrame> collect_frame(const size_t interface_num);
+
+    //! Datagrams dropped because their egress interface's ring was full
+    uint64_t egress_drops() const;
+    //!@}
+
+    //! \name Destination cache counters (of route() and the worker threads together)
+    //!@{
+
+    //! Destinations found in a destination cache
+    uint64_t route_cache_hits() const;
+
+    //! Destinations looked up in the longest-prefix-match engine (all of them, if the cache is disabled)
+    uint64_t route_cache_misses() const;
+    //!@}
+
+    //! Bytes used by the longest-prefix-match engine
+    size_t lpm_memory_usage() const;
 };
 
 #endif  // SPONGE_LIBSPONGE_ROUTER_HH
@@ -22,7 +22,7 @@ StreamReassembler::StreamReassembler(const size_t capacity)
 //! \details This function accepts a substring (aka a segment) of bytes,
 //! possibly out-of-order, from the logical stream, and assembles any newly
 //! contiguous substrings and writes them into the output stream in order.
-void StreamReassembler::push_substring(const string &data, const size_t index, const bool eof) {
+void StreamReassembler::push_substring(const string_view data, const size_t index, const bool eof) {
 
     /*
     核心思路是在_output中划出来一块区域来存放重组器（已重组未读取，未重组未读取）的数据
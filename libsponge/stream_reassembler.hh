@@ -7,6 +7,7 @@
 #include <map>
 #include <vector>
 #include <string>
+#include <string_view>
 
 //! \brief A class that assembles a series of excerpts from a byte stream
 //! (possibly out of order, possibly overlapping) into an in-order byte stream.
@@ -46,7 +47,7 @@ class StreamReassembler {
     //! \param index indicates the index (place in sequence) of the first
     //! byte in `data` \param eof the last byte of `data` will be the last
     //! byte in the entire stream
-    void push_substring(const std::string &data, const uint64_t index, const bool eof);
+    void push_substring(const std::string_view data, const uint64_t index, const bool eof);
 
     //! \name Access the reassembled byte stream
     //!@{
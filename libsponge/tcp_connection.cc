@@ -1,7 +1,9 @@
 #include "tcp_connection.hh"
 
+#include <algorithm>
 #include <cassert>
 #include <iostream>
+#include <limits>
 
 // Dummy implementation of a TCP connection
 
@@ -226,3 +228,21 @@ void TCPConnection::tick(const size_t ms_since_last_tick) {
 
 }
 
+// 处于 TIME_WAIT 状态的连接只需要对重传的 FIN 回复 ACK, 把这部分状态交给 TimeWaitTable 后, 本连接直接结束(不发送 RST)
+optional<TimeWaitRecord> TCPConnection::hand_off_time_wait() {
+    if (!_is_active || !_linger_after_streams_finish ||
+        TCPState::state_summary(_receiver) != TCPReceiverStateSummary::FIN_RECV ||
+        TCPState::state_summary(_sender) != TCPSenderStateSummary::FIN_ACKED) {
+        return {};
+    }
+
+    TimeWaitRecord record;
+    record.seqno = _sender.next_seqno();
+    record.ackno = _receiver.ackno().value();
+    record.window = min(_receiver.window_size(), size_t(numeric_limits<uint16_t>::max()));
+
+    // 不再需要等待 2MSL, 析构时也不会被当作非正常关闭
+    _linger_after_streams_finish = false;
+    _is_active = false;
+    return record;
+}
@@ -5,6 +5,9 @@
 #include "tcp_receiver.hh"
 #include "tcp_sender.hh"
 #include "tcp_state.hh"
+#include "time_wait_table.hh"
+
+#include <optional>
 
 //! \brief A complete endpoint of a TCP connection
 class TCPConnection {
@@ -92,6 +95,12 @@ class TCPConnection {
     //! \returns `true` if either stream is still running or if the TCPConnection is lingering
     //! after both streams have finished (e.g. to ACK retransmissions from the peer)
     bool active() const;
+
+    //! \brief Stop lingering in TIME_WAIT, so that a TimeWaitTable can take over
+    //! \details If the connection is in TIME_WAIT, it becomes inactive (without sending a RST)
+    //! and can be destroyed right away; the caller keeps ACKing the peer's retransmitted FINs.
+    //! \returns what the caller needs to do so, or empty if the connection is not in TIME_WAIT
+    std::optional<TimeWaitRecord> hand_off_time_wait();
     //!@}
 
     //! Construct a new connection from a configuration
@@ -1,5 +1,6 @@
 #include "arp_message.hh"
 
+#include <algorithm>
 #include <arpa/inet.h>
 #include <iomanip>
 #include <sstream>
@@ -45,31 +46,30 @@ bool ARPMessage::supported() const {
 }
 
 string ARPMessage::serialize() const {
+    string ret(LENGTH, 0);
+    serialize_into(ret.data());
+    return ret;
+}
+
+void ARPMessage::serialize_into(char *dst) const {
     if (not supported()) {
         throw runtime_error(
             "ARPMessage::serialize(): unsupported field combination (must be Ethernet/IP, and request or reply)");
     }
 
-    string ret;
-    NetUnparser::u16(ret, hardware_type);
-    NetUnparser::u16(ret, protocol_type);
-    NetUnparser::u8(ret, hardware_address_size);
-    NetUnparser::u8(ret, protocol_address_size);
-    NetUnparser::u16(ret, opcode);
+    NetUnparser::u16(dst, hardware_type);
+    NetUnparser::u16(dst + 2, protocol_type);
+    NetUnparser::u8(dst + 4, hardware_address_size);
+    NetUnparser::u8(dst + 5, protocol_address_size);
+    NetUnparser::u16(dst + 6, opcode);
 
     /* write sender addresses */
-    for (auto &byte : sender_ethernet_address) {
-        NetUnparser::u8(ret, byte);
-    }
-    NetUnparser::u32(ret, sender_ip_address);
+    copy(sender_ethernet_address.begin(), sender_ethernet_address.end(), dst + 8);
+    NetUnparser::u32(dst + 14, sender_ip_address);
 
     /* write target addresses */
-    for (auto &byte : target_ethernet_address) {
-        NetUnparser::u8(ret, byte);
-    }
-    NetUnparser::u32(ret, target_ip_address);
-
-    return ret;
+    copy(target_ethernet_address.begin(), target_ethernet_address.end(), dst + 18);
+    NetUnparser::u32(dst + 24, target_ip_address);
 }
 
 string ARPMessage::to_string() const {
@@ -3,6 +3,7 @@
 #include "parser.hh"
 #include "util.hh"
 
+#include <algorithm>
 #include <stdexcept>
 #include <string>
 
@@ -10,15 +11,44 @@ using namespace std;
 
 ParseResult EthernetFrame::parse(const Buffer buffer) {
     NetParser p{buffer};
+    _serialized_header.reset();
     _header.parse(p);
     _payload = p.buffer();
 
     return p.get_error();
 }
 
+//! \param[in] header is the header
+//! \param[in] serialized is the header, serialized
+void EthernetFrame::set_header(const EthernetHeader &header, const Buffer &serialized) {
+    if (serialized.size() != EthernetHeader::LENGTH) {
+        throw runtime_error("EthernetFrame::set_header: serialized header has the wrong length");
+    }
+    _header = header;
+    _serialized_header = serialized;
+}
+
 BufferList EthernetFrame::serialize() const {
     BufferList ret;
-    ret.append(_header.serialize());
+    if (_serialized_header.has_value()) {
+        ret.append(BufferList(_serialized_header.value()));
+    } else {
+        ret.append(_header.serialize());
+    }
     ret.append(_payload);
     return ret;
 }
+
+//! \param[in,out] packet holds the payload, and gets the header in front of it
+void EthernetFrame::serialize_into(PacketBuffer &packet) const {
+    if (packet.size() != _payload.size()) {
+        throw runtime_error("EthernetFrame::serialize_into: packet does not hold the payload");
+    }
+    char *header_bytes = packet.prepend(EthernetHeader::LENGTH);
+    if (_serialized_header.has_value()) {
+        const string_view serialized = _serialized_header->str();
+        copy(serialized.begin(), serialized.end(), header_bytes);
+    } else {
+        _header.serialize_into(header_bytes);
+    }
+}
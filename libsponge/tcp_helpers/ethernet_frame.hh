@@ -3,11 +3,15 @@
 
 #include "buffer.hh"
 #include "ethernet_header.hh"
+#include "packet_buffer.hh"
+
+#include <optional>
 
 //! \brief Ethernet frame
 class EthernetFrame {
   private:
     EthernetHeader _header{};
+    std::optional<Buffer> _serialized_header{};  //!< `_header` already serialized, if set_header() was given it
     BufferList _payload{};
 
   public:
@@ -17,10 +21,22 @@ class EthernetFrame {
     //! \brief Serialize the frame to a string
     BufferList serialize() const;
 
+    //! \brief Serialize the frame in place, prepending the header to a `packet` that holds the payload
+    void serialize_into(PacketBuffer &packet) const;
+
+    //! \brief Set the header along with its serialization, which serialize() then uses instead of
+    //! serializing the header again (e.g. one Buffer shared by all the frames to a neighbor)
+    //! \note `serialized` must hold `header.serialize()`
+    void set_header(const EthernetHeader &header, const Buffer &serialized);
+
     //! \name Accessors
+    //! (The mutable header() forgets the serialization given to set_header(), as the header may change.)
     //!@{
     const EthernetHeader &header() const { return _header; }
-    EthernetHeader &header() { return _header; }
+    EthernetHeader &header() {
+        _serialized_header.reset();
+        return _header;
+    }
 
     const BufferList &payload() const { return _payload; }
     BufferList &payload() { return _payload; }
@@ -2,6 +2,7 @@
 
 #include "util.hh"
 
+#include <algorithm>
 #include <iomanip>
 #include <sstream>
 
@@ -29,23 +30,20 @@ ParseResult EthernetHeader::parse(NetParser &p) {
 }
 
 string EthernetHeader::serialize() const {
-    string ret;
-    ret.reserve(LENGTH);
+    string ret(LENGTH, 0);
+    serialize_into(ret.data());
+    return ret;
+}
 
+void EthernetHeader::serialize_into(char *dst_bytes) const {
     /* write destination address */
-    for (auto &byte : dst) {
-        NetUnparser::u8(ret, byte);
-    }
+    copy(dst.begin(), dst.end(), dst_bytes);
 
     /* write source address */
-    for (auto &byte : src) {
-        NetUnparser::u8(ret, byte);
-    }
+    copy(src.begin(), src.end(), dst_bytes + 6);
 
     /* write the frame's type (e.g. IPv4, ARP or something else) */
-    NetUnparser::u16(ret, type);
-
-    return ret;
+    NetUnparser::u16(dst_bytes + 12, type);
 }
 
 //! \returns A string with a textual representation of an Ethernet address
@@ -34,6 +34,9 @@ struct EthernetHeader {
     //! Serialize the Ethernet fields to a string
     std::string serialize() const;
 
+    //! Serialize the Ethernet fields in place, into the LENGTH bytes at `dst_bytes`
+    void serialize_into(char *dst_bytes) const;
+
     //! Return a string containing a header in human-readable format
     std::string to_string() const;
 };
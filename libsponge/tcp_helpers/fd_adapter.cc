@@ -2,12 +2,24 @@
 
 #include <iostream>
 #include <stdexcept>
+#include <string>
+#include <string_view>
 #include <utility>
 
 using namespace std;
 
+//! \param[in] sock is the socket to send and receive on
+//! \param[in] offload is `false` to avoid UDP_SEGMENT and UDP_GRO even if the kernel supports them
+TCPOverUDPSocketAdapter::TCPOverUDPSocketAdapter(UDPSocket &&sock, const bool offload)
+    : _sock(move(sock)), _segment_offload(offload and _sock.gso_supported()) {
+    if (offload) {
+        _sock.enable_gro();
+    }
+}
+
 //! \details This function first attempts to parse a TCP segment from the next UDP
-//! payload recv()d from the socket.
+//! payload received from the socket. If every datagram of the last batch has been
+//! returned, it first receives a new batch with UDPSocket::recv_batch.
 //!
 //! If this succeeds, it then checks that the received segment is related to the
 //! current connection. When a TCP connection has been established, this means
@@ -19,23 +31,38 @@ using namespace std;
 //! the result that future outgoing segments go to the sender of the SYN segment.
 //! \returns a std::optional<TCPSegment> that is empty if the segment was invalid or unrelated
 optional<TCPSegment> TCPOverUDPSocketAdapter::read() {
-    auto datagram = _sock.recv();
+    if (not has_pending_reads()) {
+        _sock.recv_batch(_received);
+        _next_received = 0;
+        _next_offset = 0;
+    }
+
+    // take the next segment-sized piece of the datagram (all of it, unless the kernel coalesced several)
+    const size_t index = _next_received;
+    const string_view payload = _received.payload(index).substr(_next_offset, _received.segment_size(index));
+    _next_offset += payload.size();
+    if (_next_offset >= _received.payload(index).size()) {
+        _next_received++;
+        _next_offset = 0;
+    }
+    const Address source_address = _received.source_address(index);
 
     // is it for us?
-    if (not listening() and (datagram.source_address != config().destination)) {
+    if (not listening() and (source_address != config().destination)) {
         return {};
     }
 
-    // is the payload a valid TCP segment?
+    // is the payload a valid TCP segment? (parsed from a copy of just this segment: the batch's storage
+    // is reused by the next recv_batch(), and a segment sharing it would pin all of it)
     TCPSegment seg;
-    if (ParseResult::NoError != seg.parse(move(datagram.payload), 0)) {
+    if (ParseResult::NoError != seg.parse(string(payload), 0)) {
         return {};
     }
 
     // should we target this source in all future replies?
     if (listening()) {
         if (seg.header().syn and not seg.header().rst) {
-            config_mutable().destination = datagram.source_address;
+            config_mutable().destination = source_address;
             set_listening(false);
         } else {
             return {};
@@ -45,12 +72,23 @@ optional<TCPSegment> TCPOverUDPSocketAdapter::read() {
     return seg;
 }
 
-//! Serialize a TCP segment and send it as the payload of a UDP datagram.
+//! Serialize a TCP segment and queue it to be sent as the payload of a UDP datagram.
 //! \param[in] seg is the TCP segment to write
 void TCPOverUDPSocketAdapter::write(TCPSegment &seg) {
     seg.header().sport = config().source.port();
     seg.header().dport = config().destination.port();
-    _sock.sendto(config().destination, seg.serialize(0));
+    _to_send.push_back(seg.serialize(0));
+    if (_to_send.size() >= BATCH_SIZE) {
+        flush();
+    }
+}
+
+void TCPOverUDPSocketAdapter::flush() {
+    if (_to_send.empty()) {
+        return;
+    }
+    _sock.send_batch(config().destination, {_to_send.begin(), _to_send.end()}, _segment_offload);
+    _to_send.clear();
 }
 
 //! Specialize LossyFdAdapter to TCPOverUDPSocketAdapter
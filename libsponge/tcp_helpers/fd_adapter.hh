@@ -10,6 +10,7 @@
 
 #include <optional>
 #include <utility>
+#include <vector>
 
 //! \brief Basic functionality for file descriptor adaptors
 //! \details See TCPOverUDPSocketAdapter and TCPOverIPv4OverTunFdAdapter for more information.
@@ -40,23 +41,55 @@ class FdAdapterBase {
 
     //! Called periodically when time elapses
     void tick(const size_t) {}
+
+    //! \brief Are there segments that have been received but not yet returned by read()?
+    //! \details An adapter that receives several datagrams per system call returns them one at a time
+    //! from read(); its owner should keep calling read() while this is `true`, since the file
+    //! descriptor will not become readable again for datagrams that have already been received.
+    bool has_pending_reads() const { return false; }
+
+    //! \brief Send any segments that write() has queued
+    //! \details An adapter may hold on to written segments to send several per system call. Its owner
+    //! must call flush() once it has written everything it has to write for now.
+    void flush() {}
 };
 
 //! \brief A FD adaptor that reads and writes TCP segments in UDP payloads
+//! \details Datagrams are received with recvmmsg(2) and sent with sendmmsg(2), up to BATCH_SIZE
+//! per system call (see FdAdapterBase::has_pending_reads and FdAdapterBase::flush). If the kernel
+//! supports it, runs of same-size segments are also sent as one UDP_SEGMENT (GSO) message, and
+//! datagrams the kernel coalesced on receipt (UDP_GRO) are split back into segments.
 class TCPOverUDPSocketAdapter : public FdAdapterBase {
+  public:
+    static constexpr size_t BATCH_SIZE = 32;  //!< Most datagrams received or sent per system call
+
   private:
     UDPSocket _sock;
+    UDPSocket::DatagramBatch _received{BATCH_SIZE};  //!< Datagrams from the last recvmmsg(2)
+    size_t _next_received{0};                        //!< Next datagram of `_received` for read() to return
+    size_t _next_offset{0};                          //!< Where in that (perhaps coalesced) datagram to start
+    std::vector<BufferList> _to_send{};              //!< Serialized segments waiting for flush()
+    bool _segment_offload;                           //!< Send with UDP_SEGMENT?
 
   public:
-    //! Construct from a UDPSocket sliced into a FileDescriptor
-    explicit TCPOverUDPSocketAdapter(UDPSocket &&sock) : _sock(std::move(sock)) {}
+    //! \brief Construct from a UDPSocket sliced into a FileDescriptor
+    //! \param[in] offload is `false` to avoid UDP_SEGMENT and UDP_GRO even if the kernel supports them
+    explicit TCPOverUDPSocketAdapter(UDPSocket &&sock, const bool offload = true);
 
-    //! Attempts to read and return a TCP segment related to the current connection from a UDP payload
+    //! \brief Attempts to read and return a TCP segment related to the current connection from a UDP payload
+    //! \details The datagrams are received in batches without allocating, but each segment returned is
+    //! parsed from its own copy of the payload.
     std::optional<TCPSegment> read();
 
-    //! Writes a TCP segment into a UDP payload
+    //! Queues a TCP segment to be sent as a UDP payload (sent once BATCH_SIZE are queued, or by flush())
     void write(TCPSegment &seg);
 
+    //! Are there datagrams left from the last recvmmsg(2)?
+    bool has_pending_reads() const { return _next_received < _received.size(); }
+
+    //! Send the queued segments
+    void flush();
+
     //! Access the underlying UDP socket
     operator UDPSocket &() { return _sock; }
 
@@ -0,0 +1,11 @@
+#include "four_tuple.hh"
+
+#include "address.hh"
+
+using namespace std;
+
+//! \returns A string of the form `local_ip:port <-> remote_ip:port`
+string FourTuple::to_string() const {
+    return Address::from_ipv4_numeric(local_address).ip() + ":" + ::to_string(local_port) + " <-> " +
+           Address::from_ipv4_numeric(remote_address).ip() + ":" + ::to_string(remote_port);
+}
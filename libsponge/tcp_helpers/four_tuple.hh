@@ -0,0 +1,40 @@
+#ifndef SPONGE_LIBSPONGE_FOUR_TUPLE_HH
+#define SPONGE_LIBSPONGE_FOUR_TUPLE_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+//! \brief The addresses and ports that identify one TCP connection
+//! \details Stored from the local endpoint's point of view, i.e. for an inbound segment
+//! `remote_*` come from the segment's source fields and `local_*` from its destination fields.
+struct FourTuple {
+    uint32_t local_address = 0;   //!< Local IPv4 address (host byte order)
+    uint16_t local_port = 0;      //!< Local TCP port
+    uint32_t remote_address = 0;  //!< Remote IPv4 address (host byte order)
+    uint16_t remote_port = 0;     //!< Remote TCP port
+
+    bool operator==(const FourTuple &other) const {
+        return local_address == other.local_address and local_port == other.local_port and
+               remote_address == other.remote_address and remote_port == other.remote_port;
+    }
+
+    bool operator!=(const FourTuple &other) const { return not operator==(other); }
+
+    //! Return a string containing the tuple in human-readable format
+    std::string to_string() const;
+};
+
+//! Hash functor so that FourTuple can key a std::unordered_map
+struct FourTupleHash {
+    size_t operator()(const FourTuple &t) const {
+        uint64_t x = (uint64_t{t.local_address} << 32) | t.remote_address;
+        x ^= (uint64_t{t.local_port} << 16 | t.remote_port) * 0x9e3779b97f4a7c15ULL;
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        return x;
+    }
+};
+
+#endif  // SPONGE_LIBSPONGE_FOUR_TUPLE_HH
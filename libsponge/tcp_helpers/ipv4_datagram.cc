@@ -10,7 +10,7 @@ using namespace std;
 
 ParseResult IPv4Datagram::parse(const Buffer buffer) {
     NetParser p{buffer};
-    _header.parse(p);
+    _header_cksum_valid = _header.parse(p) == ParseResult::NoError;
     _payload = p.buffer();
 
     if (_payload.size() != _header.payload_length()) {
@@ -25,17 +25,43 @@ BufferList IPv4Datagram::serialize() const {
         throw runtime_error("IPv4Datagram::serialize: payload is wrong size");
     }
 
+    string header(4 * _header.hlen, 0);
+    serialize_header_into(header.data());
+
+    BufferList ret;
+    ret.append(move(header));
+    ret.append(_payload);
+    return ret;
+}
+
+//! \param[in,out] packet holds the payload, and gets the header in front of it
+void IPv4Datagram::serialize_into(PacketBuffer &packet) const {
+    if (packet.size() != _header.payload_length()) {
+        throw runtime_error("IPv4Datagram::serialize_into: packet does not hold the payload");
+    }
+    serialize_header_into(packet.prepend(4 * _header.hlen));
+}
+
+void IPv4Datagram::serialize_header_into(char *dst) const {
+    if (_header_cksum_valid) {
+        _header.serialize_into(dst);
+        return;
+    }
+
     IPv4Header header_out = _header;
     header_out.cksum = 0;
-    const string header_zero_checksum = header_out.serialize();
+    header_out.serialize_into(dst);
 
     // calculate checksum -- taken over header only
     InternetChecksum check;
-    check.add(header_zero_checksum);
-    header_out.cksum = check.value();
+    check.add({dst, size_t(4 * header_out.hlen)});
+    NetUnparser::u16(dst + IPv4Header::CKSUM_OFFSET, check.value());
+}
 
-    BufferList ret;
-    ret.append(header_out.serialize());
-    ret.append(_payload);
-    return ret;
+void IPv4Datagram::decrement_ttl() {
+    // the TTL is the high byte of the header's fifth 16-bit word, the protocol its low byte
+    const uint16_t old_word = (_header.ttl << 8) | _header.proto;
+    _header.ttl--;
+    const uint16_t new_word = (_header.ttl << 8) | _header.proto;
+    _header.cksum = InternetChecksum::update_u16(_header.cksum, old_word, new_word);
 }
@@ -3,24 +3,42 @@
 
 #include "buffer.hh"
 #include "ipv4_header.hh"
+#include "packet_buffer.hh"
 
 //! \brief [IPv4](\ref rfc::rfc791) Internet datagram
 class IPv4Datagram {
   private:
     IPv4Header _header{};
     BufferList _payload{};
+    bool _header_cksum_valid{false};  //!< Is `_header.cksum` known to be right (so serialize() can keep it)?
+
+    //! Serialize the header, with a correct checksum, into the `4 * hlen` bytes at `dst`
+    void serialize_header_into(char *dst) const;
 
   public:
     //! \brief Parse the segment from a string
     ParseResult parse(const Buffer buffer);
 
     //! \brief Serialize the segment to a string
+    //! \details Computes the header checksum, unless it is known to be right already
     BufferList serialize() const;
 
+    //! \brief Serialize the datagram in place, prepending the header to a `packet` that holds the payload
+    //! \details Computes the header checksum, unless it is known to be right already
+    void serialize_into(PacketBuffer &packet) const;
+
+    //! \brief Decrement the TTL, patching the header checksum ([RFC 1624](\ref rfc::rfc1624)) rather than
+    //! summing the header again
+    void decrement_ttl();
+
     //! \name Accessors
     //!@{
     const IPv4Header &header() const { return _header; }
-    IPv4Header &header() { return _header; }
+    //! \details As the header may be changed through the reference, serialize() will compute its checksum
+    IPv4Header &header() {
+        _header_cksum_valid = false;
+        return _header;
+    }
 
     const BufferList &payload() const { return _payload; }
     BufferList &payload() { return _payload; }
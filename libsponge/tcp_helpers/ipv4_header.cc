@@ -2,6 +2,7 @@
 
 #include "util.hh"
 
+#include <algorithm>
 #include <arpa/inet.h>
 #include <iomanip>
 #include <sstream>
@@ -76,6 +77,12 @@ ParseResult IPv4Header::parse(NetParser &p) {
 
 //! Serialize the IPv4Header to a string (does not recompute the checksum)
 string IPv4Header::serialize() const {
+    string ret(4 * hlen, 0);
+    serialize_into(ret.data());
+    return ret;
+}
+
+void IPv4Header::serialize_into(char *dst_bytes) const {
     // sanity checks
     if (ver != 4) {
         throw runtime_error("wrong IP version");
@@ -84,29 +91,36 @@ string IPv4Header::serialize() const {
         throw runtime_error("IP header too short");
     }
 
-    string ret;
-    ret.reserve(4 * hlen);
-
     const uint8_t first_byte = (ver << 4) | (hlen & 0xf);
-    NetUnparser::u8(ret, first_byte);  // version and header length
-    NetUnparser::u8(ret, tos);         // type of service
-    NetUnparser::u16(ret, len);        // length
-    NetUnparser::u16(ret, id);         // id
+    NetUnparser::u8(dst_bytes, first_byte);  // version and header length
+    NetUnparser::u8(dst_bytes + 1, tos);     // type of service
+    NetUnparser::u16(dst_bytes + 2, len);    // length
+    NetUnparser::u16(dst_bytes + 4, id);     // id
 
     const uint16_t fo_val = (df ? 0x4000 : 0) | (mf ? 0x2000 : 0) | (offset & 0x1fff);
-    NetUnparser::u16(ret, fo_val);  // flags and offset
+    NetUnparser::u16(dst_bytes + 6, fo_val);  // flags and offset
 
-    NetUnparser::u8(ret, ttl);    // time to live
-    NetUnparser::u8(ret, proto);  // protocol number
+    NetUnparser::u8(dst_bytes + 8, ttl);    // time to live
+    NetUnparser::u8(dst_bytes + 9, proto);  // protocol number
 
-    NetUnparser::u16(ret, cksum);  // checksum
+    NetUnparser::u16(dst_bytes + CKSUM_OFFSET, cksum);  // checksum
 
-    NetUnparser::u32(ret, src);  // src address
-    NetUnparser::u32(ret, dst);  // dst address
+    NetUnparser::u32(dst_bytes + 12, src);  // src address
+    NetUnparser::u32(dst_bytes + 16, dst);  // dst address
 
-    ret.resize(4 * hlen);  // expand header to advertised size
+    fill(dst_bytes + LENGTH, dst_bytes + 4 * hlen, 0);  // expand header to advertised size
+}
 
-    return ret;
+//! \param[in] datagram is a raw IPv4 datagram
+optional<IPv4HeaderView> IPv4HeaderView::from(const string_view datagram) {
+    if (datagram.size() < IPv4Header::LENGTH) {
+        return {};
+    }
+    const IPv4HeaderView view{datagram};
+    if (view.ver() != 4 or view.hlen() < 5 or datagram.size() < 4 * view.hlen()) {
+        return {};
+    }
+    return view;
 }
 
 uint16_t IPv4Header::payload_length() const { return len - 4 * hlen; }
@@ -3,12 +3,17 @@
 
 #include "parser.hh"
 
+#include <optional>
+#include <string_view>
+
 //! \brief [IPv4](\ref rfc::rfc791) Internet datagram header
 //! \note IP options are not supported
 struct IPv4Header {
     static constexpr size_t LENGTH = 20;         //!< [IPv4](\ref rfc::rfc791) header length, not including options
     static constexpr uint8_t DEFAULT_TTL = 128;  //!< A reasonable default TTL value
     static constexpr uint8_t PROTO_TCP = 6;      //!< Protocol number for [tcp](\ref rfc::rfc793)
+    static constexpr uint8_t PROTO_UDP = 17;     //!< Protocol number for UDP (RFC 768)
+    static constexpr size_t CKSUM_OFFSET = 10;   //!< Where the checksum is in the header
 
     //! \struct IPv4Header
     //! ~~~{.txt}
@@ -52,6 +57,9 @@ struct IPv4Header {
     //! Serialize the IP fields
     std::string serialize() const;
 
+    //! Serialize the IP fields in place, into the `4 * hlen` bytes at `dst`
+    void serialize_into(char *dst) const;
+
     //! Length of the payload
     uint16_t payload_length() const;
 
@@ -68,4 +76,31 @@ struct IPv4Header {
 //! \struct IPv4Header
 //! This struct can be used to parse an existing IP header or to create a new one.
 
+//! \brief A view of the IPv4 header at the start of a raw datagram (see HeaderView)
+//! \details Meant for looking at a few fields (e.g. to drop a datagram that is not for us) before,
+//! or instead of, parsing the datagram into an IPv4Header. The checksum is not checked.
+class IPv4HeaderView : public HeaderView<IPv4Header::LENGTH> {
+  private:
+    using HeaderView::HeaderView;
+
+  public:
+    //! \brief View the header of `datagram`
+    //! \returns nothing if `datagram` is too short for its header, or is not IPv4
+    static std::optional<IPv4HeaderView> from(const std::string_view datagram);
+
+    //! \name IPv4 header fields
+    //!@{
+    uint8_t ver() const { return field<0, uint8_t>() >> 4; }
+    uint8_t hlen() const { return field<0, uint8_t>() & 0x0f; }
+    uint16_t len() const { return field<2, uint16_t>(); }
+    uint8_t ttl() const { return field<8, uint8_t>(); }
+    uint8_t proto() const { return field<9, uint8_t>(); }
+    uint32_t src() const { return field<12, uint32_t>(); }
+    uint32_t dst() const { return field<16, uint32_t>(); }
+    //!@}
+
+    //! The bytes that follow the header (including any beyond `len`)
+    std::string_view payload() const { return _bytes.substr(4 * hlen()); }
+};
+
 #endif  // SPONGE_LIBSPONGE_IPV4_HEADER_HH
@@ -66,6 +66,10 @@ class LossyFdAdapter {
     void tick(const size_t ms_since_last_tick) {
         _adapter.tick(ms_since_last_tick);
     }  //!< FdAdapterBase::tick passthrough
+    bool has_pending_reads() const {
+        return _adapter.has_pending_reads();
+    }                                   //!< FdAdapterBase::has_pending_reads passthrough
+    void flush() { _adapter.flush(); }  //!< FdAdapterBase::flush passthrough
     //!@}
 };
 
@@ -0,0 +1,99 @@
+#include "multi_queue_tun_stack.hh"
+
+#include "eventloop.hh"
+#include "ipv4_datagram.hh"
+#include "parser.hh"
+#include "tcp_over_ip.hh"
+
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+
+using namespace std;
+
+//! How often a reader thread checks whether it should stop
+static constexpr int READER_POLL_MS = 10;
+
+vector<TunFD> MultiQueueTunStack::_open_queues(const string &devname, const size_t num_queues) {
+    vector<TunFD> queues;
+    for (size_t i = 0; i < num_queues; i++) {
+        queues.emplace_back(devname, true);
+    }
+    return queues;
+}
+
+ShardedRuntimeConfig MultiQueueTunStack::_runtime_config(const ShardedRuntimeConfig &cfg) {
+    ShardedRuntimeConfig ret = cfg;
+    ret.num_producers = cfg.num_shards;
+    return ret;
+}
+
+//! \param[in] devname is the name of a TUN device created with `multi_queue`
+//! \param[in] cfg is the number of shards (and so of queues), and the configuration of each shard
+//! \param[in] hook is called on a shard's thread after every wakeup (see ShardedTCPRuntime)
+MultiQueueTunStack::MultiQueueTunStack(const string &devname,
+                                       const ShardedRuntimeConfig &cfg,
+                                       const ShardedTCPRuntime::HookT &hook)
+    : _queues(_open_queues(devname, cfg.num_shards))
+    , _runtime(
+          _runtime_config(cfg),
+          [this](ShardedTCPRuntime::Shard &shard, const FourTuple &tuple, TCPSegment &&seg) {
+              _queues[shard.index()].write(tcp_segment_to_ip(tuple, seg).serialize());
+          },
+          hook) {}
+
+MultiQueueTunStack::~MultiQueueTunStack() {
+    try {
+        stop();
+    } catch (const exception &e) {
+        cerr << "Exception destructing MultiQueueTunStack: " << e.what() << endl;
+    }
+}
+
+void MultiQueueTunStack::start() {
+    if (_running.exchange(true)) {
+        throw runtime_error("MultiQueueTunStack: already started");
+    }
+    _runtime.start();
+    for (size_t i = 0; i < _queues.size(); i++) {
+        _readers.emplace_back(&MultiQueueTunStack::_reader_main, this, i);
+    }
+}
+
+void MultiQueueTunStack::stop() {
+    _running.store(false);
+    for (auto &reader : _readers) {
+        reader.join();
+    }
+    _readers.clear();
+    _runtime.stop();
+}
+
+void MultiQueueTunStack::_reader_main(const size_t queue) {
+    try {
+        TunFD &tun = _queues[queue];
+        EventLoop eventloop;
+        eventloop.add_rule(tun, Direction::In, [&] {
+            InternetDatagram ip_dgram;
+            FourTuple tuple;
+            if (ip_dgram.parse(tun.read()) != ParseResult::NoError) {
+                _invalid_datagrams++;
+                return;
+            }
+            auto seg = tcp_segment_from_ip(ip_dgram, tuple);
+            if (not seg) {
+                _invalid_datagrams++;
+                return;
+            }
+            // a full ring drops the segment, as a NIC drops packets when its queue overflows
+            _runtime.deliver(queue, tuple, move(seg.value()));
+        });
+
+        while (_running.load()) {
+            eventloop.wait_next_event(READER_POLL_MS);
+        }
+    } catch (const exception &e) {
+        cerr << "Exception in reader thread for queue " << queue << ": " << e.what() << "\n";
+        throw;
+    }
+}
@@ -0,0 +1,73 @@
+#ifndef SPONGE_LIBSPONGE_MULTI_QUEUE_TUN_STACK_HH
+#define SPONGE_LIBSPONGE_MULTI_QUEUE_TUN_STACK_HH
+
+#include "four_tuple.hh"
+#include "sharded_tcp_runtime.hh"
+#include "tcp_config.hh"
+#include "tcp_segment.hh"
+#include "tun.hh"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+//! \brief A sharded TCP stack attached to every queue of a multi-queue TUN device
+//! \details Opens one queue of the device per shard of a ShardedTCPRuntime. Each queue has a
+//! reader thread, which plays the part of a NIC's receive interrupt: it parses the IPv4
+//! datagrams that the kernel hands to its queue and delivers the TCP segments to whichever
+//! shard owns their connection. Each shard sends on its own queue, so no queue is ever
+//! written by more than one thread, and a run with many connections spreads over as many
+//! cores as there are queues rather than serializing on one file descriptor.
+//!
+//! The device must have been created with `multi_queue` (see tun.sh).
+class MultiQueueTunStack {
+  private:
+    std::vector<TunFD> _queues;  //!< One per shard
+    ShardedTCPRuntime _runtime;
+    std::atomic<bool> _running{false};
+    std::vector<std::thread> _readers{};  //!< One per queue
+    std::atomic<uint64_t> _invalid_datagrams{0};
+
+    //! Open `num_queues` queues of the device `devname`
+    static std::vector<TunFD> _open_queues(const std::string &devname, const size_t num_queues);
+
+    //! The runtime's configuration, with one producer per queue
+    static ShardedRuntimeConfig _runtime_config(const ShardedRuntimeConfig &cfg);
+
+    //! Main loop of the thread that reads from queue number `queue`
+    void _reader_main(const size_t queue);
+
+  public:
+    //! \brief Open one queue of the device `devname` per shard in `cfg`
+    //! \param[in] hook is called on a shard's thread after every wakeup (see ShardedTCPRuntime)
+    MultiQueueTunStack(const std::string &devname,
+                       const ShardedRuntimeConfig &cfg,
+                       const ShardedTCPRuntime::HookT &hook = {});
+
+    //! Stops the reader and shard threads
+    ~MultiQueueTunStack();
+
+    //! \brief Start the shards' threads and one reader thread per queue
+    void start();
+
+    //! \brief Stop and join all threads
+    void stop();
+
+    size_t num_queues() const { return _queues.size(); }                      //!< Number of queues (and shards)
+    ShardedTCPRuntime &runtime() { return _runtime; }                         //!< The shards
+    uint64_t invalid_datagrams() const { return _invalid_datagrams.load(); }  //!< Datagrams that were not TCP
+
+    //! \name
+    //! The threads refer to this object, so it cannot be moved or copied
+
+    //!@{
+    MultiQueueTunStack(const MultiQueueTunStack &) = delete;
+    MultiQueueTunStack &operator=(const MultiQueueTunStack &) = delete;
+    MultiQueueTunStack(MultiQueueTunStack &&) = delete;
+    MultiQueueTunStack &operator=(MultiQueueTunStack &&) = delete;
+    //!@}
+};
+
+#endif  // SPONGE_LIBSPONGE_MULTI_QUEUE_TUN_STACK_HH
@@ -0,0 +1,148 @@
+#include "sharded_tcp_runtime.hh"
+
+#include "util.hh"
+
+#include <iostream>
+#include <stdexcept>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+using namespace std;
+
+static constexpr size_t SHARD_TICK_MS = 10;
+
+ShardedTCPRuntime::Shard::Shard(const size_t index, const ShardedRuntimeConfig &cfg)
+    : _index(index)
+    , _listener(cfg.tcp, cfg.listener)
+    , _doorbell(SystemCall("eventfd", ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))) {
+    for (size_t i = 0; i < cfg.num_producers; i++) {
+        _inboxes.push_back(make_unique<SPSCRing<Packet>>(cfg.ring_capacity));
+    }
+}
+
+//! \param[in] cfg is the number of shards and producers, and the configuration of each shard
+//! \param[in] sink is called on a shard's thread with each segment the shard wants sent
+//! \param[in] hook is called on a shard's thread after every wakeup
+ShardedTCPRuntime::ShardedTCPRuntime(const ShardedRuntimeConfig &cfg, const SinkT &sink, const HookT &hook)
+    : _cfg(cfg), _sink(sink), _hook(hook) {
+    if (_cfg.num_shards == 0 or _cfg.num_shards > INDIRECTION_TABLE_SIZE or _cfg.num_producers == 0) {
+        throw runtime_error("ShardedTCPRuntime: invalid number of shards or producers");
+    }
+
+    for (size_t i = 0; i < _cfg.num_shards; i++) {
+        _shards.push_back(make_unique<Shard>(i, _cfg));
+    }
+
+    // like a NIC driver, spread the hash buckets evenly over the queues
+    for (size_t i = 0; i < _indirection.size(); i++) {
+        _indirection[i] = i % _cfg.num_shards;
+    }
+}
+
+ShardedTCPRuntime::~ShardedTCPRuntime() {
+    try {
+        stop();
+    } catch (const exception &e) {
+        cerr << "Exception destructing ShardedTCPRuntime: " << e.what() << endl;
+    }
+}
+
+void ShardedTCPRuntime::start() {
+    if (_running.exchange(true)) {
+        throw runtime_error("ShardedTCPRuntime: already started");
+    }
+    for (auto &shard : _shards) {
+        shard->_thread = thread(&ShardedTCPRuntime::_shard_main, this, ref(*shard));
+    }
+}
+
+void ShardedTCPRuntime::stop() {
+    _running.store(false);
+    for (auto &shard : _shards) {
+        if (shard->_thread.joinable()) {
+            _ring_doorbell(*shard);
+            shard->_thread.join();
+        }
+    }
+}
+
+size_t ShardedTCPRuntime::shard_for(const FourTuple &tuple) const {
+    // an inbound segment's source is our remote end
+    const uint32_t hash =
+        _hash.hash_ipv4_tcp(tuple.remote_address, tuple.local_address, tuple.remote_port, tuple.local_port);
+    return _indirection[hash % INDIRECTION_TABLE_SIZE];
+}
+
+void ShardedTCPRuntime::_ring_doorbell(Shard &shard) {
+    const uint64_t one = 1;
+    SystemCall("write", ::write(shard._doorbell.fd_num(), &one, sizeof(one)));
+}
+
+//! \param[in] producer identifies the calling thread
+//! \param[in] tuple identifies the connection the segment belongs to
+//! \param[in] seg is the segment that arrived
+bool ShardedTCPRuntime::deliver(const size_t producer, const FourTuple &tuple, TCPSegment &&seg) {
+    Shard &shard = *_shards[shard_for(tuple)];
+    if (not shard._inboxes.at(producer)->push({tuple, move(seg)})) {
+        shard._ring_drops++;
+        return false;
+    }
+
+    // only pay for the syscall if the shard might be asleep (the fence pairs with the one in
+    // _shard_main, so either we see it sleeping or it sees our segment); exchange() makes sure
+    // that only one producer rings
+    atomic_thread_fence(memory_order_seq_cst);
+    if (shard._sleeping.load(memory_order_relaxed) and shard._sleeping.exchange(false)) {
+        _ring_doorbell(shard);
+    }
+    return true;
+}
+
+void ShardedTCPRuntime::_shard_main(Shard &shard) {
+    try {
+        shard._eventloop.add_rule(shard._doorbell, Direction::In, [&] { shard._doorbell.read(sizeof(uint64_t)); });
+
+        auto &listener = shard._listener;
+        auto base_time = timestamp_ms();
+        while (_running.load()) {
+            // announce that we may sleep, then look for work one last time
+            shard._sleeping.store(true);
+            atomic_thread_fence(memory_order_seq_cst);
+            bool pending = false;
+            for (const auto &inbox : shard._inboxes) {
+                pending = pending or not inbox->empty();
+            }
+
+            if (shard._eventloop.wait_next_event(pending ? 0 : SHARD_TICK_MS) == EventLoop::Result::Exit) {
+                break;
+            }
+            shard._sleeping.store(false);
+
+            for (auto &inbox : shard._inboxes) {
+                while (auto packet = inbox->pop()) {
+                    listener.segment_received(packet->first, packet->second);
+                    shard._segments_received++;
+                }
+            }
+
+            const auto next_time = timestamp_ms();
+            if (next_time != base_time) {
+                listener.tick(next_time - base_time);
+                base_time = next_time;
+            }
+
+            if (_hook) {
+                _hook(shard);
+            }
+
+            auto &segments_out = listener.segments_out();
+            while (not segments_out.empty()) {
+                _sink(shard, segments_out.front().first, move(segments_out.front().second));
+                segments_out.pop();
+            }
+        }
+    } catch (const exception &e) {
+        cerr << "Exception in shard " << shard._index << " thread: " << e.what() << "\n";
+        throw;
+    }
+}
@@ -0,0 +1,125 @@
+#ifndef SPONGE_LIBSPONGE_SHARDED_TCP_RUNTIME_HH
+#define SPONGE_LIBSPONGE_SHARDED_TCP_RUNTIME_HH
+
+#include "eventloop.hh"
+#include "file_descriptor.hh"
+#include "four_tuple.hh"
+#include "spsc_ring.hh"
+#include "tcp_config.hh"
+#include "tcp_listener.hh"
+#include "tcp_segment.hh"
+#include "toeplitz.hh"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+//! \brief A TCP stack split into shards, each owning its connections and run by its own thread
+//! \details Every shard has its own EventLoop and TCPListener, so no state is shared between
+//! shards and nothing is locked. Inbound segments are steered to a shard the way an RSS-capable
+//! NIC steers packets to receive queues: the Toeplitz hash of the flow indexes an indirection
+//! table of shards. All segments of a connection therefore land on the same shard.
+//!
+//! Each producer thread (e.g. one per receive queue) has its own SPSCRing into each shard. A
+//! shard sleeps in its EventLoop and is woken through an eventfd "doorbell", which producers
+//! only ring when the shard has announced that it is about to sleep.
+//!
+//! Outbound segments are handed to a sink on the shard's own thread, and the owner can act on
+//! a shard's connections (accept, read, write) from a hook that runs on that thread after
+//! every wakeup.
+class ShardedTCPRuntime {
+  public:
+    using Packet = std::pair<FourTuple, TCPSegment>;  //!< A segment and the connection it belongs to
+
+    class Shard;
+
+    //! Called on a shard's thread with each segment the shard wants sent
+    using SinkT = std::function<void(Shard &shard, const FourTuple &tuple, TCPSegment &&seg)>;
+
+    //! Called on a shard's thread after it has processed inbound segments and timers
+    using HookT = std::function<void(Shard &shard)>;
+
+    static constexpr size_t INDIRECTION_TABLE_SIZE = 128;  //!< Entries in the RSS indirection table
+
+    //! One thread's share of the stack
+    class Shard {
+        friend class ShardedTCPRuntime;
+
+      private:
+        size_t _index;
+        TCPListener _listener;
+        EventLoop _eventloop{};
+        FileDescriptor _doorbell;  //!< eventfd that wakes the shard's thread
+        std::vector<std::unique_ptr<SPSCRing<Packet>>> _inboxes{};  //!< One ring per producer
+        std::atomic<bool> _sleeping{false};    //!< Shard may be blocked in poll()
+        std::atomic<uint64_t> _ring_drops{0};  //!< Segments dropped because a ring was full
+        uint64_t _segments_received{0};
+        std::thread _thread{};
+
+      public:
+        //! Construct the shard numbered `index`
+        Shard(const size_t index, const ShardedRuntimeConfig &cfg);
+
+        size_t index() const { return _index; }                             //!< Which shard this is
+        TCPListener &listener() { return _listener; }                        //!< The shard's connections
+        uint64_t segments_received() const { return _segments_received; }  //!< Segments processed
+        uint64_t ring_drops() const { return _ring_drops.load(); }          //!< Segments dropped at delivery
+    };
+
+  private:
+    ShardedRuntimeConfig _cfg;
+    ToeplitzHash _hash{};
+    std::array<uint16_t, INDIRECTION_TABLE_SIZE> _indirection{};  //!< Hash bucket to shard
+    std::vector<std::unique_ptr<Shard>> _shards{};
+    SinkT _sink;
+    HookT _hook;
+    std::atomic<bool> _running{false};
+
+    //! Main loop of a shard's thread
+    void _shard_main(Shard &shard);
+
+    //! Wake a shard's thread
+    static void _ring_doorbell(Shard &shard);
+
+  public:
+    //! Construct the shards (their threads are started by start())
+    ShardedTCPRuntime(const ShardedRuntimeConfig &cfg, const SinkT &sink, const HookT &hook = {});
+
+    //! Stops the shards' threads
+    ~ShardedTCPRuntime();
+
+    //! \brief Start one thread per shard
+    void start();
+
+    //! \brief Stop and join the shards' threads
+    void stop();
+
+    //! \brief The shard that handles segments of the connection `tuple`
+    size_t shard_for(const FourTuple &tuple) const;
+
+    //! \brief Hand an inbound segment to the shard that owns its connection
+    //! \param[in] producer identifies the calling thread (less than ShardedRuntimeConfig::num_producers);
+    //!            no two threads may use the same producer concurrently
+    //! \returns `false` if the segment was dropped because the shard is not keeping up
+    bool deliver(const size_t producer, const FourTuple &tuple, TCPSegment &&seg);
+
+    size_t num_shards() const { return _shards.size(); }             //!< Number of shards
+    Shard &shard(const size_t index) { return *_shards.at(index); }  //!< Access a shard
+
+    //! \name
+    //! The shards' threads refer to this object, so it cannot be moved or copied
+
+    //!@{
+    ShardedTCPRuntime(const ShardedTCPRuntime &) = delete;
+    ShardedTCPRuntime &operator=(const ShardedTCPRuntime &) = delete;
+    ShardedTCPRuntime(ShardedTCPRuntime &&) = delete;
+    ShardedTCPRuntime &operator=(ShardedTCPRuntime &&) = delete;
+    //!@}
+};
+
+#endif  // SPONGE_LIBSPONGE_SHARDED_TCP_RUNTIME_HH
@@ -0,0 +1,108 @@
+#include "syn_cookie.hh"
+
+#include "util.hh"
+
+using namespace std;
+
+static inline uint64_t rotl(const uint64_t x, const int b) { return (x << b) | (x >> (64 - b)); }
+
+//! SipHash-2-4 of a sequence of 64-bit words
+template <size_t N>
+static uint64_t siphash24(const array<uint64_t, 2> &key, const array<uint64_t, N> &words) {
+    uint64_t v0 = 0x736f6d6570736575ULL ^ key[0];
+    uint64_t v1 = 0x646f72616e646f6dULL ^ key[1];
+    uint64_t v2 = 0x6c7967656e657261ULL ^ key[0];
+    uint64_t v3 = 0x7465646279746573ULL ^ key[1];
+
+    auto sipround = [&] {
+        v0 += v1;
+        v1 = rotl(v1, 13);
+        v1 ^= v0;
+        v0 = rotl(v0, 32);
+        v2 += v3;
+        v3 = rotl(v3, 16);
+        v3 ^= v2;
+        v0 += v3;
+        v3 = rotl(v3, 21);
+        v3 ^= v0;
+        v2 += v1;
+        v1 = rotl(v1, 17);
+        v1 ^= v2;
+        v2 = rotl(v2, 32);
+    };
+
+    for (const uint64_t m : words) {
+        v3 ^= m;
+        sipround();
+        sipround();
+        v0 ^= m;
+    }
+
+    const uint64_t last = uint64_t{N * 8} << 56;
+    v3 ^= last;
+    sipround();
+    sipround();
+    v0 ^= last;
+
+    v2 ^= 0xff;
+    sipround();
+    sipround();
+    sipround();
+    sipround();
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+
+SYNCookieCodec::SYNCookieCodec() : _key() {
+    auto rd = get_random_generator();
+    for (auto &word : _key) {
+        word = (uint64_t{rd()} << 32) | rd();
+    }
+}
+
+uint32_t SYNCookieCodec::_hash(const FourTuple &tuple, const WrappingInt32 peer_isn, const uint64_t counter) const {
+    const array<uint64_t, 3> words{{(uint64_t{tuple.local_address} << 32) | tuple.remote_address,
+                                    (uint64_t{tuple.local_port} << 48) | (uint64_t{tuple.remote_port} << 32) |
+                                        peer_isn.raw_value(),
+                                    counter}};
+    return siphash24(_key, words) & 0xffffff;
+}
+
+//! \param[in] tuple identifies the connection being opened
+//! \param[in] peer_isn is the sequence number of the peer's SYN
+//! \param[in] mss is the maximum segment size to remember (rounded down to an entry of MSS_TABLE)
+//! \param[in] now_ms is the listener's current time
+//! \returns the ISN to use for our SYN-ACK
+WrappingInt32 SYNCookieCodec::encode(const FourTuple &tuple,
+                                     const WrappingInt32 peer_isn,
+                                     const uint16_t mss,
+                                     const uint64_t now_ms) const {
+    const uint64_t counter = now_ms / COUNTER_PERIOD_MS;
+
+    uint32_t mss_index = 0;
+    while (mss_index + 1 < MSS_TABLE.size() and MSS_TABLE[mss_index + 1] <= mss) {
+        mss_index++;
+    }
+
+    return WrappingInt32{(uint32_t(counter & 0x1f) << 27) | (mss_index << 24) | _hash(tuple, peer_isn, counter)};
+}
+
+//! \param[in] tuple identifies the connection being completed
+//! \param[in] peer_isn is the sequence number of the peer's SYN (i.e. the ACK's seqno minus one)
+//! \param[in] cookie is the ISN that we sent in our SYN-ACK (i.e. the ACK's ackno minus one)
+//! \param[in] now_ms is the listener's current time
+optional<uint16_t> SYNCookieCodec::decode(const FourTuple &tuple,
+                                          const WrappingInt32 peer_isn,
+                                          const WrappingInt32 cookie,
+                                          const uint64_t now_ms) const {
+    const uint64_t current = now_ms / COUNTER_PERIOD_MS;
+    const uint32_t age = (current - (cookie.raw_value() >> 27)) & 0x1f;
+    if (age > MAX_COUNTER_AGE or age > current) {
+        return {};
+    }
+
+    if ((cookie.raw_value() & 0xffffff) != _hash(tuple, peer_isn, current - age)) {
+        return {};
+    }
+
+    return MSS_TABLE[(cookie.raw_value() >> 24) & 0x7];
+}
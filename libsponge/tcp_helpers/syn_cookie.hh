@@ -0,0 +1,60 @@
+#ifndef SPONGE_LIBSPONGE_SYN_COOKIE_HH
+#define SPONGE_LIBSPONGE_SYN_COOKIE_HH
+
+#include "four_tuple.hh"
+#include "wrapping_integers.hh"
+
+#include <array>
+#include <cstdint>
+#include <optional>
+
+//! \brief Encodes and validates [SYN cookies](https://cr.yp.to/syncookies.html)
+//! \details A SYN cookie is an initial sequence number that carries all of the state a listener
+//! would otherwise keep for a half-open connection, so that nothing has to be allocated until
+//! the peer's final ACK (whose ackno is the cookie plus one) comes back.
+//!
+//! ~~~{.txt}
+//!   31      27 26  24 23                                           0
+//!  +----------+------+----------------------------------------------+
+//!  | counter  | MSS  |     keyed hash of (4-tuple, peer ISN, counter) |
+//!  +----------+------+----------------------------------------------+
+//! ~~~
+//!
+//! `counter` is a coarse timestamp (one tick per COUNTER_PERIOD_MS, mod 32) and `MSS` is an
+//! index into MSS_TABLE. The hash is SipHash-2-4 under a per-codec random key.
+class SYNCookieCodec {
+  public:
+    static constexpr uint64_t COUNTER_PERIOD_MS = 64 * 1000;  //!< Length of one counter tick
+    static constexpr uint32_t MAX_COUNTER_AGE = 2;            //!< Oldest accepted cookie, in counter ticks
+
+    //! MSS values that can be represented by the three-bit MSS index
+    static constexpr std::array<uint16_t, 8> MSS_TABLE{{536, 1000, 1220, 1360, 1440, 1460, 4312, 8960}};
+
+  private:
+    std::array<uint64_t, 2> _key;  //!< SipHash key
+
+    //! 24-bit keyed hash over the connection identity and the counter
+    uint32_t _hash(const FourTuple &tuple, const WrappingInt32 peer_isn, const uint64_t counter) const;
+
+  public:
+    //! Construct with a random key
+    SYNCookieCodec();
+
+    //! Construct with a fixed key (for testing)
+    explicit SYNCookieCodec(const std::array<uint64_t, 2> &key) : _key(key) {}
+
+    //! \brief Compute the ISN to send in a SYN-ACK answering the peer's SYN
+    WrappingInt32 encode(const FourTuple &tuple,
+                         const WrappingInt32 peer_isn,
+                         const uint16_t mss,
+                         const uint64_t now_ms) const;
+
+    //! \brief Check the cookie echoed back by the peer's ACK
+    //! \returns the MSS that was encoded in the cookie, or empty if the cookie is stale or forged
+    std::optional<uint16_t> decode(const FourTuple &tuple,
+                                   const WrappingInt32 peer_isn,
+                                   const WrappingInt32 cookie,
+                                   const uint64_t now_ms) const;
+};
+
+#endif  // SPONGE_LIBSPONGE_SYN_COOKIE_HH
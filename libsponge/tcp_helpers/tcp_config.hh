@@ -27,6 +27,29 @@ class TCPConfig {
     std::optional<WrappingInt32> fixed_isn{};
 };
 
+//! Config for TCPListener
+class TCPListenerConfig {
+  public:
+    static constexpr size_t DEFAULT_SYN_QUEUE_CAPACITY = 256;  //!< Default maximum number of half-open connections
+
+    size_t syn_queue_capacity = DEFAULT_SYN_QUEUE_CAPACITY;  //!< Half-open connections kept before SYNs are dropped
+    //! SYN-queue occupancy at which the listener stops allocating state and answers with SYN cookies
+    size_t syn_cookie_threshold = DEFAULT_SYN_QUEUE_CAPACITY * 3 / 4;
+    uint16_t mss = TCPConfig::MAX_PAYLOAD_SIZE;  //!< Maximum segment size encoded into SYN cookies
+};
+
+//! Config for ShardedTCPRuntime
+class ShardedRuntimeConfig {
+  public:
+    static constexpr size_t DEFAULT_RING_CAPACITY = 4096;  //!< Default number of segments queued per ring
+
+    size_t num_shards = 1;     //!< Number of shards, each run by its own thread
+    size_t num_producers = 1;  //!< Number of threads that may deliver segments concurrently
+    size_t ring_capacity = DEFAULT_RING_CAPACITY;  //!< Segments queued per (producer, shard) before drops
+    TCPConfig tcp{};                               //!< Configuration of each connection
+    TCPListenerConfig listener{};                  //!< Configuration of each shard's listener
+};
+
 //! Config for classes derived from FdAdapter
 class FdAdapterConfig {
   public:
@@ -4,10 +4,14 @@
 #include "parser.hh"
 #include "wrapping_integers.hh"
 
+#include <optional>
+#include <string_view>
+
 //! \brief [TCP](\ref rfc::rfc793) segment header
 //! \note TCP options are not supported
 struct TCPHeader {
     static constexpr size_t LENGTH = 20;  //!< [TCP](\ref rfc::rfc793) header length, not including options
+    static constexpr size_t CKSUM_OFFSET = 16;  //!< Where the checksum is in the header
 
     //! \struct TCPHeader
     //! ~~~{.txt}
@@ -56,6 +60,9 @@ struct TCPHeader {
     //! Serialize the TCP fields
     std::string serialize() const;
 
+    //! Serialize the TCP fields in place, into the `4 * doff` bytes at `dst`
+    void serialize_into(char *dst) const;
+
     //! Return a string containing a header in human-readable format
     std::string to_string() const;
 
@@ -65,4 +72,39 @@ struct TCPHeader {
     bool operator==(const TCPHeader &other) const;
 };
 
+//! \brief A view of the TCP header at the start of a raw segment (see HeaderView)
+//! \details Meant for looking at a few fields (e.g. the ports) before, or instead of, parsing the
+//! segment into a TCPHeader. The checksum is not checked.
+class TCPHeaderView : public HeaderView<TCPHeader::LENGTH> {
+  private:
+    using HeaderView::HeaderView;
+
+    //! Is flag `mask` (in byte 13 of the header) set?
+    bool flag(const uint8_t mask) const { return field<13, uint8_t>() & mask; }
+
+  public:
+    //! \brief View the header of `segment`
+    //! \returns nothing if `segment` is too short for its header
+    static std::optional<TCPHeaderView> from(const std::string_view segment);
+
+    //! \name TCP header fields
+    //!@{
+    uint16_t sport() const { return field<0, uint16_t>(); }
+    uint16_t dport() const { return field<2, uint16_t>(); }
+    WrappingInt32 seqno() const { return WrappingInt32{field<4, uint32_t>()}; }
+    WrappingInt32 ackno() const { return WrappingInt32{field<8, uint32_t>()}; }
+    uint8_t doff() const { return field<12, uint8_t>() >> 4; }
+    bool urg() const { return flag(0b0010'0000); }
+    bool ack() const { return flag(0b0001'0000); }
+    bool psh() const { return flag(0b0000'1000); }
+    bool rst() const { return flag(0b0000'0100); }
+    bool syn() const { return flag(0b0000'0010); }
+    bool fin() const { return flag(0b0000'0001); }
+    uint16_t win() const { return field<14, uint16_t>(); }
+    //!@}
+
+    //! The bytes that follow the header
+    std::string_view payload() const { return _bytes.substr(4 * doff()); }
+};
+
 #endif  // SPONGE_LIBSPONGE_TCP_HEADER_HH
@@ -23,31 +23,39 @@ using namespace std;
 //! `_listen` flag and records the source and destination addresses and port numbers
 //! from the TCP header; it uses this information to filter future reads.
 //! \returns a std::optional<TCPSegment> that is empty if the segment was invalid or unrelated
-optional<TCPSegment> TCPOverIPv4Adapter::unwrap_tcp_in_ip(const InternetDatagram &ip_dgram) {
+optional<TCPSegment> TCPOverIPv4Adapter::unwrap_tcp_in_ip(const InternetDatagram &ip_dgram,
+                                                          const bool checksum_verified) {
     // is the IPv4 datagram for us?
     // Note: it's valid to bind to address "0" (INADDR_ANY) and reply from actual address contacted
     if (not listening() and (ip_dgram.header().dst != config().source.ipv4_numeric())) {
+        count_drop(Drop::OtherAddress);
         return {};
     }
 
     // is the IPv4 datagram from our peer?
     if (not listening() and (ip_dgram.header().src != config().destination.ipv4_numeric())) {
+        count_drop(Drop::OtherAddress);
         return {};
     }
 
     // does the IPv4 datagram claim that its payload is a TCP segment?
     if (ip_dgram.header().proto != IPv4Header::PROTO_TCP) {
+        count_drop(Drop::NotTCP);
         return {};
     }
 
     // is the payload a valid TCP segment?
     TCPSegment tcp_seg;
-    if (ParseResult::NoError != tcp_seg.parse(ip_dgram.payload(), ip_dgram.header().pseudo_cksum())) {
+    const ParseResult result =
+        tcp_seg.parse(ip_dgram.payload(), ip_dgram.header().pseudo_cksum(), checksum_verified);
+    if (result != ParseResult::NoError) {
+        count_drop(result == ParseResult::BadChecksum ? Drop::BadChecksum : Drop::Malformed);
         return {};
     }
 
     // is the TCP segment for us?
     if (tcp_seg.header().dport != config().source.port()) {
+        count_drop(Drop::OtherPort);
         return {};
     }
 
@@ -58,21 +66,103 @@ optional<TCPSegment> TCPOverIPv4Adapter::unwrap_tcp_in_ip(const InternetDatagram
             config_mutable().destination = {inet_ntoa({htobe32(ip_dgram.header().src)}), tcp_seg.header().sport};
             set_listening(false);
         } else {
+            count_drop(Drop::NotSYN);
             return {};
         }
     }
 
     // is the TCP segment from our peer?
     if (tcp_seg.header().sport != config().destination.port()) {
+        count_drop(Drop::OtherPort);
         return {};
     }
 
     return tcp_seg;
 }
 
+//! \param[in] datagram is a raw IPv4 datagram
+optional<TCPOverIPv4Adapter::Drop> TCPOverIPv4Adapter::early_demux(const string_view datagram) const {
+    const auto ip_header = IPv4HeaderView::from(datagram);
+    if (not ip_header) {
+        return Drop::Malformed;
+    }
+    if (ip_header->proto() != IPv4Header::PROTO_TCP) {
+        return Drop::NotTCP;
+    }
+    const auto tcp_header = TCPHeaderView::from(ip_header->payload());
+    if (not tcp_header) {
+        return Drop::Malformed;
+    }
+    if (tcp_header->dport() != config().source.port()) {
+        return Drop::OtherPort;
+    }
+
+    // while listening, only a SYN (from anywhere) will do
+    if (listening()) {
+        if (tcp_header->syn() and not tcp_header->rst()) {
+            return {};
+        }
+        return Drop::NotSYN;
+    }
+    if (ip_header->dst() != config().source.ipv4_numeric() or
+        ip_header->src() != config().destination.ipv4_numeric()) {
+        return Drop::OtherAddress;
+    }
+    if (tcp_header->sport() != config().destination.port()) {
+        return Drop::OtherPort;
+    }
+    return {};
+}
+
+//! \param[in] raw_datagram is the datagram as read from the network
+//! \param[in] checksum_verified is `true` if the TCP checksum need not be checked
+optional<TCPSegment> TCPOverIPv4Adapter::receive(const Buffer &raw_datagram, const bool checksum_verified) {
+    // stage 1: is it for this connection at all?
+    if (const auto drop = early_demux(raw_datagram)) {
+        count_drop(*drop);
+        return {};
+    }
+
+    // stage 2: parse and checksum it
+    InternetDatagram ip_dgram;
+    const ParseResult result = ip_dgram.parse(raw_datagram);
+    if (result != ParseResult::NoError) {
+        count_drop(result == ParseResult::BadChecksum ? Drop::BadChecksum : Drop::Malformed);
+        return {};
+    }
+    return unwrap_tcp_in_ip(ip_dgram, checksum_verified);
+}
+
 //! Takes a TCP segment, sets port numbers as necessary, and wraps it in an IPv4 datagram
 //! \param[in] seg is the TCP segment to convert
-InternetDatagram TCPOverIPv4Adapter::wrap_tcp_in_ip(TCPSegment &seg) {
+//! \param[in] checksum_offload is `true` to leave the TCP checksum for the kernel or NIC to complete
+InternetDatagram TCPOverIPv4Adapter::wrap_tcp_in_ip(TCPSegment &seg, const bool checksum_offload) {
+    InternetDatagram ip_dgram = datagram_for(seg);
+
+    // set payload, calculating TCP checksum using information from IP header
+    if (checksum_offload) {
+        ip_dgram.payload() = seg.serialize_for_checksum_offload(ip_dgram.header().pseudo_cksum());
+    } else {
+        ip_dgram.payload() = seg.serialize(ip_dgram.header().pseudo_cksum());
+    }
+
+    return ip_dgram;
+}
+
+//! \details The payload is copied once, into a PacketBuffer with room for every header, and the TCP
+//! and IP headers are then written in front of it, so the datagram can go out in a single write(2).
+//! \param[in] seg is the TCP segment to convert
+//! \param[in] headroom is room to leave in front of the datagram
+PacketBuffer TCPOverIPv4Adapter::wrap_tcp_in_ip_packet(TCPSegment &seg, const size_t headroom) {
+    const InternetDatagram ip_dgram = datagram_for(seg);
+
+    PacketBuffer packet{headroom + 4 * ip_dgram.header().hlen + 4 * seg.header().doff, seg.payload()};
+    seg.serialize_into(packet, ip_dgram.header().pseudo_cksum());
+    ip_dgram.serialize_into(packet);
+    return packet;
+}
+
+InternetDatagram TCPOverIPv4Adapter::datagram_for(TCPSegment &seg) {
     // set the port numbers in the TCP segment
     seg.header().sport = config().source.port();
     seg.header().dport = config().destination.port();
@@ -82,9 +172,38 @@ InternetDatagram TCPOverIPv4Adapter::wrap_tcp_in_ip(TCPSegment &seg) {
     ip_dgram.header().src = config().source.ipv4_numeric();
     ip_dgram.header().dst = config().destination.ipv4_numeric();
     ip_dgram.header().len = ip_dgram.header().hlen * 4 + seg.header().doff * 4 + seg.payload().size();
+    return ip_dgram;
+}
 
-    // set payload, calculating TCP checksum using information from IP header
-    ip_dgram.payload() = seg.serialize(ip_dgram.header().pseudo_cksum());
+//! \details Unlike TCPOverIPv4Adapter::unwrap_tcp_in_ip, this does not filter by connection, so
+//! it suits a stack that handles many connections (e.g. a TCPListener).
+//! \param[in] ip_dgram is the datagram to parse
+//! \param[out] tuple is set to the segment's connection, from the receiver's point of view
+optional<TCPSegment> tcp_segment_from_ip(const InternetDatagram &ip_dgram, FourTuple &tuple) {
+    if (ip_dgram.header().proto != IPv4Header::PROTO_TCP) {
+        return {};
+    }
 
+    TCPSegment tcp_seg;
+    if (ParseResult::NoError != tcp_seg.parse(ip_dgram.payload(), ip_dgram.header().pseudo_cksum())) {
+        return {};
+    }
+
+    tuple = {ip_dgram.header().dst, tcp_seg.header().dport, ip_dgram.header().src, tcp_seg.header().sport};
+    return tcp_seg;
+}
+
+//! \param[in] tuple is the connection the segment belongs to, from the sender's point of view
+//! \param[in] seg is the TCP segment to convert
+InternetDatagram tcp_segment_to_ip(const FourTuple &tuple, TCPSegment &seg) {
+    seg.header().sport = tuple.local_port;
+    seg.header().dport = tuple.remote_port;
+
+    InternetDatagram ip_dgram;
+    ip_dgram.header().src = tuple.local_address;
+    ip_dgram.header().dst = tuple.remote_address;
+    ip_dgram.header().len = ip_dgram.header().hlen * 4 + seg.header().doff * 4 + seg.payload().size();
+
+    ip_dgram.payload() = seg.serialize(ip_dgram.header().pseudo_cksum());
     return ip_dgram;
 }
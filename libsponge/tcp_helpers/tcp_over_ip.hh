@@ -3,17 +3,76 @@
 
 #include "buffer.hh"
 #include "fd_adapter.hh"
+#include "four_tuple.hh"
 #include "ipv4_datagram.hh"
 #include "tcp_segment.hh"
 
+#include <array>
+#include <cstdint>
 #include <optional>
+#include <string_view>
 
 //! \brief A converter from TCP segments to serialized IPv4 datagrams
+//! \details Received datagrams go through two stages (see receive()): a match of the connection's
+//! addresses and ports against the raw header bytes, and then, only for datagrams that pass, the
+//! full parse and checksum. Each dropped datagram is counted under the reason it was dropped.
 class TCPOverIPv4Adapter : public FdAdapterBase {
   public:
-    std::optional<TCPSegment> unwrap_tcp_in_ip(const InternetDatagram &ip_dgram);
+    //! Why a received datagram was dropped
+    enum class Drop {
+        Malformed,     //!< Not a well-formed IPv4 datagram carrying a TCP segment
+        NotTCP,        //!< Carries a protocol other than TCP
+        OtherAddress,  //!< From or to an address other than the connection's
+        OtherPort,     //!< From or to a port other than the connection's
+        NotSYN,        //!< Not a SYN, while listening
+        BadChecksum,   //!< Matched the connection, but failed the IPv4 or TCP checksum
+        Count          //!< (the number of reasons)
+    };
 
-    InternetDatagram wrap_tcp_in_ip(TCPSegment &seg);
+  private:
+    std::array<uint64_t, size_t(Drop::Count)> _drops{};  //!< Datagrams dropped, by reason
+
+  protected:
+    //! Count a datagram dropped for `reason`
+    void count_drop(const Drop reason) { _drops[size_t(reason)]++; }
+
+  public:
+    //! \param[in] checksum_verified is `true` if the TCP checksum need not be checked (see TCPSegment::parse)
+    std::optional<TCPSegment> unwrap_tcp_in_ip(const InternetDatagram &ip_dgram,
+                                               const bool checksum_verified = false);
+
+    //! \brief First stage of receive(): might a raw IPv4 datagram carry a segment for the current connection?
+    //! \details Makes the address, protocol and port checks of unwrap_tcp_in_ip() through header views,
+    //! so that unrelated traffic is dropped before anything is parsed, allocated or checksummed
+    //! \returns why the datagram should be dropped, or nothing if it should go on to the second stage
+    std::optional<Drop> early_demux(const std::string_view datagram) const;
+
+    //! \brief Receive a raw IPv4 datagram: early_demux(), then (if it passes) parse, checksum and unwrap_tcp_in_ip()
+    //! \param[in] checksum_verified is `true` if the TCP checksum need not be checked (see TCPSegment::parse)
+    std::optional<TCPSegment> receive(const Buffer &raw_datagram, const bool checksum_verified = false);
+
+    //! Number of received datagrams dropped for `reason`
+    uint64_t dropped(const Drop reason) const { return _drops[size_t(reason)]; }
+
+    //! \param[in] checksum_offload is `true` to leave the TCP checksum to be completed by the kernel or NIC
+    //! (see TCPSegment::serialize_for_checksum_offload)
+    InternetDatagram wrap_tcp_in_ip(TCPSegment &seg, const bool checksum_offload = false);
+
+    //! \brief Like wrap_tcp_in_ip, but serializes the datagram in place, as one contiguous PacketBuffer
+    //! \param[in] headroom is room to leave in front of the datagram (e.g. for an Ethernet header)
+    PacketBuffer wrap_tcp_in_ip_packet(TCPSegment &seg, const size_t headroom = 0);
+
+  private:
+    //! Sets the segment's port numbers, and makes an (empty) IPv4 datagram to carry it
+    InternetDatagram datagram_for(TCPSegment &seg);
 };
 
+//! \brief Parse the TCP segment carried by an IPv4 datagram, whichever connection it belongs to
+//! \param[out] tuple is set to the segment's connection, from the receiver's point of view
+//! \returns the segment, or empty if the datagram does not carry a valid TCP segment
+std::optional<TCPSegment> tcp_segment_from_ip(const InternetDatagram &ip_dgram, FourTuple &tuple);
+
+//! \brief Set a segment's ports from the connection it belongs to, and wrap it in an IPv4 datagram
+InternetDatagram tcp_segment_to_ip(const FourTuple &tuple, TCPSegment &seg);
+
 #endif  // SPONGE_LIBSPONGE_TCP_OVER_IP_HH
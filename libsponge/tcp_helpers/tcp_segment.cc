@@ -3,18 +3,24 @@
 #include "parser.hh"
 #include "util.hh"
 
+#include <stdexcept>
 #include <variant>
 
 using namespace std;
 
 //! \param[in] buffer string/Buffer to be parsed
 //! \param[in] datagram_layer_checksum pseudo-checksum from the lower-layer protocol
-ParseResult TCPSegment::parse(const Buffer buffer, const uint32_t datagram_layer_checksum) {
+//! \param[in] checksum_verified is `true` to skip checking the checksum
+ParseResult TCPSegment::parse(const Buffer buffer,
+                              const uint32_t datagram_layer_checksum,
+                              const bool checksum_verified) {
     // 对buffer内容计算校验和,与下面一层传入的校验和进行比对,如果不一致直接返回
-    InternetChecksum check(datagram_layer_checksum);
-    check.add(buffer);
-    if (check.value()) {
-        return ParseResult::BadChecksum;
+    if (not checksum_verified) {
+        InternetChecksum check(datagram_layer_checksum);
+        check.add(buffer);
+        if (check.value()) {
+            return ParseResult::BadChecksum;
+        }
     }
     // 解析拿到tcp协议请求头和请求体
     NetParser p{buffer};
@@ -30,21 +36,65 @@ size_t TCPSegment::length_in_sequence_space() const {
 
 //! \param[in] datagram_layer_checksum pseudo-checksum from the lower-layer protocol
 BufferList TCPSegment::serialize(const uint32_t datagram_layer_checksum) const {
-    // 拿到TCP请求头  
+    // 先以校验和为0序列化TCP首部, 算出校验和后直接写回首部中的校验和字段
     TCPHeader header_out = _header;
     header_out.cksum = 0;
+    string header = header_out.serialize();
 
     // calculate checksum -- taken over entire segment
     // 计算TCP报文的校验和 --- 如果TCP报文校验和与传入的校验和计算一致,那么check.value()返回值应该为0
-    InternetChecksum check(datagram_layer_checksum);
-    check.add(header_out.serialize());
-    check.add(_payload);
-    header_out.cksum = check.value();
+    NetUnparser::u16(header.data() + TCPHeader::CKSUM_OFFSET, checksum(datagram_layer_checksum, header));
 
     // 将TCP报文添加到BufferList中
     BufferList ret;
-    ret.append(header_out.serialize());
+    ret.append(move(header));
     ret.append(_payload);
 
     return ret;
 }
+
+//! \param[in] datagram_layer_checksum pseudo-checksum from the lower-layer protocol
+BufferList TCPSegment::serialize_for_checksum_offload(const uint32_t datagram_layer_checksum) const {
+    // store the pseudo-header's sum, folded but not complemented, for the offload to add the segment to
+    TCPHeader header_out = _header;
+    header_out.cksum = uint16_t(~InternetChecksum(datagram_layer_checksum).value());
+
+    BufferList ret;
+    ret.append(header_out.serialize());
+    ret.append(_payload);
+    return ret;
+}
+
+//! \param[in,out] packet holds the payload (a copy of payload()), and gets the header in front of it
+//! \param[in] datagram_layer_checksum pseudo-checksum from the lower-layer protocol
+//! \param[in] checksum_offload is `true` to leave the checksum for the kernel or NIC to complete
+void TCPSegment::serialize_into(PacketBuffer &packet,
+                                const uint32_t datagram_layer_checksum,
+                                const bool checksum_offload) const {
+    if (packet.size() != _payload.size()) {
+        throw runtime_error("TCPSegment::serialize_into: packet does not hold the payload");
+    }
+
+    TCPHeader header_out = _header;
+    header_out.cksum = checksum_offload ? uint16_t(~InternetChecksum(datagram_layer_checksum).value()) : 0;
+    char *header = packet.prepend(4 * header_out.doff);
+    header_out.serialize_into(header);
+    if (not checksum_offload) {
+        NetUnparser::u16(header + TCPHeader::CKSUM_OFFSET,
+                         checksum(datagram_layer_checksum, {header, size_t(4 * header_out.doff)}));
+    }
+}
+
+//! \param[in] datagram_layer_checksum pseudo-checksum from the lower-layer protocol
+//! \param[in] header is the serialized header, with a checksum of 0
+uint16_t TCPSegment::checksum(const uint32_t datagram_layer_checksum, const string_view header) const {
+    InternetChecksum check(datagram_layer_checksum);
+    check.add(header);
+    // 若payload的部分和已在复制时算出(见ByteStream::read_checksummed),直接使用,不再遍历payload
+    if (const auto payload_sum = _payload.cksum_partial()) {
+        check.add_sum(*payload_sum, _payload.size());
+    } else {
+        check.add(_payload);
+    }
+    return check.value();
+}
@@ -2,9 +2,11 @@
 #define SPONGE_LIBSPONGE_TCP_SEGMENT_HH
 
 #include "buffer.hh"
+#include "packet_buffer.hh"
 #include "tcp_header.hh"
 
 #include <cstdint>
+#include <string_view>
 
 //! \brief [TCP](\ref rfc::rfc793) segment
 class TCPSegment {
@@ -13,13 +15,31 @@ class TCPSegment {
     // Buffer就是对String字符串相关操作的封装
     Buffer _payload{};
 
+    //! The segment's checksum, given its serialized header
+    uint16_t checksum(const uint32_t datagram_layer_checksum, const std::string_view header) const;
+
   public:
     //! \brief Parse the segment from a string
-    ParseResult parse(const Buffer buffer, const uint32_t datagram_layer_checksum = 0);
+    //! \details With `checksum_verified`, the checksum is not checked (e.g. because a kernel doing
+    //! checksum offload has vouched for the segment, or has left the checksum for the NIC to fill in)
+    ParseResult parse(const Buffer buffer,
+                      const uint32_t datagram_layer_checksum = 0,
+                      const bool checksum_verified = false);
 
     //! \brief Serialize the segment to a string
     BufferList serialize(const uint32_t datagram_layer_checksum = 0) const;
 
+    //! \brief Serialize the segment for checksum offload
+    //! \details The checksum field holds only the lower layer's contribution to the checksum, and
+    //! whoever completes the checksum (e.g. a kernel told VirtioNetHeader::F_NEEDS_CSUM) adds the rest.
+    BufferList serialize_for_checksum_offload(const uint32_t datagram_layer_checksum) const;
+
+    //! \brief Serialize the segment in place, prepending the header to a `packet` that holds the payload
+    //! \details With `checksum_offload`, the checksum is left as serialize_for_checksum_offload() leaves it
+    void serialize_into(PacketBuffer &packet,
+                        const uint32_t datagram_layer_checksum = 0,
+                        const bool checksum_offload = false) const;
+
     //! \name Accessors
     //!@{
     const TCPHeader &header() const { return _header; }
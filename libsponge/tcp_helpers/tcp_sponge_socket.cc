@@ -41,11 +41,14 @@ void TCPSpongeSocket<AdaptT>::_tcp_loop(const function<bool()> &condition) {
 
 //! \param[in] data_socket_pair is a pair of connected AF_UNIX SOCK_STREAM sockets
 //! \param[in] datagram_interface is the interface for reading and writing datagrams
+//! \param[in] channel selects how bytes travel between the owner and the TCP thread
 template <typename AdaptT>
 TCPSpongeSocket<AdaptT>::TCPSpongeSocket(pair<FileDescriptor, FileDescriptor> data_socket_pair,
-                                         AdaptT &&datagram_interface)
+                                         AdaptT &&datagram_interface,
+                                         const DataChannel channel)
     : LocalStreamSocket(move(data_socket_pair.first))
     , _thread_data(move(data_socket_pair.second))
+    , _shm(channel == DataChannel::SharedMemory ? make_unique<SharedMemoryChannel>(SHM_RING_CAPACITY) : nullptr)
     , _datagram_adapter(move(datagram_interface)) {
     _thread_data.set_blocking(false);
 }
@@ -77,13 +80,16 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
         _datagram_adapter,
         Direction::In,
         [&] {
-            auto seg = _datagram_adapter.read();
-            if (seg) {
-                _tcp->segment_received(move(seg.value()));
-            }
+            // the adapter may have received a batch of datagrams; hand all of them to the TCPConnection
+            do {
+                auto seg = _datagram_adapter.read();
+                if (seg) {
+                    _tcp->segment_received(move(seg.value()));
+                }
+            } while (_datagram_adapter.has_pending_reads() and _tcp->active());
 
             // debugging output:
-            if (_thread_data.eof() and _tcp.value().bytes_in_flight() == 0 and not _fully_acked) {
+            if (_outbound_eof() and _tcp.value().bytes_in_flight() == 0 and not _fully_acked) {
                 cerr << "DEBUG: Outbound stream to " << _datagram_adapter.config().destination.to_string()
                      << " has been fully acknowledged.\n";
                 _fully_acked = true;
@@ -91,6 +97,29 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
         },
         [&] { return _tcp->active(); });
 
+    // rules 2 and 3 depend on how bytes reach the owner
+    if (_shm) {
+        _add_shared_memory_rules();
+    } else {
+        _add_socket_pair_rules();
+    }
+
+    // rule 4: read outbound segments from TCPConnection and send as datagrams
+    _eventloop.add_rule(
+        _datagram_adapter,
+        Direction::Out,
+        [&] {
+            while (not _tcp->segments_out().empty()) {
+                _datagram_adapter.write(_tcp->segments_out().front());
+                _tcp->segments_out().pop();
+            }
+            _datagram_adapter.flush();
+        },
+        [&] { return not _tcp->segments_out().empty(); });
+}
+
+template <typename AdaptT>
+void TCPSpongeSocket<AdaptT>::_add_socket_pair_rules() {
     // rule 2: read from pipe into outbound buffer
     _eventloop.add_rule(
         _thread_data,
@@ -149,18 +178,83 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
             return (not _tcp->inbound_stream().buffer_empty()) or
                    ((_tcp->inbound_stream().eof() or _tcp->inbound_stream().error()) and not _inbound_shutdown);
         });
+}
 
-    // rule 4: read outbound segments from TCPConnection and send as datagrams
+template <typename AdaptT>
+void TCPSpongeSocket<AdaptT>::_add_shared_memory_rules() {
+    // rule 2: read from the outbound ring into the outbound buffer
     _eventloop.add_rule(
-        _datagram_adapter,
-        Direction::Out,
+        _shm->outbound.data_doorbell(),
+        Direction::In,
         [&] {
-            while (not _tcp->segments_out().empty()) {
-                _datagram_adapter.write(_tcp->segments_out().front());
-                _tcp->segments_out().pop();
+            _shm->outbound.clear_data_doorbell();
+            string data;
+            _shm->outbound.read(data, _tcp->remaining_outbound_capacity());
+            const auto len = data.size();
+            const auto amount_written = _tcp->write(data);
+            if (amount_written != len) {
+                throw runtime_error("TCPConnection::write() accepted less than advertised length");
+            }
+
+            if (_shm->outbound.eof()) {
+                _tcp->end_input_stream();
+                _outbound_shutdown = true;
+
+                // debugging output:
+                cerr << "DEBUG: Outbound stream to " << _datagram_adapter.config().destination.to_string()
+                     << " finished (" << _tcp.value().bytes_in_flight() << " byte"
+                     << (_tcp.value().bytes_in_flight() == 1 ? "" : "s") << " still in flight).\n";
             }
         },
-        [&] { return not _tcp->segments_out().empty(); });
+        [&] {
+            const bool interested =
+                (_tcp->active()) and (not _outbound_shutdown) and (_tcp->remaining_outbound_capacity() > 0);
+            if (interested) {
+                _shm->outbound.prepare_to_wait_for_data();  // rings the doorbell now if there is data already
+            }
+            return interested;
+        },
+        [&] {
+            _tcp->end_input_stream();
+            _outbound_shutdown = true;
+        });
+
+    // rule 3: write from the inbound buffer into the inbound ring
+    _eventloop.add_rule(
+        _shm->inbound.space_doorbell(),
+        Direction::In,
+        [&] {
+            _shm->inbound.clear_space_doorbell();
+            ByteStream &inbound = _tcp->inbound_stream();
+            if (_shm->inbound.reader_gone()) {
+                inbound.pop_output(inbound.buffer_size());
+            } else {
+                const size_t amount_to_write = min(_shm->inbound.space(), inbound.buffer_size());
+                const std::string buffer = inbound.peek_output(amount_to_write);
+                inbound.pop_output(_shm->inbound.write(buffer));
+            }
+
+            if (inbound.eof() or inbound.error()) {
+                _shm->inbound.close();
+                _inbound_shutdown = true;
+
+                // debugging output:
+                cerr << "DEBUG: Inbound stream from " << _datagram_adapter.config().destination.to_string()
+                     << " finished " << (inbound.error() ? "with an error/reset.\n" : "cleanly.\n");
+                if (_tcp.value().state() == TCPState::State::TIME_WAIT) {
+                    cerr << "DEBUG: Waiting for lingering segments (e.g. retransmissions of FIN) from peer...\n";
+                }
+            }
+        },
+        [&] {
+            const bool interested =
+                (not _tcp->inbound_stream().buffer_empty()) or
+                ((_tcp->inbound_stream().eof() or _tcp->inbound_stream().error()) and not _inbound_shutdown);
+            if (interested) {
+                _shm->inbound.prepare_to_wait_for_space();  // rings the doorbell now if there is space already
+            }
+            return interested;
+        });
 }
 
 //! \brief Call [socketpair](\ref man2::socketpair) and return connected Unix-domain sockets of specified type
@@ -173,9 +267,10 @@ static inline pair<FileDescriptor, FileDescriptor> socket_pair_helper(const int
 }
 
 //! \param[in] datagram_interface is the underlying interface (e.g. to UDP, IP, or Ethernet)
+//! \param[in] channel selects how bytes travel between the owner and the TCP thread
 template <typename AdaptT>
-TCPSpongeSocket<AdaptT>::TCPSpongeSocket(AdaptT &&datagram_interface)
-    : TCPSpongeSocket(socket_pair_helper(SOCK_STREAM), move(datagram_interface)) {}
+TCPSpongeSocket<AdaptT>::TCPSpongeSocket(AdaptT &&datagram_interface, const DataChannel channel)
+    : TCPSpongeSocket(socket_pair_helper(SOCK_STREAM), move(datagram_interface), channel) {}
 
 template <typename AdaptT>
 TCPSpongeSocket<AdaptT>::~TCPSpongeSocket() {
@@ -260,7 +355,7 @@ void TCPSpongeSocket<AdaptT>::_tcp_main() {
             throw runtime_error("no TCP");
         }
         _tcp_loop([] { return true; });
-        shutdown(SHUT_RDWR);
+        _shutdown_from_tcp_thread();
         if (not _tcp.value().active()) {
             cerr << "DEBUG: TCP connection finished "
                  << (_tcp.value().state() == TCPState::State::RESET ? "uncleanly" : "cleanly.\n");
@@ -272,6 +367,91 @@ void TCPSpongeSocket<AdaptT>::_tcp_main() {
     }
 }
 
+template <typename AdaptT>
+void TCPSpongeSocket<AdaptT>::_shutdown_from_tcp_thread() {
+    if (_shm) {
+        _shm->inbound.close();
+        _shm->outbound.close_reader();
+    } else {
+        shutdown(SHUT_RDWR);
+    }
+}
+
+//! \param[in] limit is the maximum number of bytes to read; fewer bytes may be returned
+//! \param[out] str is the string to be read
+template <typename AdaptT>
+void TCPSpongeSocket<AdaptT>::read(string &str, const size_t limit) {
+    if (not _shm) {
+        LocalStreamSocket::read(str, limit);
+        return;
+    }
+
+    if (limit > 0) {
+        _shm->inbound.wait_for_data();
+    }
+    _shm->inbound.read(str, limit);
+}
+
+//! \param[in] limit is the maximum number of bytes to read; fewer bytes may be returned
+//! \returns the bytes read
+template <typename AdaptT>
+string TCPSpongeSocket<AdaptT>::read(const size_t limit) {
+    string ret;
+    read(ret, limit);
+    return ret;
+}
+
+template <typename AdaptT>
+size_t TCPSpongeSocket<AdaptT>::write(BufferViewList buffer, const bool write_all) {
+    if (not _shm) {
+        return LocalStreamSocket::write(move(buffer), write_all);
+    }
+
+    size_t total_bytes_written = 0;
+    while (true) {
+        if (_shm->outbound.reader_gone()) {
+            throw unix_error("write", EPIPE);
+        }
+
+        size_t bytes_written = 0;
+        for (const auto &iov : buffer.as_iovecs()) {
+            const size_t amount = _shm->outbound.write({static_cast<const char *>(iov.iov_base), iov.iov_len});
+            bytes_written += amount;
+            if (amount < iov.iov_len) {
+                break;
+            }
+        }
+        buffer.remove_prefix(bytes_written);
+        total_bytes_written += bytes_written;
+
+        if (buffer.size() == 0 or (not write_all and total_bytes_written > 0)) {
+            return total_bytes_written;
+        }
+        _shm->outbound.wait_for_space();
+    }
+}
+
+template <typename AdaptT>
+bool TCPSpongeSocket<AdaptT>::eof() const {
+    return _shm ? _shm->inbound.eof() : LocalStreamSocket::eof();
+}
+
+//! \param[in] how can be `SHUT_RD`, `SHUT_WR`, or `SHUT_RDWR`
+template <typename AdaptT>
+void TCPSpongeSocket<AdaptT>::shutdown(const int how) {
+    if (not _shm) {
+        LocalStreamSocket::shutdown(how);
+        return;
+    }
+
+    if (how == SHUT_WR or how == SHUT_RDWR) {
+        _shm->outbound.close();
+    }
+    if (how == SHUT_RD or how == SHUT_RDWR) {
+        _shm->inbound.close_reader();
+    }
+}
+
 //! Specialization of TCPSpongeSocket for TCPOverUDPSocketAdapter
 template class TCPSpongeSocket<TCPOverUDPSocketAdapter>;
 
@@ -315,7 +495,7 @@ EthernetAddress random_private_ethernet_address() {
 }
 
 FullStackSocket::FullStackSocket()
-    : TCPOverIPv4OverEthernetSpongeSocket(TCPOverIPv4OverEthernetAdapter(TapFD("tap10"),
+    : TCPOverIPv4OverEthernetSpongeSocket(TCPOverIPv4OverEthernetAdapter(TapFD("tap10", false, true),
                                                                          random_private_ethernet_address(),
                                                                          Address(LOCAL_TAP_IP_ADDRESS, "0"),
                                                                          Address(LOCAL_TAP_NEXT_HOP_ADDRESS, "0"))) {}
@@ -6,12 +6,15 @@
 #include "fd_adapter.hh"
 #include "file_descriptor.hh"
 #include "network_interface.hh"
+#include "shm_byte_ring.hh"
 #include "tcp_config.hh"
 #include "tcp_connection.hh"
 #include "tuntap_adapter.hh"
 
 #include <atomic>
 #include <cstdint>
+#include <limits>
+#include <memory>
 #include <optional>
 #include <thread>
 #include <vector>
@@ -19,10 +22,28 @@
 //! Multithreaded wrapper around TCPConnection that approximates the Unix sockets API
 template <typename AdaptT>
 class TCPSpongeSocket : public LocalStreamSocket {
+  public:
+    //! How bytes travel between the owner and the TCPConnection thread
+    enum class DataChannel {
+        SocketPair,   //!< A Unix-domain stream socket pair; the owner may poll the socket itself
+        SharedMemory  //!< A pair of ShmByteRing objects; only the read/write methods below may be used
+    };
+
+    static constexpr size_t SHM_RING_CAPACITY = 256 * 1024;  //!< Size of each shared-memory ring
+
   private:
     //! Stream socket for reads and writes between owner and TCP thread
     LocalStreamSocket _thread_data;
 
+    //! Rings used instead of the socket pair when the DataChannel is SharedMemory
+    struct SharedMemoryChannel {
+        ShmByteRing outbound;  //!< Owner to TCP thread
+        ShmByteRing inbound;   //!< TCP thread to owner
+
+        explicit SharedMemoryChannel(const size_t capacity) : outbound(capacity), inbound(capacity) {}
+    };
+    std::unique_ptr<SharedMemoryChannel> _shm;
+
   protected:
     //! Adapter to underlying datagram socket (e.g., UDP or IP)
     AdaptT _datagram_adapter;
@@ -31,6 +52,18 @@ class TCPSpongeSocket : public LocalStreamSocket {
     //! Set up the TCPConnection and the event loop
     void _initialize_TCP(const TCPConfig &config);
 
+    //! Add the event-loop rules that move bytes between the TCPConnection and the socket pair
+    void _add_socket_pair_rules();
+
+    //! Add the event-loop rules that move bytes between the TCPConnection and the shared-memory rings
+    void _add_shared_memory_rules();
+
+    //! Has the owner finished writing (and has the TCP thread read everything)?
+    bool _outbound_eof() const { return _shm ? _shm->outbound.eof() : _thread_data.eof(); }
+
+    //! Called by the TCP thread when it exits: the owner reads EOF and can no longer write
+    void _shutdown_from_tcp_thread();
+
     //! TCP state machine
     std::optional<TCPConnection> _tcp{};
 
@@ -47,7 +80,9 @@ class TCPSpongeSocket : public LocalStreamSocket {
     std::thread _tcp_thread{};
 
     //! Construct LocalStreamSocket fds from socket pair, initialize eventloop
-    TCPSpongeSocket(std::pair<FileDescriptor, FileDescriptor> data_socket_pair, AdaptT &&datagram_interface);
+    TCPSpongeSocket(std::pair<FileDescriptor, FileDescriptor> data_socket_pair,
+                    AdaptT &&datagram_interface,
+                    const DataChannel channel);
 
     std::atomic_bool _abort{false};  //!< Flag used by the owner to force the TCPConnection thread to shut down
 
@@ -59,7 +94,7 @@ class TCPSpongeSocket : public LocalStreamSocket {
 
   public:
     //! Construct from the interface that the TCPConnection thread will use to read and write datagrams
-    explicit TCPSpongeSocket(AdaptT &&datagram_interface);
+    explicit TCPSpongeSocket(AdaptT &&datagram_interface, const DataChannel channel = DataChannel::SocketPair);
 
     //! Close socket, and wait for TCPConnection to finish
     //! \note Calling this function is only advisable if the socket has reached EOF,
@@ -75,6 +110,34 @@ class TCPSpongeSocket : public LocalStreamSocket {
     //! When a connected socket is destructed, it will send a RST
     ~TCPSpongeSocket();
 
+    //! \name
+    //! The owner's end of the byte streams. These hide the FileDescriptor and Socket methods of the
+    //! same names so that they work with either DataChannel.
+
+    //!@{
+
+    //! Read up to `limit` bytes, blocking until at least one byte (or EOF) is available
+    std::string read(const size_t limit = std::numeric_limits<size_t>::max());
+
+    //! Read up to `limit` bytes into `str` (caller can allocate storage)
+    void read(std::string &str, const size_t limit = std::numeric_limits<size_t>::max());
+
+    //! Write a string, possibly blocking until all is written
+    size_t write(const char *str, const bool write_all = true) { return write(BufferViewList(str), write_all); }
+
+    //! Write a string, possibly blocking until all is written
+    size_t write(const std::string &str, const bool write_all = true) { return write(BufferViewList(str), write_all); }
+
+    //! Write a buffer (or list of buffers), possibly blocking until all is written
+    size_t write(BufferViewList buffer, const bool write_all = true);
+
+    //! Has the inbound stream ended (and has everything been read)?
+    bool eof() const;
+
+    //! Shut down reading (SHUT_RD), writing (SHUT_WR), or both (SHUT_RDWR)
+    void shutdown(const int how);
+    //!@}
+
     //! \name
     //! This object cannot be safely moved or copied, since it is in use by two threads simultaneously
 
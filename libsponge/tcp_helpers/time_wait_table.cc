@@ -0,0 +1,91 @@
+#include "time_wait_table.hh"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+TimeWaitTable::TimeWaitTable(const size_t time_wait_ms, const size_t slot_ms)
+    : _time_wait_ms(time_wait_ms), _slot_ms(slot_ms), _wheel(NUM_SLOTS) {
+    if (_slot_ms == 0) {
+        throw runtime_error("TimeWaitTable: slot_ms must be positive");
+    }
+}
+
+void TimeWaitTable::_schedule(const FourTuple &tuple, Entry &entry) {
+    entry.slot = max(entry.deadline_ms / _slot_ms, _next_slot);
+    entry.generation = ++_generation;
+    _wheel[entry.slot % NUM_SLOTS].push_back({tuple, entry.generation});
+}
+
+//! \param[in] tuple identifies the connection
+//! \param[in] record is what the connection needs to keep ACKing its peer
+//! \param[in] elapsed_ms is how long the connection has already been quiet
+void TimeWaitTable::insert(const FourTuple &tuple, const TimeWaitRecord &record, const size_t elapsed_ms) {
+    const uint64_t deadline = _time_ms + _time_wait_ms - min(elapsed_ms, _time_wait_ms);
+    auto [it, inserted] = _entries.insert({tuple, Entry{record, deadline, 0, 0}});
+    if (not inserted) {
+        it->second.record = record;
+        it->second.deadline_ms = deadline;
+    }
+    _schedule(it->first, it->second);
+}
+
+//! \param[in] tuple identifies the connection, which must be in the table
+//! \param[in] seg is the segment that arrived
+optional<TCPSegment> TimeWaitTable::segment_received(const FourTuple &tuple, const TCPSegment &seg) {
+    auto it = _entries.find(tuple);
+    if (it == _entries.end()) {
+        throw runtime_error("TimeWaitTable: segment for unknown tuple " + tuple.to_string());
+    }
+
+    if (seg.header().rst) {
+        _entries.erase(it);
+        return {};
+    }
+
+    // the wheel notices the later deadline when the old one comes due
+    it->second.deadline_ms = _time_ms + _time_wait_ms;
+
+    if (seg.length_in_sequence_space() == 0) {
+        return {};
+    }
+
+    TCPSegment ack;
+    ack.header().seqno = it->second.record.seqno;
+    ack.header().ack = true;
+    ack.header().ackno = it->second.record.ackno;
+    ack.header().win = it->second.record.window;
+    return ack;
+}
+
+//! \param[in] ms_since_last_tick number of milliseconds since the last call to this method
+void TimeWaitTable::tick(const size_t ms_since_last_tick) {
+    _time_ms += ms_since_last_tick;
+
+    if (_entries.empty()) {
+        _next_slot = max(_next_slot, _time_ms / _slot_ms);
+        return;
+    }
+
+    vector<Reference> due;
+    while ((_next_slot + 1) * _slot_ms <= _time_ms) {
+        const uint64_t slot = _next_slot++;
+        due.clear();
+        due.swap(_wheel[slot % NUM_SLOTS]);
+
+        for (const auto &ref : due) {
+            auto it = _entries.find(ref.tuple);
+            if (it == _entries.end() or it->second.generation != ref.generation) {
+                continue;  // stale reference to a record that was removed or rescheduled
+            }
+            if (it->second.slot > slot) {
+                _wheel[slot % NUM_SLOTS].push_back(ref);  // due in a later turn of the wheel
+            } else if (it->second.deadline_ms <= _time_ms) {
+                _entries.erase(it);
+            } else {
+                _schedule(it->first, it->second);  // the peer spoke again and extended the deadline
+            }
+        }
+    }
+}
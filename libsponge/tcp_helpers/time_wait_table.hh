@@ -0,0 +1,86 @@
+#ifndef SPONGE_LIBSPONGE_TIME_WAIT_TABLE_HH
+#define SPONGE_LIBSPONGE_TIME_WAIT_TABLE_HH
+
+#include "four_tuple.hh"
+#include "tcp_segment.hh"
+#include "wrapping_integers.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+//! \brief What a connection in TIME_WAIT still needs to remember
+//! \details Everything else (the byte streams, the reassembler, the retransmission queue)
+//! is finished by the time both FINs have been sent and acknowledged.
+struct TimeWaitRecord {
+    WrappingInt32 seqno{0};  //!< Our next sequence number (just past our FIN)
+    WrappingInt32 ackno{0};  //!< The ackno we send (just past the peer's FIN)
+    uint16_t window = 0;     //!< The window we advertise
+};
+
+//! \brief Connections lingering in TIME_WAIT, kept as compact records
+//! \details A TCPConnection in TIME_WAIT does nothing but ACK the peer's retransmitted FINs
+//! until it has been quiet for the linger time. This table does the same job for many
+//! connections at a few dozen bytes each. Deadlines are indexed by a hashed timer wheel of
+//! NUM_SLOTS slots, each `slot_ms` wide, so expiring entries costs time proportional to the
+//! number of entries that expire rather than the size of the table. A record is reported
+//! expired within `slot_ms` after its deadline.
+class TimeWaitTable {
+  public:
+    static constexpr size_t NUM_SLOTS = 256;  //!< Number of slots in the timer wheel
+
+  private:
+    struct Entry {
+        TimeWaitRecord record;
+        uint64_t deadline_ms;  //!< When the entry expires, unless the peer speaks again
+        uint64_t slot;         //!< Absolute wheel slot the entry is currently filed under
+        uint64_t generation;   //!< Matches exactly one Reference on the wheel
+    };
+
+    //! A wheel slot's pointer to an entry; stale once the entry is removed or rescheduled
+    struct Reference {
+        FourTuple tuple;
+        uint64_t generation;
+    };
+
+    size_t _time_wait_ms;  //!< How long a connection lingers after the last segment from the peer
+    size_t _slot_ms;       //!< Width of one wheel slot
+
+    std::unordered_map<FourTuple, Entry, FourTupleHash> _entries{};
+    std::vector<std::vector<Reference>> _wheel;  //!< Entries filed by deadline slot (mod NUM_SLOTS)
+
+    uint64_t _time_ms{0};    //!< Time since the table was created
+    uint64_t _next_slot{0};  //!< Absolute number of the next wheel slot to expire
+    uint64_t _generation{0};
+
+    //! File `entry` under the wheel slot containing its deadline
+    void _schedule(const FourTuple &tuple, Entry &entry);
+
+  public:
+    //! \param[in] time_wait_ms is the linger time (a TCPConnection uses `10 * rt_timeout`)
+    //! \param[in] slot_ms is the timer-wheel granularity
+    explicit TimeWaitTable(const size_t time_wait_ms, const size_t slot_ms = 10);
+
+    //! \brief Start tracking a connection that has entered TIME_WAIT
+    //! \param[in] elapsed_ms is how long the connection has already been quiet
+    void insert(const FourTuple &tuple, const TimeWaitRecord &record, const size_t elapsed_ms = 0);
+
+    //! \brief Is `tuple` in TIME_WAIT?
+    bool contains(const FourTuple &tuple) const { return _entries.count(tuple); }
+
+    //! \brief Handle a segment that arrived for a tuple in TIME_WAIT
+    //! \details Any segment restarts the linger timer and a RST ends TIME_WAIT. A segment that
+    //! occupies sequence space (i.e. a retransmitted FIN) is answered with an ACK.
+    //! \returns the segment to send in response, if any
+    std::optional<TCPSegment> segment_received(const FourTuple &tuple, const TCPSegment &seg);
+
+    //! \brief Called periodically when time elapses; forgets records whose linger time has passed
+    void tick(const size_t ms_since_last_tick);
+
+    //! \brief Number of tuples in TIME_WAIT
+    size_t size() const { return _entries.size(); }
+};
+
+#endif  // SPONGE_LIBSPONGE_TIME_WAIT_TABLE_HH
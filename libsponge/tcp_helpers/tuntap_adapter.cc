@@ -1,29 +1,68 @@
 #include "tuntap_adapter.hh"
 
+#include "ipv4_header.hh"
+#include "parser.hh"
+#include "tcp_config.hh"
+#include "tcp_header.hh"
+
+#include <linux/if_tun.h>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
 using namespace std;
 
+//! Largest TCP payload that fits in one IPv4 datagram (with headers of the minimum size)
+static constexpr size_t MAX_SUPER_SEGMENT_PAYLOAD = 65535 - IPv4Header::LENGTH - TCPHeader::LENGTH;
+
 //! \param[in] tap Raw network device that will be owned by the adapter
 //! \param[in] eth_address Ethernet address (local address) of the adapter
 //! \param[in] ip_address IP address (local address) of the adapter
 //! \param[in] next_hop IP address of the next hop (typically a router or default gateway)
+//! \details Offload is used if `tap` was opened with `vnet_hdr`.
 TCPOverIPv4OverEthernetAdapter::TCPOverIPv4OverEthernetAdapter(TapFD &&tap,
                                                                const EthernetAddress &eth_address,
                                                                const Address &ip_address,
                                                                const Address &next_hop)
-    : _tap(move(tap)), _interface(eth_address, ip_address), _next_hop(next_hop) {
+    : _tap(move(tap)), _interface(eth_address, ip_address), _next_hop(next_hop), _offload(_tap.vnet_hdr()) {
+    if (_offload) {
+        // let the kernel hand us TCP/IPv4 super-segments, and segments whose checksums it has not filled in
+        _tap.set_offload(TUN_F_CSUM | TUN_F_TSO4);
+    }
+
     // Linux seems to ignore the first frame sent on a TAP device, so send a dummy frame to prime the pump :-(
     EthernetFrame dummy_frame;
-    _tap.write(dummy_frame.serialize());
+    write_frame(dummy_frame);
 }
 
 optional<TCPSegment> TCPOverIPv4OverEthernetAdapter::read() {
+    Buffer raw_frame = _tap.read();
+
+    // With offload, each frame starts with a virtio-net header saying what the kernel has done to it
+    VirtioNetHeader vnet;
+    if (_offload) {
+        NetParser p{raw_frame};
+        if (vnet.parse(p) != ParseResult::NoError) {
+            return {};
+        }
+        raw_frame = p.buffer();
+    }
+
     // Read Ethernet frame from the raw device
     EthernetFrame frame;
     // 从tap设备读取数据,并解析为以太网帧
-    if (frame.parse(_tap.read()) != ParseResult::NoError) {
+    if (frame.parse(raw_frame) != ParseResult::NoError) {
         return {};
     }
 
+    // 交给NetworkInterface解析之前, 先丢弃与当前连接无关的IPv4数据报(即receive()的第一阶段)
+    if (frame.header().type == EthernetHeader::TYPE_IPv4) {
+        if (const auto drop = early_demux(raw_frame.str().substr(EthernetHeader::LENGTH))) {
+            count_drop(*drop);
+            return {};
+        }
+    }
+
     // Give the frame to the NetworkInterface. Get back an Internet datagram if frame was carrying one.
     // 从以太网帧中提取IPV4数据报 -- NetworkInterface的recv_frame方法,lab5实现的
     optional<InternetDatagram> ip_dgram = _interface.recv_frame(frame);
@@ -35,7 +74,9 @@ optional<TCPSegment> TCPOverIPv4OverEthernetAdapter::read() {
     // Try to interpret IPv4 datagram as TCP
     // 从ip数据报中提取tcp segment返回
     if (ip_dgram) {
-        return unwrap_tcp_in_ip(ip_dgram.value());
+        // the kernel has checked the TCP checksum, or (for its own segments) has not yet filled it in
+        const bool checksum_verified = vnet.flags & (VirtioNetHeader::F_NEEDS_CSUM | VirtioNetHeader::F_DATA_VALID);
+        return unwrap_tcp_in_ip(ip_dgram.value(), checksum_verified);
     }
     return {};
 }
@@ -48,16 +89,115 @@ void TCPOverIPv4OverEthernetAdapter::tick(const size_t ms_since_last_tick) {
 
 //! \param[in] seg the TCPSegment to send
 void TCPOverIPv4OverEthernetAdapter::write(TCPSegment &seg) {
+    if (_offload) {
+        _unsent.push_back(seg);
+        return;
+    }
     _interface.send_datagram(wrap_tcp_in_ip(seg), _next_hop);
     send_pending();
 }
 
+//! Can `next` be sent as the piece of a super-segment that follows `prev`?
+//! \details The kernel cuts a super-segment into pieces of TCPConfig::MAX_PAYLOAD_SIZE, copying the
+//! header into each (but for FIN and PSH, which only the last piece keeps), so every piece but the
+//! last must be full-sized and the headers must differ only in their sequence numbers.
+static bool can_follow(const TCPSegment &prev, const TCPSegment &next) {
+    const TCPHeader &p = prev.header();
+    const TCPHeader &n = next.header();
+    return prev.payload().size() == TCPConfig::MAX_PAYLOAD_SIZE and next.payload().size() > 0 and not p.syn and
+           not p.fin and not p.rst and not p.urg and not n.syn and not n.rst and not n.urg and
+           n.seqno == p.seqno + prev.payload().size() and n.ack == p.ack and n.ackno == p.ackno and n.win == p.win;
+}
+
+//! Merges a run of segments that can follow one another into one super-segment
+static TCPSegment merge(const vector<TCPSegment>::const_iterator begin, const vector<TCPSegment>::const_iterator end) {
+    TCPSegment ret;
+    ret.header() = begin->header();
+    ret.header().fin = prev(end)->header().fin;
+
+    string payload;
+    for (auto it = begin; it != end; ++it) {
+        ret.header().psh |= it->header().psh;
+        payload.append(it->payload().str());
+    }
+    ret.payload() = Buffer(move(payload));
+    return ret;
+}
+
+void TCPOverIPv4OverEthernetAdapter::flush() {
+    auto run_begin = _unsent.cbegin();
+    while (run_begin != _unsent.cend()) {
+        // find the longest run of segments that can be sent as one
+        auto run_end = next(run_begin);
+        size_t run_payload = run_begin->payload().size();
+        while (run_end != _unsent.cend() and size_t(run_end - run_begin) < MAX_GSO_SEGMENTS and
+               run_payload + run_end->payload().size() <= MAX_SUPER_SEGMENT_PAYLOAD and
+               can_follow(*prev(run_end), *run_end)) {
+            run_payload += run_end->payload().size();
+            ++run_end;
+        }
+
+        TCPSegment seg = next(run_begin) == run_end ? *run_begin : merge(run_begin, run_end);
+        _interface.send_datagram(wrap_tcp_in_ip(seg, true), _next_hop);
+        run_begin = run_end;
+    }
+    _unsent.clear();
+    send_pending();
+}
+
 void TCPOverIPv4OverEthernetAdapter::send_pending() {
     while (not _interface.frames_out().empty()) {
-        _tap.write(_interface.frames_out().front().serialize());
+        write_frame(_interface.frames_out().front());
         _interface.frames_out().pop();
     }
 }
 
+//! \details The frame is copied once, into a PacketBuffer with room for its headers, which are then
+//! written in front of it, so it goes out in a single write(2).
+void TCPOverIPv4OverEthernetAdapter::write_frame(const EthernetFrame &frame) {
+    PacketBuffer packet{VirtioNetHeader::LENGTH + EthernetHeader::LENGTH, frame.payload()};
+    const VirtioNetHeader vnet = _offload ? vnet_header_for(frame.header(), packet.str()) : VirtioNetHeader{};
+    frame.serialize_into(packet);
+    if (_offload) {
+        vnet.serialize_into(packet.prepend(VirtioNetHeader::LENGTH));
+    }
+    _tap.write(packet.str());
+}
+
+//! \details The adapter only sends its own TCP segments in IPv4 datagrams, and with offload it leaves
+//! their checksums for the kernel (see wrap_tcp_in_ip()), so every IPv4 frame needs one. Rather than
+//! parse the whole datagram, this reads the header lengths from its first bytes.
+//! \param[in] header is the frame's header
+//! \param[in] payload is the frame's payload
+VirtioNetHeader TCPOverIPv4OverEthernetAdapter::vnet_header_for(const EthernetHeader &header,
+                                                                 const string_view payload) {
+    VirtioNetHeader vnet;
+    if (header.type != EthernetHeader::TYPE_IPv4) {
+        return vnet;
+    }
+
+    const auto byte = [&](const size_t i) -> uint8_t {
+        if (i >= payload.size()) {
+            throw runtime_error("TCPOverIPv4OverEthernetAdapter: IPv4 frame without a TCP segment");
+        }
+        return payload[i];
+    };
+    // the low half of IPv4 byte 0 is the header length, and the high half of TCP byte 12 the data offset
+    const size_t ip_header_length = (byte(0) & 0x0f) * 4;
+    const size_t tcp_header_length = (byte(ip_header_length + 12) >> 4) * 4;
+
+    vnet.flags = VirtioNetHeader::F_NEEDS_CSUM;
+    vnet.csum_start = EthernetHeader::LENGTH + ip_header_length;
+    vnet.csum_offset = TCPHeader::CKSUM_OFFSET;
+
+    const size_t payload_length = payload.size() - ip_header_length - tcp_header_length;
+    if (payload_length > TCPConfig::MAX_PAYLOAD_SIZE) {
+        vnet.gso_type = VirtioNetHeader::GSO_TCPV4;
+        vnet.gso_size = TCPConfig::MAX_PAYLOAD_SIZE;
+        vnet.hdr_len = EthernetHeader::LENGTH + ip_header_length + tcp_header_length;
+    }
+    return vnet;
+}
+
 //! Specialize LossyFdAdapter to TCPOverIPv4OverTunFdAdapter
 template class LossyFdAdapter<TCPOverIPv4OverTunFdAdapter>;
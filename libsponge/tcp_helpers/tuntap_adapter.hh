@@ -4,10 +4,13 @@
 #include "ethernet_header.hh"
 #include "network_interface.hh"
 #include "tun.hh"
+#include "virtio_net_header.hh"
 
 #include <optional>
+#include <string_view>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 //! \brief A FD adapter for IPv4 datagrams read from and written to a TUN device
 class TCPOverIPv4OverTunFdAdapter : public TCPOverIPv4Adapter {
@@ -19,16 +22,10 @@ class TCPOverIPv4OverTunFdAdapter : public TCPOverIPv4Adapter {
     explicit TCPOverIPv4OverTunFdAdapter(TunFD &&tun) : _tun(std::move(tun)) {}
 
     //! Attempts to read and parse an IPv4 datagram containing a TCP segment related to the current connection
-    std::optional<TCPSegment> read() {
-        InternetDatagram ip_dgram;
-        if (ip_dgram.parse(_tun.read()) != ParseResult::NoError) {
-            return {};
-        }
-        return unwrap_tcp_in_ip(ip_dgram);
-    }
+    std::optional<TCPSegment> read() { return receive(_tun.read()); }
 
     //! Creates an IPv4 datagram from a TCP segment and writes it to the TUN device
-    void write(TCPSegment &seg) { _tun.write(wrap_tcp_in_ip(seg).serialize()); }
+    void write(TCPSegment &seg) { _tun.write(wrap_tcp_in_ip_packet(seg).str()); }
 
     //! Access the underlying TUN device
     operator TunFD &() { return _tun; }
@@ -41,7 +38,15 @@ class TCPOverIPv4OverTunFdAdapter : public TCPOverIPv4Adapter {
 using LossyTCPOverIPv4OverTunFdAdapter = LossyFdAdapter<TCPOverIPv4OverTunFdAdapter>;
 
 //! \brief A FD adapter for IPv4 datagrams read from and written to a TAP device
+//! \details If the TapFD was opened with `vnet_hdr`, the adapter hands work to the kernel through
+//! each frame's VirtioNetHeader: it leaves TCP checksums for the kernel to complete, and sends runs
+//! of full-sized segments written before a flush() as one TCP "super-segment" (up to MAX_GSO_SEGMENTS
+//! segments of TCPConfig::MAX_PAYLOAD_SIZE) for the kernel to cut up. In turn the kernel may hand it
+//! coalesced (GRO) segments, and segments whose checksums it has already checked or will never fill in.
 class TCPOverIPv4OverEthernetAdapter : public TCPOverIPv4Adapter {
+  public:
+    static constexpr size_t MAX_GSO_SEGMENTS = 64;  //!< Most segments merged into one super-segment
+
   private:
     TapFD _tap;  //!< Raw Ethernet connection
 
@@ -49,8 +54,17 @@ class TCPOverIPv4OverEthernetAdapter : public TCPOverIPv4Adapter {
 
     Address _next_hop;  //!< IP address of the next hop
 
+    bool _offload;  //!< Do frames carry virtio-net headers?
+
+    std::vector<TCPSegment> _unsent{};  //!< With offload, segments waiting for flush()
+
     void send_pending();  //!< Sends any pending Ethernet frames
 
+    void write_frame(const EthernetFrame &frame);  //!< Writes one Ethernet frame to the TAP device
+
+    //! The virtio-net header that describes an outgoing frame to the kernel
+    static VirtioNetHeader vnet_header_for(const EthernetHeader &header, const std::string_view payload);
+
   public:
     //! Construct from a TapFD
     explicit TCPOverIPv4OverEthernetAdapter(TapFD &&tap,
@@ -60,9 +74,12 @@ class TCPOverIPv4OverEthernetAdapter : public TCPOverIPv4Adapter {
     //! Attempts to read and parse an Ethernet frame containing an IPv4 datagram that contains a TCP segment
     std::optional<TCPSegment> read();
 
-    //! Sends a TCP segment (in an IPv4 datagram, in an Ethernet frame).
+    //! Sends a TCP segment (in an IPv4 datagram, in an Ethernet frame), or with offload queues it for flush()
     void write(TCPSegment &seg);
 
+    //! With offload, merges the queued segments into as few super-segments as possible and sends them
+    void flush();
+
     //! Called periodically when time elapses
     void tick(const size_t ms_since_last_tick);
 
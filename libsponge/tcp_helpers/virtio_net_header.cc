@@ -0,0 +1,40 @@
+#include "virtio_net_header.hh"
+
+#include <endian.h>
+
+using namespace std;
+
+// NetParser and NetUnparser speak network byte order, but the virtio-net header is in host byte
+// order; these convert between the value NetParser sees and the value the bytes hold in memory
+static uint16_t from_network_order(const uint16_t val) { return htobe16(val); }
+static uint16_t to_network_order(const uint16_t val) { return be16toh(val); }
+
+ParseResult VirtioNetHeader::parse(NetParser &p) {
+    if (p.buffer().size() < VirtioNetHeader::LENGTH) {
+        return ParseResult::PacketTooShort;
+    }
+
+    flags = p.u8();
+    gso_type = p.u8();
+    hdr_len = from_network_order(p.u16());
+    gso_size = from_network_order(p.u16());
+    csum_start = from_network_order(p.u16());
+    csum_offset = from_network_order(p.u16());
+
+    return p.get_error();
+}
+
+string VirtioNetHeader::serialize() const {
+    string ret(LENGTH, 0);
+    serialize_into(ret.data());
+    return ret;
+}
+
+void VirtioNetHeader::serialize_into(char *dst) const {
+    NetUnparser::u8(dst, flags);
+    NetUnparser::u8(dst + 1, gso_type);
+    NetUnparser::u16(dst + 2, to_network_order(hdr_len));
+    NetUnparser::u16(dst + 4, to_network_order(gso_size));
+    NetUnparser::u16(dst + 6, to_network_order(csum_start));
+    NetUnparser::u16(dst + 8, to_network_order(csum_offset));
+}
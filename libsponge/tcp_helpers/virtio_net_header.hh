@@ -0,0 +1,45 @@
+#ifndef SPONGE_LIBSPONGE_VIRTIO_NET_HEADER_HH
+#define SPONGE_LIBSPONGE_VIRTIO_NET_HEADER_HH
+
+#include "parser.hh"
+
+#include <cstdint>
+#include <string>
+
+//! \brief The header that precedes every frame on a TUN/TAP device opened with IFF_VNET_HDR
+//! \details It tells the kernel (or us) what work on the frame is still to be done: a checksum
+//! to fill in, or a TCP "super-segment" to cut into MSS-sized segments. Unlike the other headers
+//! in this directory its fields are in host byte order (this is the "legacy" virtio layout).
+struct VirtioNetHeader {
+    static constexpr size_t LENGTH = 10;  //!< Header length in bytes
+
+    static constexpr uint8_t F_NEEDS_CSUM = 1;  //!< Checksum from csum_start to the end, store at csum_offset
+    static constexpr uint8_t F_DATA_VALID = 2;  //!< Checksums have already been verified
+
+    static constexpr uint8_t GSO_NONE = 0;   //!< Not a super-segment
+    static constexpr uint8_t GSO_TCPV4 = 1;  //!< A TCP/IPv4 super-segment, to be cut into gso_size pieces
+
+    //! \name virtio-net header fields
+    //!@{
+    uint8_t flags = 0;
+    uint8_t gso_type = GSO_NONE;
+    uint16_t hdr_len = 0;      //!< Length of the Ethernet, IP and TCP headers of a super-segment
+    uint16_t gso_size = 0;     //!< Payload bytes per segment once a super-segment is cut up
+    uint16_t csum_start = 0;   //!< Where the checksummed region starts (from the start of the frame)
+    uint16_t csum_offset = 0;  //!< Where the checksum goes (from csum_start)
+    //!@}
+
+    //! Parse the header fields from the provided NetParser
+    ParseResult parse(NetParser &p);
+
+    //! Serialize the header fields to a string
+    std::string serialize() const;
+
+    //! Serialize the header fields in place, into the LENGTH bytes at `dst`
+    void serialize_into(char *dst) const;
+};
+
+//! \struct VirtioNetHeader
+//! This struct can be used to parse an existing virtio-net header or to create a new one.
+
+#endif  // SPONGE_LIBSPONGE_VIRTIO_NET_HEADER_HH
@@ -0,0 +1,166 @@
+#include "tcp_listener.hh"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+using namespace std;
+
+void TCPListener::_collect(const FourTuple &tuple, TCPConnection &connection) {
+    auto &queue = connection.segments_out();
+    while (not queue.empty()) {
+        _segments_out.emplace(tuple, move(queue.front()));
+        queue.pop();
+    }
+}
+
+bool TCPListener::_collect_or_retire(ConnectionTable &table, ConnectionTable::iterator it) {
+    _collect(it->first, it->second);
+    if (const auto record = it->second.hand_off_time_wait()) {
+        _time_wait.insert(it->first, *record, it->second.time_since_last_segment_received());
+    }
+    if (it->second.active()) {
+        return false;
+    }
+    table.erase(it);
+    return true;
+}
+
+void TCPListener::_send_cookie(const FourTuple &tuple, const TCPSegment &syn) {
+    TCPSegment syn_ack;
+    syn_ack.header().syn = true;
+    syn_ack.header().ack = true;
+    syn_ack.header().seqno = _cookies.encode(tuple, syn.header().seqno, _listener_cfg.mss, _time_ms);
+    syn_ack.header().ackno = syn.header().seqno + 1;
+    syn_ack.header().win = min(_cfg.recv_capacity, size_t(numeric_limits<uint16_t>::max()));
+    _segments_out.emplace(tuple, move(syn_ack));
+    _stats.cookies_sent++;
+}
+
+//! \details The cookie only proves that the peer saw our SYN-ACK. To rebuild the
+//! connection, a TCPConnection is created with the cookie as its fixed ISN and is
+//! replayed the SYN the peer must have sent; the SYN-ACK it generates in response
+//! is identical to the one already on the wire and is discarded. The real ACK is
+//! then delivered, which completes the handshake.
+bool TCPListener::_accept_cookie(const FourTuple &tuple, const TCPSegment &ack) {
+    const WrappingInt32 peer_isn = ack.header().seqno - 1;
+    const WrappingInt32 cookie = ack.header().ackno - 1;
+    if (not _cookies.decode(tuple, peer_isn, cookie, _time_ms).has_value()) {
+        _stats.cookies_rejected++;
+        return false;
+    }
+
+    TCPConfig cfg = _cfg;
+    cfg.fixed_isn = cookie;
+    const auto conn_it = _connections.emplace(tuple, cfg).first;
+    auto &connection = conn_it->second;
+
+    TCPSegment syn;
+    syn.header().syn = true;
+    syn.header().seqno = peer_isn;
+    connection.segment_received(syn);
+    while (not connection.segments_out().empty()) {
+        connection.segments_out().pop();
+    }
+
+    connection.segment_received(ack);
+    _collect_or_retire(_connections, conn_it);
+    _accept_queue.push(tuple);
+    _stats.cookies_accepted++;
+    return true;
+}
+
+//! \param[in] tuple identifies the connection the segment belongs to
+//! \param[in] seg is the segment that arrived
+void TCPListener::segment_received(const FourTuple &tuple, const TCPSegment &seg) {
+    // an established connection?
+    auto conn_it = _connections.find(tuple);
+    if (conn_it != _connections.end()) {
+        conn_it->second.segment_received(seg);
+        _collect_or_retire(_connections, conn_it);
+        return;
+    }
+
+    // a connection that is still in the handshake?
+    auto half_open_it = _syn_queue.find(tuple);
+    if (half_open_it != _syn_queue.end()) {
+        half_open_it->second.segment_received(seg);
+        if (not _collect_or_retire(_syn_queue, half_open_it) and
+            half_open_it->second.state() != TCPState::State::SYN_RCVD) {
+            _connections.insert(_syn_queue.extract(half_open_it));
+            _accept_queue.push(tuple);
+        }
+        return;
+    }
+
+    // a connection that has finished but may still see a retransmitted FIN?
+    if (_time_wait.contains(tuple)) {
+        if (auto reply = _time_wait.segment_received(tuple, seg)) {
+            _segments_out.emplace(tuple, move(*reply));
+        }
+        return;
+    }
+
+    const auto &header = seg.header();
+    if (header.rst) {
+        return;
+    }
+
+    // a new connection
+    if (header.syn and not header.ack) {
+        _stats.syns_received++;
+        if (cookies_active()) {
+            _send_cookie(tuple, seg);
+            return;
+        }
+        if (_syn_queue.size() >= _listener_cfg.syn_queue_capacity) {
+            _stats.syn_queue_drops++;
+            return;
+        }
+        auto &connection = _syn_queue.emplace(tuple, _cfg).first->second;
+        connection.segment_received(seg);
+        _collect(tuple, connection);
+        return;
+    }
+
+    // the final ACK of a handshake that was answered with a cookie
+    if (header.ack and not header.syn) {
+        _accept_cookie(tuple, seg);
+    }
+}
+
+//! \param[in] ms_since_last_tick number of milliseconds since the last call to this method
+void TCPListener::tick(const size_t ms_since_last_tick) {
+    _time_ms += ms_since_last_tick;
+
+    for (auto *table : {&_syn_queue, &_connections}) {
+        for (auto it = table->begin(); it != table->end();) {
+            const auto current = it++;
+            current->second.tick(ms_since_last_tick);
+            _collect_or_retire(*table, current);
+        }
+    }
+    _time_wait.tick(ms_since_last_tick);
+}
+
+TCPConnection &TCPListener::connect(const FourTuple &tuple) {
+    if (_connections.count(tuple) or _syn_queue.count(tuple) or _time_wait.contains(tuple)) {
+        throw runtime_error("TCPListener: connect() to " + tuple.to_string() + ", which is already in use");
+    }
+
+    auto &connection = _connections.emplace(tuple, _cfg).first->second;
+    connection.connect();
+    _collect(tuple, connection);
+    return connection;
+}
+
+optional<FourTuple> TCPListener::accept() {
+    while (not _accept_queue.empty()) {
+        const FourTuple tuple = _accept_queue.front();
+        _accept_queue.pop();
+        if (_connections.count(tuple)) {
+            return tuple;
+        }
+    }
+    return {};
+}
@@ -0,0 +1,103 @@
+#ifndef SPONGE_LIBSPONGE_TCP_LISTENER_HH
+#define SPONGE_LIBSPONGE_TCP_LISTENER_HH
+
+#include "four_tuple.hh"
+#include "syn_cookie.hh"
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "time_wait_table.hh"
+
+#include <cstdint>
+#include <optional>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+
+//! \brief A passive TCP endpoint that accepts connections from many peers
+//! \details Segments are demultiplexed by their FourTuple. A SYN normally allocates a
+//! TCPConnection in the SYN queue; once the handshake completes the connection moves to the
+//! connection table and its tuple is queued for accept(). When the SYN queue fills past
+//! TCPListenerConfig::syn_cookie_threshold, SYNs are answered statelessly with a SYN cookie
+//! and no TCPConnection exists until a final ACK carrying a valid cookie arrives.
+//!
+//! A connection that enters TIME_WAIT is collapsed into a TimeWaitTable record and freed.
+class TCPListener {
+  public:
+    //! Counters describing how the listener has handled handshakes
+    struct Stats {
+        uint64_t syns_received = 0;     //!< SYNs for tuples that had no state
+        uint64_t syn_queue_drops = 0;   //!< SYNs dropped because the SYN queue was full
+        uint64_t cookies_sent = 0;      //!< SYN-ACKs sent with a cookie instead of queued state
+        uint64_t cookies_accepted = 0;  //!< Connections created from a valid cookie
+        uint64_t cookies_rejected = 0;  //!< Stateless ACKs whose cookie was stale or forged
+    };
+
+  private:
+    using ConnectionTable = std::unordered_map<FourTuple, TCPConnection, FourTupleHash>;
+
+    TCPConfig _cfg;                   //!< Configuration of each accepted connection
+    TCPListenerConfig _listener_cfg;  //!< Configuration of the SYN queue and cookies
+    SYNCookieCodec _cookies{};        //!< Keyed cookie generator
+
+    ConnectionTable _syn_queue{};    //!< Half-open connections (SYN received, handshake not finished)
+    ConnectionTable _connections{};  //!< Connections that were actively opened or whose handshake has completed
+    TimeWaitTable _time_wait;        //!< Connections that have finished and are lingering in TIME_WAIT
+    std::queue<FourTuple> _accept_queue{};  //!< Completed connections not yet returned by accept()
+
+    //! Outbound segments, each tagged with the connection it belongs to
+    std::queue<std::pair<FourTuple, TCPSegment>> _segments_out{};
+
+    uint64_t _time_ms{0};  //!< Time since the listener was created
+    Stats _stats{};
+
+    //! Move the segments a connection wants sent onto the listener's queue
+    void _collect(const FourTuple &tuple, TCPConnection &connection);
+
+    //! \brief Collect a connection's output, then free it if it has finished or entered TIME_WAIT
+    //! \returns `true` if the connection was erased
+    bool _collect_or_retire(ConnectionTable &table, ConnectionTable::iterator it);
+
+    //! Answer a SYN with a SYN-ACK whose ISN is a cookie, without keeping state
+    void _send_cookie(const FourTuple &tuple, const TCPSegment &syn);
+
+    //! Create a connection from an ACK that echoes a valid cookie
+    //! \returns `true` if the cookie was valid
+    bool _accept_cookie(const FourTuple &tuple, const TCPSegment &ack);
+
+  public:
+    //! Construct a listener whose connections use `cfg`
+    TCPListener(const TCPConfig &cfg, const TCPListenerConfig &listener_cfg)
+        : _cfg(cfg), _listener_cfg(listener_cfg), _time_wait(10 * size_t{cfg.rt_timeout}) {}
+
+    //! Called when a new segment for this listener has been received from the network
+    void segment_received(const FourTuple &tuple, const TCPSegment &seg);
+
+    //! Called periodically when time elapses
+    void tick(const size_t ms_since_last_tick);
+
+    //! \brief Segments (and their connections) that the listener has enqueued for transmission
+    std::queue<std::pair<FourTuple, TCPSegment>> &segments_out() { return _segments_out; }
+
+    //! \brief Actively open a connection to the peer identified by `tuple`
+    //! \returns the new connection (throws std::runtime_error if `tuple` is already in use)
+    TCPConnection &connect(const FourTuple &tuple);
+
+    //! \brief Take the next connection that has completed its handshake
+    //! \returns the connection's tuple, or empty if there is none
+    std::optional<FourTuple> accept();
+
+    //! \brief Access an established connection (throws std::out_of_range if there is none)
+    TCPConnection &connection(const FourTuple &tuple) { return _connections.at(tuple); }
+
+    //! \name Accessors
+    //!@{
+    size_t syn_queue_size() const { return _syn_queue.size(); }       //!< Number of half-open connections
+    size_t connection_count() const { return _connections.size(); }  //!< Number of established connections
+    size_t time_wait_count() const { return _time_wait.size(); }      //!< Number of tuples in TIME_WAIT
+    //! Whether a new SYN would be answered with a cookie
+    bool cookies_active() const { return _syn_queue.size() >= _listener_cfg.syn_cookie_threshold; }
+    const Stats &stats() const { return _stats; }  //!< Handshake counters
+    //!@}
+};
+
+#endif  // SPONGE_LIBSPONGE_TCP_LISTENER_HH
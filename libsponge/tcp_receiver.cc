@@ -40,8 +40,8 @@ void TCPReceiver::segment_received(const TCPSegment &seg) {
     // 如果 syn 被设置, 减去 syn 占用的序列号
     if (!seg.header().syn) index--;
 
-    // 将 seg 的数据部分写入重组器
-    reassembler_.push_substring(seg.payload().copy(), index, seg.header().fin);
+    // 将 seg 的数据部分写入重组器(直接传入视图,不先复制一份)
+    reassembler_.push_substring(seg.payload().str(), index, seg.header().fin);
 
     // 更新期望的序列号seqno_
     seqno_ = reassembler_.stream_out().bytes_written() + 1;
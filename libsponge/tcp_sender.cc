@@ -57,14 +57,15 @@ void TCPSender::fill_window() {
 
         // 计算并且设置数据部分(payload), 取配置文件中payload的值和当前窗口 - 已发出还未确认的数据 - syn 所占用的序列号, 二者较小的一个
         const size_t payload_size = min(TCPConfig::MAX_PAYLOAD_SIZE, curr_window_size - _outgoing_bytes - segment.header().syn);
-        string payload = _stream.read(payload_size);
+        // 读取时顺便计算校验和的部分和,序列化时不必再遍历一次payload
+        Buffer payload = _stream.read_checksummed(payload_size);
 
         // 设置 FIN 标志位， 如果尚未发送 FIN 并且字节流已经结束（_stream.eof()）并且当前窗口空间足够容纳一个 FIN 标志
         if (!_set_fin_flag && _stream.eof() && payload.size() + _outgoing_bytes < curr_window_size)
             _set_fin_flag = segment.header().fin = true;
 
         // step 6, 直接转移payload，不用copy节省开销
-        segment.payload() = Buffer(move(payload));
+        segment.payload() = move(payload);
 
         // step 7, 如果没有数据在序列号空间中(包括没有 syn 和 fin)，直接退出
         if (segment.length_in_sequence_space() == 0) { break; }
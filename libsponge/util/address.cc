@@ -105,6 +105,19 @@ string Address::to_string() const {
     return ip_and_port.first + ":" + ::to_string(ip_and_port.second);
 }
 
+//! \details Read straight from the socket address (unlike ip_port(), which formats it), as the TCP
+//! adapters check it for every segment they receive
+uint16_t Address::port() const {
+    switch (_address.storage.ss_family) {
+        case AF_INET:
+            return be16toh(reinterpret_cast<const sockaddr_in *>(&_address.storage)->sin_port);
+        case AF_INET6:
+            return be16toh(reinterpret_cast<const sockaddr_in6 *>(&_address.storage)->sin6_port);
+        default:
+            return ip_port().second;
+    }
+}
+
 uint32_t Address::ipv4_numeric() const {
     if (_address.storage.ss_family != AF_INET or _size != sizeof(sockaddr_in)) {
         throw runtime_error("ipv4_numeric called on non-IPV4 address");
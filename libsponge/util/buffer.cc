@@ -1,14 +1,70 @@
 #include "buffer.hh"
 
+#include <new>
+
 using namespace std;
 
+Buffer::Buffer(string &&str) noexcept : _storage(new(PacketPool::allocate(sizeof(Storage))) Storage{move(str)}) {}
+
+Buffer::Buffer(const Buffer &other) noexcept
+    : _storage(other._storage), _starting_offset(other._starting_offset), _cksum_partial(other._cksum_partial) {
+    if (_storage) {
+        ++_storage->refs;
+    }
+}
+
+Buffer::Buffer(Buffer &&other) noexcept
+    : _storage(other._storage), _starting_offset(other._starting_offset), _cksum_partial(other._cksum_partial) {
+    other._storage = nullptr;
+    other._starting_offset = 0;
+    other._cksum_partial.reset();
+}
+
+Buffer &Buffer::operator=(const Buffer &other) noexcept {
+    if (this != &other) {
+        if (other._storage) {
+            ++other._storage->refs;
+        }
+        _release();
+        _storage = other._storage;
+        _starting_offset = other._starting_offset;
+        _cksum_partial = other._cksum_partial;
+    }
+    return *this;
+}
+
+Buffer &Buffer::operator=(Buffer &&other) noexcept {
+    if (this != &other) {
+        _release();
+        _storage = other._storage;
+        _starting_offset = other._starting_offset;
+        _cksum_partial = other._cksum_partial;
+        other._storage = nullptr;
+        other._starting_offset = 0;
+        other._cksum_partial.reset();
+    }
+    return *this;
+}
+
+void Buffer::_release() noexcept {
+    if (_storage and --_storage->refs == 0) {
+        _storage->~Storage();
+        PacketPool::deallocate(_storage, sizeof(Storage));
+    }
+    _storage = nullptr;
+}
+
 void Buffer::remove_prefix(const size_t n) {
     if (n > str().size()) {
         throw out_of_range("Buffer::remove_prefix");
     }
     _starting_offset += n;
-    if (_storage and _starting_offset == _storage->size()) {
-        _storage.reset();
+    if (n) {
+        _cksum_partial.reset();
+    }
+    if (_storage and _starting_offset == _storage->str.size()) {
+        _release();
+        _starting_offset = 0;
     }
 }
 
@@ -102,3 +158,11 @@ vector<iovec> BufferViewList::as_iovecs() const {
     }
     return ret;
 }
+
+size_t BufferViewList::as_iovecs(iovec *iovs, const size_t max) const {
+    const size_t count = min(max, _views.size());
+    for (size_t i = 0; i < count; i++) {
+        iovs[i] = {const_cast<char *>(_views[i].data()), _views[i].size()};
+    }
+    return count;
+}
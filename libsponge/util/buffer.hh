@@ -1,27 +1,67 @@
 #ifndef SPONGE_LIBSPONGE_BUFFER_HH
 #define SPONGE_LIBSPONGE_BUFFER_HH
 
+#include "small_vector.hh"
+
 #include <algorithm>
-#include <deque>
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <numeric>
+#include <optional>
 #include <stdexcept>
 #include <string>
 #include <string_view>
 #include <sys/uio.h>
 #include <vector>
 
+#ifdef SPONGE_NONATOMIC_REFCOUNT
+using BufferRefCount = size_t;  //!< Buffers are only shared within a thread (see etc/build_defs.cmake)
+#else
+using BufferRefCount = std::atomic<size_t>;  //!< Buffers may be shared between threads
+#endif
+
 //! \brief A reference-counted read-only string that can discard bytes from the front
+//! \details The string and its reference count are allocated together, from the PacketPool.
 class Buffer {
   private:
-    std::shared_ptr<std::string> _storage{};
+    //! A string shared by Buffers, with an intrusive reference count
+    struct Storage {
+        std::string str;
+        BufferRefCount refs{1};
+    };
+
+    Storage *_storage{};
     size_t _starting_offset{};
+    std::optional<uint16_t> _cksum_partial{};  //!< Sum of the contents, if known (see cksum_partial())
+
+    //! Drop this Buffer's reference to its storage, freeing the storage if it was the last
+    void _release() noexcept;
 
   public:
     Buffer() = default;
 
     //! \brief Construct by taking ownership of a string
-    Buffer(std::string &&str) noexcept : _storage(std::make_shared<std::string>(std::move(str))) {}
+    Buffer(std::string &&str) noexcept;
+
+    //! \brief Construct by taking ownership of a string whose sum was computed as it was copied
+    //! (see InternetChecksum::add_copy)
+    Buffer(std::string &&str, const uint16_t cksum_partial) noexcept : Buffer(std::move(str)) {
+        _cksum_partial = cksum_partial;
+    }
+
+    //! \name Copying shares the string; moving transfers the reference
+    //!@{
+    Buffer(const Buffer &other) noexcept;
+    Buffer(Buffer &&other) noexcept;
+    Buffer &operator=(const Buffer &other) noexcept;
+    Buffer &operator=(Buffer &&other) noexcept;
+    ~Buffer() { _release(); }
+    //!@}
+
+    //! \brief The folded sum of the contents' 16-bit words, if known, for InternetChecksum::add_sum
+    //! \details Lets a checksum cover the contents without reading them again
+    std::optional<uint16_t> cksum_partial() const { return _cksum_partial; }
 
     //! \name Expose contents as a std::string_view
     //!@{
@@ -29,7 +69,7 @@ class Buffer {
         if (not _storage) {
             return {};
         }
-        return {_storage->data() + _starting_offset, _storage->size() - _starting_offset};
+        return {_storage->str.data() + _starting_offset, _storage->str.size() - _starting_offset};
     }
 
     operator std::string_view() const { return str(); }
@@ -55,8 +95,12 @@ class Buffer {
 //! encapsulate a TCP payload in a TCPSegment, and then encapsulate
 //! the TCPSegment in an IPv4Datagram) without copying the payload.
 class BufferList {
+  public:
+    //! The Buffers; a packet's headers and payload usually fit without allocating
+    using Queue = SmallVector<Buffer, 4>;
+
   private:
-    std::deque<Buffer> _buffers{};
+    Queue _buffers{};
 
   public:
     //! \name Constructors
@@ -75,7 +119,7 @@ class BufferList {
     //!@}
 
     //! \brief Access the underlying queue of Buffers
-    const std::deque<Buffer> &buffers() const { return _buffers; }
+    const Queue &buffers() const { return _buffers; }
 
     //! \brief Append a BufferList
     void append(const BufferList &other);
@@ -96,7 +140,7 @@ class BufferList {
 
 //! \brief A non-owning temporary view (similar to std::string_view) of a discontiguous string
 class BufferViewList {
-    std::deque<std::string_view> _views{};
+    SmallVector<std::string_view, 4> _views{};
 
   public:
     //! \name Constructors
@@ -125,6 +169,10 @@ class BufferViewList {
     //! \note used for system calls that write discontiguous buffers,
     //! e.g. [writev(2)](\ref man2::writev) and [sendmsg(2)](\ref man2::sendmsg)
     std::vector<iovec> as_iovecs() const;
+
+    //! \brief Fill a caller-provided array (e.g. on the stack) with up to `max` `iovec` structures
+    //! \returns the number filled; if it is less than the number of views, the rest are left out
+    size_t as_iovecs(iovec *iovs, const size_t max) const;
 };
 
 #endif  // SPONGE_LIBSPONGE_BUFFER_HH
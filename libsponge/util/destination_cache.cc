@@ -0,0 +1,100 @@
+#include "destination_cache.hh"
+
+#include <stdexcept>
+
+using namespace std;
+
+//! \param[in] sets is the number of sets (0 for a cache that never hits)
+DestinationCache::DestinationCache(const size_t sets) : _sets(), _mask(0) {
+    if (sets > (size_t(1) << 24)) {
+        throw runtime_error("DestinationCache: too many sets");
+    }
+    size_t rounded = 1;
+    while (rounded < sets) {
+        rounded <<= 1;
+    }
+    if (sets > 0) {
+        _sets.resize(rounded);
+        _mask = rounded - 1;
+    }
+}
+
+//! \param[in] generation is the generation of the routes the caller is about to look up in
+void DestinationCache::validate(const uint64_t generation) {
+    if (generation == _generation) {
+        return;
+    }
+    _generation = generation;
+
+    // entries filled under an older tag no longer match; only when the tags wrap around must the
+    // entries really be cleared, or some from 2^32 generations ago would match again
+    if (++_tag == 0) {
+        for (auto &set : _sets) {
+            set.tags.fill(0);
+        }
+        _tag = 1;
+    }
+}
+
+//! \param[in] addresses are the destination addresses
+//! \param[out] values are the cached results (left alone for the addresses that miss)
+//! \param[out] missed are the indices of the addresses that miss
+//! \param[in] count is the number of addresses
+size_t DestinationCache::lookup(const uint32_t *addresses,
+                                optional<uint32_t> *values,
+                                size_t *missed,
+                                const size_t count) {
+    if (_sets.empty()) {
+        for (size_t i = 0; i < count; i++) {
+            missed[i] = i;
+        }
+        _misses.store(misses() + count, memory_order_relaxed);
+        return count;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        __builtin_prefetch(&_set(addresses[i]));
+    }
+    size_t misses = 0;
+    for (size_t i = 0; i < count; i++) {
+        const Set &set = _set(addresses[i]);
+        const size_t way = _way(set, addresses[i]);
+        if (way == WAYS) {
+            missed[misses++] = i;
+        } else {
+            values[i] = _value(set.values[way]);
+        }
+    }
+    _hits.store(hits() + count - misses, memory_order_relaxed);
+    _misses.store(this->misses() + misses, memory_order_relaxed);
+    return misses;
+}
+
+//! \param[in] address is the destination address
+//! \param[in] value is the longest-prefix-match result for it, as of the current generation
+void DestinationCache::insert(const uint32_t address, const optional<uint32_t> value) {
+    if (_sets.empty()) {
+        return;
+    }
+    if (value == NO_VALUE) {
+        throw runtime_error("DestinationCache::insert: value too large");
+    }
+
+    // the address's own entry if it has one (the same address can miss twice in a batch), then an
+    // empty or stale entry, and only then the next victim
+    Set &set = _set(address);
+    size_t way = _way(set, address);
+    for (size_t i = 0; i < WAYS and way == WAYS; i++) {
+        if (set.tags[i] != _tag) {
+            way = i;
+        }
+    }
+    if (way == WAYS) {
+        way = set.victim;
+        set.victim = uint8_t((set.victim + 1) % WAYS);
+    }
+
+    set.addresses[way] = address;
+    set.values[way] = value.value_or(NO_VALUE);
+    set.tags[way] = _tag;
+}
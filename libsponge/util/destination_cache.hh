@@ -0,0 +1,119 @@
+#ifndef SPONGE_LIBSPONGE_DESTINATION_CACHE_HH
+#define SPONGE_LIBSPONGE_DESTINATION_CACHE_HH
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+//! \brief A small set-associative cache of longest-prefix-match results, by destination address
+//! \details Traffic is skewed toward a few destinations, so a few thousand of them, kept in an array
+//! small enough to stay in the CPU's caches, answer most lookups without touching the (much larger)
+//! longest-prefix-match table. An address hashes to one set of WAYS entries, one cache line each;
+//! a miss fills an empty (or stale) entry of the set, or else evicts its entries in turn.
+//!
+//! The cached results are those of one version of the routes, which the owner numbers with a
+//! generation: validate() with a new generation empties the cache at once, by retagging instead of
+//! clearing it. A cache belongs to a single thread, but its counters may be read from any.
+class DestinationCache {
+  public:
+    static constexpr size_t WAYS = 4;  //!< Entries per set
+
+  private:
+    static constexpr size_t CACHE_LINE = 64;
+    static constexpr uint32_t NO_VALUE = UINT32_MAX;  //!< The cached result for an address no prefix matches
+
+    struct alignas(CACHE_LINE) Set {
+        std::array<uint32_t, WAYS> addresses{};
+        std::array<uint32_t, WAYS> values{};
+        std::array<uint32_t, WAYS> tags{};  //!< The tag an entry was filled under (0: never filled)
+        uint8_t victim{0};                  //!< The entry to evict next
+    };
+
+    std::vector<Set> _sets;
+    size_t _mask;
+
+    uint64_t _generation{0};  //!< The generation of the routes the entries came from
+    uint32_t _tag{1};         //!< Tag of the current generation's entries
+
+    //! \name Counters: written by the owning thread only, so a store is enough to bump them
+    //!@{
+    std::atomic<uint64_t> _hits{0};
+    std::atomic<uint64_t> _misses{0};
+    //!@}
+
+    Set &_set(const uint32_t address) {
+        uint32_t hash = address * 0x9e37'79b1U;
+        hash ^= hash >> 16;
+        return _sets[hash & _mask];
+    }
+
+    //! The way of `set` that holds `address`, or WAYS if none does
+    size_t _way(const Set &set, const uint32_t address) const {
+        for (size_t way = 0; way < WAYS; way++) {
+            if (set.tags[way] == _tag and set.addresses[way] == address) {
+                return way;
+            }
+        }
+        return WAYS;
+    }
+
+    static std::optional<uint32_t> _value(const uint32_t value) {
+        if (value == NO_VALUE) {
+            return {};
+        }
+        return value;
+    }
+
+    static void _bump(std::atomic<uint64_t> &counter) {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+  public:
+    //! \brief Construct an empty cache of `sets` sets (rounded up to a power of two); with none, it never hits
+    explicit DestinationCache(const size_t sets);
+
+    //! \brief Make sure the entries are of `generation`, discarding them all if it is a new one
+    void validate(const uint64_t generation);
+
+    //! \brief Look up the cached result for `address`, into `value`
+    //! \returns `false` (a miss) if it isn't cached
+    bool lookup(const uint32_t address, std::optional<uint32_t> &value) {
+        if (_sets.empty()) {
+            _bump(_misses);
+            return false;
+        }
+        const Set &set = _set(address);
+        const size_t way = _way(set, address);
+        if (way == WAYS) {
+            _bump(_misses);
+            return false;
+        }
+        _bump(_hits);
+        value = _value(set.values[way]);
+        return true;
+    }
+
+    //! \brief Look up `count` addresses at once: the cached results go into `values`, and the indices
+    //! (in `addresses`) of those that miss into `missed`
+    //! \details Prefetches the sets of all of them before probing any, so that their cache misses overlap
+    //! \returns the number that missed
+    size_t lookup(const uint32_t *addresses, std::optional<uint32_t> *values, size_t *missed, const size_t count);
+
+    //! \brief Cache `value` as the result for `address`
+    //! \note `value` must not be UINT32_MAX
+    void insert(const uint32_t address, const std::optional<uint32_t> value);
+
+    //! Lookups that hit
+    uint64_t hits() const { return _hits.load(std::memory_order_relaxed); }
+
+    //! Lookups that missed (every lookup, if the cache has no sets)
+    uint64_t misses() const { return _misses.load(std::memory_order_relaxed); }
+
+    //! Number of addresses the cache holds
+    size_t capacity() const { return _sets.size() * WAYS; }
+};
+
+#endif  // SPONGE_LIBSPONGE_DESTINATION_CACHE_HH
@@ -0,0 +1,123 @@
+#include "dir_24_8.hh"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+void Dir24_8::_fill(uint32_t *first, const size_t count, const uint32_t value, const uint8_t length) {
+    const uint32_t entry = _entry(value, length);
+    for (size_t i = 0; i < count; i++) {
+        if (_depth(first[i]) <= length) {
+            first[i] = entry;
+        }
+    }
+}
+
+//! \param[in] prefix is the prefix (its bits past `length` are ignored)
+//! \param[in] length is the prefix's length in bits (0 to 32)
+//! \param[in] value is what lookup() returns for addresses that match this prefix best
+void Dir24_8::insert(const uint32_t prefix, const uint8_t length, const uint32_t value) {
+    if (length > 32) {
+        throw runtime_error("Dir24_8::insert: prefix longer than 32 bits");
+    }
+    if (value > MAX_VALUE) {
+        throw runtime_error("Dir24_8::insert: value too large");
+    }
+    _size++;
+
+    if (length <= 24) {
+        const uint32_t begin = length == 0 ? 0 : (prefix >> 8) & (0xff'ffffU << (24 - length));
+        const size_t count = size_t(1) << (24 - length);
+        for (size_t i = begin; i < begin + count; i++) {
+            if (_first[i] & BLOCK) {
+                _fill(&_blocks[(_first[i] & ~BLOCK) * BLOCK_SIZE], BLOCK_SIZE, value, length);
+            } else {
+                _fill(&_first[i], 1, value, length);
+            }
+        }
+        return;
+    }
+
+    // a longer prefix needs the block under its /24, which starts out as the /24's entry throughout
+    uint32_t &first = _first[prefix >> 8];
+    if (not(first & BLOCK)) {
+        const uint32_t inherited = first;
+        first = BLOCK | uint32_t(_blocks.size() / BLOCK_SIZE);
+        _blocks.resize(_blocks.size() + BLOCK_SIZE, inherited);
+    }
+    const uint32_t begin = prefix & 0xff & (0xffU << (32 - length));
+    _fill(&_blocks[(first & ~BLOCK) * BLOCK_SIZE + begin], size_t(1) << (32 - length), value, length);
+}
+
+//! \param[in] addresses are the addresses to look up
+//! \param[out] values is where to put the value of each address's longest matching prefix, if any
+//! \param[in] count is the number of addresses
+void Dir24_8::lookup(const uint32_t *addresses, optional<uint32_t> *values, const size_t count) const {
+    array<uint32_t, BATCH> entries;
+    for (size_t done = 0; done < count; done += BATCH) {
+        const uint32_t *batch = addresses + done;
+        const size_t n = min(BATCH, count - done);
+
+        for (size_t i = 0; i < n; i++) {
+            __builtin_prefetch(&_first[batch[i] >> 8]);
+        }
+        if (_avx2) {
+            _first_entries_avx2(batch, entries.data(), n);
+        } else {
+            _first_entries(batch, entries.data(), n);
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            if (entries[i] & BLOCK) {
+                __builtin_prefetch(&_blocks[(entries[i] & ~BLOCK) * BLOCK_SIZE + (batch[i] & 0xff)]);
+            }
+        }
+        for (size_t i = 0; i < n; i++) {
+            if (entries[i] & BLOCK) {
+                entries[i] = _blocks[(entries[i] & ~BLOCK) * BLOCK_SIZE + (batch[i] & 0xff)];
+            }
+            values[done + i] = _value(entries[i]);
+        }
+    }
+}
+
+void Dir24_8::_first_entries(const uint32_t *addresses, uint32_t *entries, const size_t count) const {
+    for (size_t i = 0; i < count; i++) {
+        entries[i] = _first[addresses[i] >> 8];
+    }
+}
+
+#if defined(__x86_64__)
+__attribute__((target("avx2"))) void Dir24_8::_first_entries_avx2(const uint32_t *addresses,
+                                                                  uint32_t *entries,
+                                                                  const size_t count) const {
+    // a first-level index is at most 24 bits, so it fits the gather's signed 32-bit indices
+    const int *first = reinterpret_cast<const int *>(_first.data());
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i address = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(addresses + i));
+        const __m256i entry = _mm256_i32gather_epi32(first, _mm256_srli_epi32(address, 8), sizeof(uint32_t));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(entries + i), entry);
+    }
+    _first_entries(addresses + i, entries + i, count - i);
+}
+#else
+void Dir24_8::_first_entries_avx2(const uint32_t *addresses, uint32_t *entries, const size_t count) const {
+    _first_entries(addresses, entries, count);
+}
+#endif
+
+bool Dir24_8::_cpu_has_avx2() {
+#if defined(__x86_64__)
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    return has_avx2;
+#else
+    return false;
+#endif
+}
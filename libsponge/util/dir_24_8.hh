@@ -0,0 +1,101 @@
+#ifndef SPONGE_LIBSPONGE_DIR_24_8_HH
+#define SPONGE_LIBSPONGE_DIR_24_8_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+//! \brief Longest-prefix match over IPv4 prefixes, with a DIR-24-8 table
+//! \details After Gupta, Lin and McKeown, "Routing Lookups in Hardware at Memory Access Speeds"
+//! (INFOCOM 1998). The top 24 bits of an address index a first-level array of 2^24 entries; an
+//! entry either holds the value of the longest prefix (of up to 24 bits) that covers it, or points
+//! to a 256-entry second-level block, indexed by the last 8 bits, for addresses that prefixes longer
+//! than /24 cover. A lookup is at most two memory accesses, at the price of a first level of 64 MiB
+//! whatever the size of the table.
+//!
+//! Each entry also records the length of the prefix that set it, so that prefixes can be inserted
+//! in any order and take effect at once: a prefix only overwrites entries set by shorter ones.
+class Dir24_8 {
+  public:
+    static constexpr uint32_t MAX_VALUE = 0x00ff'fffe;  //!< Largest value a prefix can map to
+    static constexpr size_t BATCH = 32;                 //!< Addresses that a batched lookup prefetches together
+
+  private:
+    //! \name An entry: the value, and one more than the length of the prefix that set it (0 if none did)
+    //!@{
+    static constexpr uint32_t VALUE_MASK = 0x00ff'ffff;
+    static constexpr uint32_t NO_VALUE = VALUE_MASK;
+    static constexpr unsigned DEPTH_SHIFT = 24;
+    static constexpr uint32_t BLOCK = 0x8000'0000;  //!< Set in a first-level entry that points to a block
+    //!@}
+
+    static constexpr size_t BLOCK_SIZE = 256;  //!< Entries in a second-level block
+
+    std::vector<uint32_t> _first;     //!< By top 24 address bits: an entry, or BLOCK | a block number
+    std::vector<uint32_t> _blocks{};  //!< Second-level blocks, one after another
+    size_t _size{0};                  //!< Number of prefixes inserted
+
+    bool _avx2;  //!< Does the CPU have AVX2 (and its gather instructions)?
+
+    static uint32_t _entry(const uint32_t value, const uint8_t length) {
+        return (uint32_t(length + 1) << DEPTH_SHIFT) | value;
+    }
+    static unsigned _depth(const uint32_t entry) { return (entry & ~BLOCK) >> DEPTH_SHIFT; }
+    static std::optional<uint32_t> _value(const uint32_t entry) {
+        const uint32_t value = entry & VALUE_MASK;
+        if (value == NO_VALUE) {
+            return {};
+        }
+        return value;
+    }
+
+    //! Set `count` entries from `first` to the prefix's entry, except those set by longer (or equal) prefixes
+    static void _fill(uint32_t *first, const size_t count, const uint32_t value, const uint8_t length);
+
+    //! \name Read the first-level entries of `count` addresses, one at a time or eight at a time
+    //!@{
+    void _first_entries(const uint32_t *addresses, uint32_t *entries, const size_t count) const;
+    void _first_entries_avx2(const uint32_t *addresses, uint32_t *entries, const size_t count) const;
+    //!@}
+
+    //! Does the CPU have AVX2?
+    static bool _cpu_has_avx2();
+
+  public:
+    //! Construct an empty table
+    Dir24_8() : _first(size_t(1) << 24, NO_VALUE), _avx2(_cpu_has_avx2()) {}
+
+    //! \brief Add a prefix: the `length` high-order bits of `prefix`, which map to `value`
+    //! \note If the same prefix is added twice, the first value is the one that is found
+    void insert(const uint32_t prefix, const uint8_t length, const uint32_t value);
+
+    //! \name For interchangeability with Poptrie: inserted prefixes take effect at once
+    //!@{
+    void build() {}
+    bool stale() const { return false; }
+    //!@}
+
+    //! \brief The value of the longest prefix that matches `address`, if any does
+    std::optional<uint32_t> lookup(const uint32_t address) const {
+        uint32_t entry = _first[address >> 8];
+        if (entry & BLOCK) {
+            entry = _blocks[(entry & ~BLOCK) * BLOCK_SIZE + (address & 0xff)];
+        }
+        return _value(entry);
+    }
+
+    //! \brief Look up `count` addresses at once, into `values`
+    //! \details Takes BATCH addresses at a time: prefetches their first-level entries, reads them
+    //! (with AVX2 gathers if the CPU has them), then prefetches the second-level entries of those that
+    //! need one before reading any, so that the cache misses of a batch overlap
+    void lookup(const uint32_t *addresses, std::optional<uint32_t> *values, const size_t count) const;
+
+    //! Number of prefixes inserted (counting a prefix inserted twice twice)
+    size_t size() const { return _size; }
+
+    //! Bytes used by the table
+    size_t memory_usage() const { return (_first.size() + _blocks.size()) * sizeof(uint32_t); }
+};
+
+#endif  // SPONGE_LIBSPONGE_DIR_24_8_HH
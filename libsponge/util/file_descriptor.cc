@@ -3,6 +3,7 @@
 #include "util.hh"
 
 #include <algorithm>
+#include <array>
 #include <fcntl.h>
 #include <iostream>
 #include <stdexcept>
@@ -76,10 +77,13 @@ string FileDescriptor::read(const size_t limit) {
 size_t FileDescriptor::write(BufferViewList buffer, const bool write_all) {
     size_t total_bytes_written = 0;
 
+    // writev() may write less than everything anyway, so any slices past the array go in the next round
+    array<iovec, 16> iovecs;
+
     do {
-        auto iovecs = buffer.as_iovecs();
+        const size_t iovec_count = buffer.as_iovecs(iovecs.data(), iovecs.size());
 
-        const ssize_t bytes_written = SystemCall("writev", ::writev(fd_num(), iovecs.data(), iovecs.size()));
+        const ssize_t bytes_written = SystemCall("writev", ::writev(fd_num(), iovecs.data(), iovec_count));
         if (bytes_written == 0 and buffer.size() != 0) {
             throw runtime_error("write returned 0 given non-empty input buffer");
         }
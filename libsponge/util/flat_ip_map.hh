@@ -0,0 +1,117 @@
+#ifndef SPONGE_LIBSPONGE_FLAT_IP_MAP_HH
+#define SPONGE_LIBSPONGE_FLAT_IP_MAP_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+//! \brief A hash map from IPv4 addresses to `T`, in one flat array
+//! \details Open addressing with linear probing: an address hashes (by Fibonacci hashing, which
+//! spreads out neighboring addresses) to a slot, and is kept there or in the first free slot after
+//! it, so a lookup reads a few adjacent slots instead of chasing pointers down a tree. The array is
+//! kept at most half full, and doubles when it would get fuller. Erasing shifts the slots after the
+//! erased one back into place (instead of leaving a tombstone), so that probes stay short however
+//! many addresses come and go.
+//!
+//! Pointers to values stay valid until the next insertion or erasure.
+template <typename T>
+class FlatIpMap {
+  private:
+    struct Slot {
+        uint32_t key{0};
+        bool used{false};
+        T value{};
+    };
+
+    std::vector<Slot> _slots;
+    unsigned _bits;  //!< `_slots` has 2^_bits slots
+    size_t _size{0};
+
+    //! The slot where a probe for `key` starts
+    size_t _home(const uint32_t key) const { return (uint64_t(key) * 0x9e37'79b9'7f4a'7c15) >> (64 - _bits); }
+
+    size_t _next(const size_t index) const { return (index + 1) & (_slots.size() - 1); }
+
+    //! The slot holding `key`, or the free slot where its probe ends
+    size_t _probe(const uint32_t key) const {
+        size_t index = _home(key);
+        while (_slots[index].used and _slots[index].key != key) {
+            index = _next(index);
+        }
+        return index;
+    }
+
+    void _grow() {
+        std::vector<Slot> old(size_t(2) << _bits);
+        old.swap(_slots);
+        _bits++;
+        for (auto &slot : old) {
+            if (slot.used) {
+                _slots[_probe(slot.key)] = std::move(slot);
+            }
+        }
+    }
+
+  public:
+    //! Construct an empty map
+    FlatIpMap() : _slots(16), _bits(4) {}
+
+    //! \brief The value for `key`, or nullptr if there is none
+    T *find(const uint32_t key) {
+        Slot &slot = _slots[_probe(key)];
+        return slot.used ? &slot.value : nullptr;
+    }
+    const T *find(const uint32_t key) const {
+        const Slot &slot = _slots[_probe(key)];
+        return slot.used ? &slot.value : nullptr;
+    }
+
+    //! \brief Set the value for `key`, adding it if it isn't there
+    //! \returns the value in the map
+    T &insert_or_assign(const uint32_t key, T value) {
+        size_t index = _probe(key);
+        if (not _slots[index].used) {
+            if (2 * (_size + 1) > _slots.size()) {
+                _grow();
+                index = _probe(key);
+            }
+            _slots[index].key = key;
+            _slots[index].used = true;
+            _size++;
+        }
+        _slots[index].value = std::move(value);
+        return _slots[index].value;
+    }
+
+    //! \brief Remove `key`
+    //! \returns `false` if it wasn't there
+    bool erase(const uint32_t key) {
+        size_t hole = _probe(key);
+        if (not _slots[hole].used) {
+            return false;
+        }
+
+        // move back each later slot of the run whose probe starts at or before the hole (cyclically),
+        // which would otherwise no longer be found past it
+        for (size_t index = _next(hole); _slots[index].used; index = _next(index)) {
+            const size_t home = _home(_slots[index].key);
+            const bool reaches_hole = hole <= index ? (home <= hole or home > index) : (home <= hole and home > index);
+            if (reaches_hole) {
+                _slots[hole] = std::move(_slots[index]);
+                hole = index;
+            }
+        }
+        _slots[hole] = Slot{};
+        _size--;
+        return true;
+    }
+
+    //! Number of addresses in the map
+    size_t size() const { return _size; }
+
+    //! Is the map empty?
+    bool empty() const { return _size == 0; }
+};
+
+#endif  // SPONGE_LIBSPONGE_FLAT_IP_MAP_HH
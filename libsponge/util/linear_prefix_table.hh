@@ -0,0 +1,47 @@
+#ifndef SPONGE_LIBSPONGE_LINEAR_PREFIX_TABLE_HH
+#define SPONGE_LIBSPONGE_LINEAR_PREFIX_TABLE_HH
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+//! \brief Longest-prefix match over IPv4 prefixes, by scanning every prefix on each lookup
+//! \details This is how Router used to route. It is O(prefixes) per lookup, but simple enough to be
+//! obviously right, so it serves as the reference that the faster tables (e.g. Poptrie) are tested against.
+class LinearPrefixTable {
+  private:
+    struct Entry {
+        uint32_t prefix;
+        uint8_t length;
+        uint32_t value;
+    };
+    std::vector<Entry> _entries{};
+
+  public:
+    //! \brief Add a prefix: the `length` high-order bits of `prefix`, which map to `value`
+    //! \note If the same prefix is added twice, the first value is the one that is found
+    void insert(const uint32_t prefix, const uint8_t length, const uint32_t value) {
+        _entries.push_back({prefix, length, value});
+    }
+
+    //! \brief The value of the longest prefix that matches `address`, if any does
+    std::optional<uint32_t> lookup(const uint32_t address) const {
+        const Entry *best = nullptr;
+        for (const auto &entry : _entries) {
+            if (entry.length == 0 or (entry.prefix ^ address) >> (32 - entry.length) == 0) {
+                if (best == nullptr or best->length < entry.length) {
+                    best = &entry;
+                }
+            }
+        }
+        if (best == nullptr) {
+            return {};
+        }
+        return best->value;
+    }
+
+    //! Number of prefixes added
+    size_t size() const { return _entries.size(); }
+};
+
+#endif  // SPONGE_LIBSPONGE_LINEAR_PREFIX_TABLE_HH
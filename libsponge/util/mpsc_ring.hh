@@ -0,0 +1,92 @@
+#ifndef SPONGE_LIBSPONGE_MPSC_RING_HH
+#define SPONGE_LIBSPONGE_MPSC_RING_HH
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+//! \brief A bounded, lock-free queue for any number of producer threads and one consumer thread
+//! \details After Vyukov's bounded MPMC queue. The capacity is rounded up to a power of two, and
+//! each slot carries a sequence number that says whose turn it is: a producer may fill slot
+//! `pos & mask` when its sequence is `pos`, and the consumer may empty it when its sequence is
+//! `pos + 1`. Producers claim positions with a compare-and-swap on `_tail`; the single consumer
+//! owns `_head` outright, so popping needs no atomic read-modify-write at all.
+template <typename T>
+class MPSCRing {
+  private:
+    static constexpr size_t CACHE_LINE = 64;
+
+    struct Slot {
+        std::atomic<size_t> sequence{0};
+        std::optional<T> value{};
+    };
+
+    std::unique_ptr<Slot[]> _slots;
+    size_t _mask;
+
+    alignas(CACHE_LINE) std::atomic<size_t> _tail{0};  //!< Next position to push (claimed by producers)
+    alignas(CACHE_LINE) size_t _head{0};               //!< Next position to pop (consumer only)
+
+    static size_t _round_up(const size_t capacity) {
+        if (capacity == 0) {
+            throw std::runtime_error("MPSCRing: capacity must be positive");
+        }
+        size_t rounded = 1;
+        while (rounded < capacity) {
+            rounded <<= 1;
+        }
+        return rounded;
+    }
+
+  public:
+    //! Construct a ring holding at least `capacity` elements
+    explicit MPSCRing(const size_t capacity)
+        : _slots(std::make_unique<Slot[]>(_round_up(capacity))), _mask(_round_up(capacity) - 1) {
+        for (size_t i = 0; i <= _mask; i++) {
+            _slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    //! \brief Append an element (any thread)
+    //! \returns `false` if the ring is full, in which case `value` is left untouched
+    bool push(T &&value) {
+        size_t pos = _tail.load(std::memory_order_relaxed);
+        while (true) {
+            Slot &slot = _slots[pos & _mask];
+            const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            if (sequence == pos) {
+                if (_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    slot.value.emplace(std::move(value));
+                    slot.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (sequence < pos) {
+                return false;  // the slot still holds the element from a lap ago
+            } else {
+                pos = _tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    //! \brief Remove the oldest element (consumer only)
+    //! \returns the element, or empty if the ring is empty
+    std::optional<T> pop() {
+        Slot &slot = _slots[_head & _mask];
+        if (slot.sequence.load(std::memory_order_acquire) != _head + 1) {
+            return {};
+        }
+        std::optional<T> ret{std::move(slot.value)};
+        slot.value.reset();
+        slot.sequence.store(_head + _mask + 1, std::memory_order_release);
+        _head++;
+        return ret;
+    }
+
+    //! \brief Maximum number of elements the ring can hold
+    size_t capacity() const { return _mask + 1; }
+};
+
+#endif  // SPONGE_LIBSPONGE_MPSC_RING_HH
@@ -0,0 +1,23 @@
+#include "packet_buffer.hh"
+
+#include <stdexcept>
+
+using namespace std;
+
+//! \param[in] headroom is the total length of the headers the packet will be given
+//! \param[in] payload is the packet's contents so far
+PacketBuffer::PacketBuffer(const size_t headroom, const BufferList &payload) : _storage(), _head(headroom) {
+    _storage.reserve(headroom + payload.size());
+    _storage.append(headroom, 0);
+    for (const auto &buffer : payload.buffers()) {
+        _storage.append(buffer.str());
+    }
+}
+
+char *PacketBuffer::prepend(const size_t n) {
+    if (n > _head) {
+        throw runtime_error("PacketBuffer::prepend: not enough headroom");
+    }
+    _head -= n;
+    return _storage.data() + _head;
+}
@@ -0,0 +1,37 @@
+#ifndef SPONGE_LIBSPONGE_PACKET_BUFFER_HH
+#define SPONGE_LIBSPONGE_PACKET_BUFFER_HH
+
+#include "buffer.hh"
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+//! \brief A contiguous packet with room reserved in front of it, so each layer can write its header in place
+//! \details Like a kernel's sk_buff or mbuf: the payload is copied in once, behind enough headroom for
+//! every header the packet will get, and then each layer (innermost first) prepends its header. The
+//! finished packet is one contiguous string, for a single write(2).
+class PacketBuffer {
+  private:
+    std::string _storage;
+    size_t _head;  //!< Offset of the packet's first byte; everything in front of it is headroom
+
+  public:
+    //! \brief Construct by copying `payload` behind `headroom` bytes of room for headers
+    PacketBuffer(const size_t headroom, const BufferList &payload);
+
+    //! \brief Grow the packet by `n` bytes at the front (for a header), taken from the headroom
+    //! \returns where the new bytes start, for the caller to fill in
+    char *prepend(const size_t n);
+
+    //! \brief Bytes of room left in front of the packet
+    size_t headroom() const { return _head; }
+
+    //! \brief Size of the packet
+    size_t size() const { return _storage.size() - _head; }
+
+    //! \brief The packet's contents
+    std::string_view str() const { return std::string_view(_storage).substr(_head); }
+};
+
+#endif  // SPONGE_LIBSPONGE_PACKET_BUFFER_HH
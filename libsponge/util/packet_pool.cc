@@ -0,0 +1,69 @@
+#include "packet_pool.hh"
+
+#include <new>
+
+using namespace std;
+
+//! Has the calling thread destroyed its pool (so blocks freed now must go back to `operator delete`)?
+static thread_local bool local_pool_destroyed = false;
+
+//! \returns the index of the smallest size class that fits `size`, or SIZE_CLASSES.size() if none does
+static size_t size_class(const size_t size) {
+    size_t ret = 0;
+    while (ret < PacketPool::SIZE_CLASSES.size() and PacketPool::SIZE_CLASSES[ret] < size) {
+        ret++;
+    }
+    return ret;
+}
+
+PacketPool *PacketPool::local() {
+    static thread_local PacketPool pool;
+    return local_pool_destroyed ? nullptr : &pool;
+}
+
+PacketPool::~PacketPool() {
+    local_pool_destroyed = true;
+    for (auto &blocks : _free_blocks) {
+        for (void *block : blocks) {
+            ::operator delete(block);
+        }
+    }
+}
+
+//! \param[in] size is the number of bytes needed
+void *PacketPool::allocate(const size_t size) {
+    PacketPool *pool = local();
+    const size_t cls = size_class(size);
+    if (pool) {
+        pool->_stats.allocations++;
+        if (cls == SIZE_CLASSES.size()) {
+            pool->_stats.oversized++;
+        } else if (not pool->_free_blocks[cls].empty()) {
+            pool->_stats.reuses++;
+            void *block = pool->_free_blocks[cls].back();
+            pool->_free_blocks[cls].pop_back();
+            return block;
+        }
+    }
+    return ::operator new(cls == SIZE_CLASSES.size() ? size : SIZE_CLASSES[cls]);
+}
+
+//! \param[in] block is a block returned by allocate()
+//! \param[in] size is the size that was passed to allocate()
+void PacketPool::deallocate(void *block, const size_t size) {
+    PacketPool *pool = local();
+    const size_t cls = size_class(size);
+    if (pool) {
+        pool->_stats.deallocations++;
+        if (cls < SIZE_CLASSES.size() and pool->_free_blocks[cls].size() < MAX_FREE_BLOCKS) {
+            pool->_free_blocks[cls].push_back(block);
+            return;
+        }
+    }
+    ::operator delete(block);
+}
+
+PacketPool::Stats PacketPool::stats() {
+    const PacketPool *pool = local();
+    return pool ? pool->_stats : Stats{};
+}
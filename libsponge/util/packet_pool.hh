@@ -0,0 +1,85 @@
+#ifndef SPONGE_LIBSPONGE_PACKET_POOL_HH
+#define SPONGE_LIBSPONGE_PACKET_POOL_HH
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//! \brief A per-thread cache of memory blocks for packet data, in a few size classes
+//! \details allocate() rounds a request up to a size class and reuses a block of that class freed
+//! earlier on the same thread, if there is one; requests larger than the largest class go straight
+//! to `operator new`. A block may be freed on any thread, and is then kept by that thread (up to
+//! MAX_FREE_BLOCKS per class), so the common case takes no locks and no atomic operations.
+class PacketPool {
+  public:
+    //! Block sizes, in bytes (requests are rounded up to the next one)
+    static constexpr std::array<size_t, 8> SIZE_CLASSES{32, 64, 128, 256, 512, 1024, 2048, 4096};
+
+    static constexpr size_t MAX_FREE_BLOCKS = 4096;  //!< Most free blocks a thread keeps per size class
+
+    //! Counts of what a thread's allocate() and deallocate() calls did
+    struct Stats {
+        uint64_t allocations = 0;    //!< Calls to allocate()
+        uint64_t reuses = 0;         //!< ...that were served from a free list
+        uint64_t oversized = 0;      //!< ...that were larger than any size class
+        uint64_t deallocations = 0;  //!< Calls to deallocate()
+    };
+
+  private:
+    std::array<std::vector<void *>, SIZE_CLASSES.size()> _free_blocks{};  //!< Free blocks by size class
+    Stats _stats{};
+
+    PacketPool() = default;
+
+    //! The calling thread's pool, or `nullptr` once the thread has begun to exit
+    static PacketPool *local();
+
+  public:
+    ~PacketPool();
+
+    //! Allocate `size` bytes (aligned as `operator new` aligns them)
+    static void *allocate(const size_t size);
+
+    //! Free a block from allocate(); `size` must be the size it was allocated with
+    static void deallocate(void *block, const size_t size);
+
+    //! The calling thread's counts
+    static Stats stats();
+
+    PacketPool(const PacketPool &) = delete;
+    PacketPool &operator=(const PacketPool &) = delete;
+};
+
+//! \brief A standard-library allocator that draws from PacketPool (e.g. for containers of packets)
+template <typename T>
+class PoolAllocator {
+  public:
+    using value_type = T;  //!< Type of the elements allocated
+
+    PoolAllocator() = default;
+
+    //! Rebind from an allocator of another type
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U> & /* unused */) noexcept {}
+
+    //! Allocate room for `n` elements
+    T *allocate(const size_t n) { return static_cast<T *>(PacketPool::allocate(n * sizeof(T))); }
+
+    //! Free room for `n` elements
+    void deallocate(T *p, const size_t n) { PacketPool::deallocate(p, n * sizeof(T)); }
+
+    //! All PoolAllocators draw from the same pools
+    template <typename U>
+    bool operator==(const PoolAllocator<U> & /* unused */) const {
+        return true;
+    }
+
+    //! All PoolAllocators draw from the same pools
+    template <typename U>
+    bool operator!=(const PoolAllocator<U> & /* unused */) const {
+        return false;
+    }
+};
+
+#endif  // SPONGE_LIBSPONGE_PACKET_POOL_HH
@@ -1,5 +1,8 @@
 #include "parser.hh"
 
+#include <cstring>
+#include <endian.h>
+
 using namespace std;
 
 //! \param[in] r is the ParseResult to show
@@ -70,3 +73,13 @@ void NetUnparser::u32(string &s, const uint32_t val) { return _unparse_int<uint3
 void NetUnparser::u16(string &s, const uint16_t val) { return _unparse_int<uint16_t>(s, val); }
 
 void NetUnparser::u8(string &s, const uint8_t val) { return _unparse_int<uint8_t>(s, val); }
+
+void NetUnparser::u32(char *dst, const uint32_t val) {
+    const uint32_t big_endian = htobe32(val);
+    memcpy(dst, &big_endian, sizeof(big_endian));
+}
+
+void NetUnparser::u16(char *dst, const uint16_t val) {
+    const uint16_t big_endian = htobe16(val);
+    memcpy(dst, &big_endian, sizeof(big_endian));
+}
@@ -5,7 +5,10 @@
 
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
+#include <endian.h>
 #include <string>
+#include <string_view>
 #include <utility>
 
 //! The result of parsing or unparsing an IP datagram, TCP segment, Ethernet frame, or ARP message
@@ -63,6 +66,38 @@ class NetParser {
     void remove_prefix(const size_t n);
 };
 
+//! \brief A read-only view of a header in a raw packet, which decodes each field only when it is asked for
+//! \details Nothing is copied or allocated. A view is only made over at least `MinLength` bytes
+//! (the header's fixed part), so the fields, whose offsets are known at compile time, are checked at
+//! compile time to lie within it.
+template <size_t MinLength>
+class HeaderView {
+  protected:
+    std::string_view _bytes;  //!< The header and whatever follows it
+
+    //! \param[in] bytes must be at least `MinLength` bytes long
+    explicit HeaderView(const std::string_view bytes) : _bytes(bytes) {}
+
+    //! The integer of type `T` at `Offset` bytes into the header, in host byte order
+    template <size_t Offset, typename T>
+    T field() const {
+        static_assert(Offset + sizeof(T) <= MinLength, "field lies outside the header");
+        T val;
+        memcpy(&val, _bytes.data() + Offset, sizeof(T));
+        if constexpr (sizeof(T) == 4) {
+            return be32toh(val);
+        } else if constexpr (sizeof(T) == 2) {
+            return be16toh(val);
+        } else {
+            return val;
+        }
+    }
+
+  public:
+    //! The header and whatever follows it
+    std::string_view bytes() const { return _bytes; }
+};
+
 // 将数据转换为字节流格式，序列化为网络字节序
 struct NetUnparser {
     template <typename T>
@@ -76,6 +111,13 @@ struct NetUnparser {
 
     //! Write an 8-bit integer into the data stream in network byte order
     static void u8(std::string &s, const uint8_t val);
+
+    //! \name Write an integer in network byte order at a fixed place (e.g. a field of a header serialized in place)
+    //!@{
+    static void u32(char *dst, const uint32_t val);
+    static void u16(char *dst, const uint16_t val);
+    static void u8(char *dst, const uint8_t val) { *dst = char(val); }
+    //!@}
 };
 
 #endif  // SPONGE_LIBSPONGE_PARSER_HH
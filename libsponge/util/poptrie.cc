@@ -0,0 +1,255 @@
+#include "poptrie.hh"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <utility>
+
+using namespace std;
+
+//! The `length` high-order bits of `prefix` (the rest cleared)
+static uint32_t masked(const uint32_t prefix, const uint8_t length) {
+    return length == 0 ? 0 : prefix & (0xffff'ffffU << (32 - length));
+}
+
+//! The `width` bits of `address` that start `offset` bits from its high-order end (zeros past its end)
+static uint32_t bits(const uint32_t address, const unsigned offset, const unsigned width) {
+    return ((uint64_t(address) << 32) << offset) >> (64 - width);
+}
+
+//! \param[in] prefix is the prefix (its bits past `length` are ignored)
+//! \param[in] length is the prefix's length in bits (0 to 32)
+//! \param[in] value is what lookup() returns for addresses that match this prefix best
+void Poptrie::insert(const uint32_t prefix, const uint8_t length, const uint32_t value) {
+    if (length > 32) {
+        throw runtime_error("Poptrie::insert: prefix longer than 32 bits");
+    }
+    if (value > MAX_VALUE) {
+        throw runtime_error("Poptrie::insert: value too large");
+    }
+    _routes.push_back({masked(prefix, length), length, value});
+    _stale = true;
+}
+
+//! \details Inlined into the lookups, so that each counts bits its own way
+__attribute__((always_inline)) inline void Poptrie::_descend(uint32_t &entry,
+                                                             const uint64_t key,
+                                                             unsigned &offset) const {
+    const Node &node = _nodes[entry];
+    const unsigned slot = (key << offset) >> (64 - STRIDE);
+    const uint64_t up_to_slot = (uint64_t(2) << slot) - 1;  // bits 0 through `slot`
+    if (node.children >> slot & 1) {
+        entry = node.child_base + __builtin_popcountll(node.children & up_to_slot) - 1;
+        offset += STRIDE;
+    } else {
+        entry = LEAF | _leaves[node.leaf_base + __builtin_popcountll(node.leaves & up_to_slot) - 1];
+    }
+}
+
+inline optional<uint32_t> Poptrie::_value(const uint32_t entry) {
+    const uint32_t value = entry & ~LEAF;
+    if (value == NO_VALUE) {
+        return {};
+    }
+    return value;
+}
+
+//! \details Inlined into _lookup_popcnt() and _lookup_generic()
+__attribute__((always_inline)) inline optional<uint32_t> Poptrie::_lookup(const uint32_t address) const {
+    uint32_t entry = _direct[address >> (32 - DIRECT_BITS)];
+    // the address, left-aligned in 64 bits so that slots past its end read as zeros
+    const uint64_t key = uint64_t(address) << 32;
+    unsigned offset = DIRECT_BITS;
+    while (not(entry & LEAF)) {
+        _descend(entry, key, offset);
+    }
+    return _value(entry);
+}
+
+//! \details Inlined into _lookup_batch_popcnt() and _lookup_batch_generic()
+__attribute__((always_inline)) inline void Poptrie::_lookup_batch(const uint32_t *addresses,
+                                                                  optional<uint32_t> *values,
+                                                                  const size_t count) const {
+    array<uint32_t, BATCH> entries;
+    array<unsigned, BATCH> offsets;
+    for (size_t done = 0; done < count; done += BATCH) {
+        const uint32_t *batch = addresses + done;
+        const size_t n = min(BATCH, count - done);
+
+        for (size_t i = 0; i < n; i++) {
+            __builtin_prefetch(&_direct[batch[i] >> (32 - DIRECT_BITS)]);
+        }
+        bool walking = false;
+        for (size_t i = 0; i < n; i++) {
+            entries[i] = _direct[batch[i] >> (32 - DIRECT_BITS)];
+            offsets[i] = DIRECT_BITS;
+            if (not(entries[i] & LEAF)) {
+                __builtin_prefetch(&_nodes[entries[i]]);
+                walking = true;
+            }
+        }
+
+        // every address still walking goes down one level per pass
+        while (walking) {
+            walking = false;
+            for (size_t i = 0; i < n; i++) {
+                if (entries[i] & LEAF) {
+                    continue;
+                }
+                _descend(entries[i], uint64_t(batch[i]) << 32, offsets[i]);
+                if (not(entries[i] & LEAF)) {
+                    __builtin_prefetch(&_nodes[entries[i]]);
+                    walking = true;
+                }
+            }
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            values[done + i] = _value(entries[i]);
+        }
+    }
+}
+
+#if defined(__x86_64__)
+__attribute__((target("popcnt")))
+#endif
+optional<uint32_t> Poptrie::_lookup_popcnt(const uint32_t address) const {
+    return _lookup(address);
+}
+
+optional<uint32_t> Poptrie::_lookup_generic(const uint32_t address) const { return _lookup(address); }
+
+#if defined(__x86_64__)
+__attribute__((target("popcnt")))
+#endif
+void Poptrie::_lookup_batch_popcnt(const uint32_t *addresses, optional<uint32_t> *values, const size_t count) const {
+    _lookup_batch(addresses, values, count);
+}
+
+void Poptrie::_lookup_batch_generic(const uint32_t *addresses, optional<uint32_t> *values, const size_t count) const {
+    _lookup_batch(addresses, values, count);
+}
+
+bool Poptrie::_cpu_has_popcnt() {
+#if defined(__x86_64__)
+    static const bool has_popcnt = __builtin_cpu_supports("popcnt");
+    return has_popcnt;
+#else
+    return false;
+#endif
+}
+
+//! \details The prefixes are sorted by address (shorter first when they start at the same address),
+//! which puts every group of prefixes that extend one slot of a node next to each other.
+void Poptrie::build() {
+    stable_sort(_routes.begin(), _routes.end(), [](const Route &a, const Route &b) {
+        return a.prefix != b.prefix ? a.prefix < b.prefix : a.length < b.length;
+    });
+    _routes.erase(unique(_routes.begin(),
+                         _routes.end(),
+                         [](const Route &a, const Route &b) { return a.prefix == b.prefix and a.length == b.length; }),
+                  _routes.end());
+
+    _nodes.clear();
+    _leaves.clear();
+
+    // the prefixes that the top-level array resolves, and those that need nodes below it
+    vector<uint32_t> values(_direct.size(), NO_VALUE);
+    vector<Route> short_routes, long_routes;
+    for (const auto &route : _routes) {
+        (route.length <= DIRECT_BITS ? short_routes : long_routes).push_back(route);
+    }
+    stable_sort(short_routes.begin(), short_routes.end(), [](const Route &a, const Route &b) {
+        return a.length < b.length;
+    });
+    for (const auto &route : short_routes) {
+        const uint32_t first = bits(route.prefix, 0, DIRECT_BITS);
+        fill_n(values.begin() + first, size_t(1) << (DIRECT_BITS - route.length), route.value);
+    }
+
+    for (size_t slot = 0; slot < _direct.size(); slot++) {
+        _direct[slot] = LEAF | values[slot];
+    }
+    for (size_t begin = 0; begin < long_routes.size();) {
+        const uint32_t slot = bits(long_routes[begin].prefix, 0, DIRECT_BITS);
+        size_t end = begin + 1;
+        while (end < long_routes.size() and bits(long_routes[end].prefix, 0, DIRECT_BITS) == slot) {
+            end++;
+        }
+        _direct[slot] = _nodes.size();
+        _nodes.emplace_back();
+        _build_node(long_routes, begin, end, _direct[slot], DIRECT_BITS, values[slot]);
+        begin = end;
+    }
+
+    _stale = false;
+}
+
+void Poptrie::_build_node(const vector<Route> &routes,
+                          const size_t begin,
+                          const size_t end,
+                          const size_t index,
+                          const unsigned offset,
+                          const uint32_t inherited) {
+    constexpr unsigned SLOTS = 1 << STRIDE;
+
+    // the value of each slot, from the prefixes that end within this node (longer ones paint later)
+    array<uint32_t, SLOTS> values;
+    values.fill(inherited);
+    vector<Route> ending;
+    for (size_t i = begin; i < end; i++) {
+        if (routes[i].length <= offset + STRIDE) {
+            ending.push_back(routes[i]);
+        }
+    }
+    stable_sort(ending.begin(), ending.end(), [](const Route &a, const Route &b) { return a.length < b.length; });
+    for (const auto &route : ending) {
+        const uint32_t first = bits(route.prefix, offset, STRIDE);
+        fill_n(values.begin() + first, size_t(1) << (offset + STRIDE - route.length), route.value);
+    }
+
+    // the slots that the longer prefixes extend, each with the range of them that it covers
+    uint64_t children = 0;
+    vector<pair<size_t, size_t>> child_routes;
+    for (size_t i = begin; i < end;) {
+        if (routes[i].length <= offset + STRIDE) {
+            i++;
+            continue;
+        }
+        const uint32_t slot = bits(routes[i].prefix, offset, STRIDE);
+        size_t j = i + 1;
+        while (j < end and bits(routes[j].prefix, offset, STRIDE) == slot) {
+            j++;
+        }
+        children |= uint64_t(1) << slot;
+        child_routes.emplace_back(i, j);
+        i = j;
+    }
+
+    // runs of leaf slots with the same value share one entry in `_leaves`
+    uint64_t leaves = 0;
+    const size_t leaf_base = _leaves.size();
+    for (unsigned slot = 0; slot < SLOTS; slot++) {
+        if (children >> slot & 1) {
+            continue;
+        }
+        if (_leaves.size() == leaf_base or _leaves.back() != values[slot]) {
+            leaves |= uint64_t(1) << slot;
+            _leaves.push_back(values[slot]);
+        }
+    }
+
+    // a node's children are allocated together, so that they can be found by counting
+    const size_t child_base = _nodes.size();
+    _nodes.resize(child_base + child_routes.size());
+    _nodes[index] = {children, leaves, uint32_t(leaf_base), uint32_t(child_base)};
+
+    size_t child = child_base;
+    for (unsigned slot = 0; slot < SLOTS; slot++) {
+        if (children >> slot & 1) {
+            const auto [child_begin, child_end] = child_routes[child - child_base];
+            _build_node(routes, child_begin, child_end, child, offset + STRIDE, values[slot]);
+            child++;
+        }
+    }
+}
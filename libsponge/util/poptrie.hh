@@ -0,0 +1,119 @@
+#ifndef SPONGE_LIBSPONGE_POPTRIE_HH
+#define SPONGE_LIBSPONGE_POPTRIE_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+//! \brief Longest-prefix match over IPv4 prefixes, with a compressed multibit trie (a "Poptrie")
+//! \details After Asai and Ohara, "Poptrie: A Compressed Trie with Population Count for Fast and
+//! Scalable Software IP Routing Table Lookup" (SIGCOMM 2015). The top DIRECT_BITS bits of an address
+//! index a flat array; the rest are consumed STRIDE bits at a time by 64-way nodes. Each node keeps
+//! two bitmaps instead of 64 pointers: which of its slots lead to child nodes, and where each run of
+//! slots with the same value starts. A slot's child (or value) is found by counting the bits set
+//! below it in the bitmap (a popcount) and adding that to the base of the node's children (or
+//! values), which are stored contiguously. A lookup therefore visits at most four nodes whatever the
+//! size of the table, and a table of a million prefixes fits in a few tens of megabytes.
+//!
+//! Prefixes are added with insert(), and take effect once build() has compiled them into the trie.
+class Poptrie {
+  public:
+    static constexpr unsigned DIRECT_BITS = 16;         //!< Address bits resolved by the top-level array
+    static constexpr unsigned STRIDE = 6;               //!< Address bits resolved by each node (64 slots)
+    static constexpr uint32_t MAX_VALUE = 0x7fff'fffe;  //!< Largest value a prefix can map to
+    static constexpr size_t BATCH = 32;                 //!< Addresses that a batched lookup walks together
+
+  private:
+    //! A 64-way node
+    struct Node {
+        uint64_t children;    //!< Bit `i` is set if slot `i` leads to a child node
+        uint64_t leaves;      //!< Bit `i` is set if slot `i` holds a value and starts a run of slots with that value
+        uint32_t leaf_base;   //!< Index in `_leaves` of the value of the node's first run
+        uint32_t child_base;  //!< Index in `_nodes` of the node's first child
+    };
+
+    //! A prefix, as added by insert()
+    struct Route {
+        uint32_t prefix;
+        uint8_t length;
+        uint32_t value;
+    };
+
+    static constexpr uint32_t NO_VALUE = 0x7fff'ffff;  //!< Value of addresses that no prefix matches
+    static constexpr uint32_t LEAF = 0x8000'0000;      //!< Set in a `_direct` entry that holds a value
+
+    std::vector<Route> _routes{};  //!< Every prefix added
+    bool _stale{false};            //!< Have prefixes been added since the last build()?
+
+    std::vector<uint32_t> _direct;  //!< By top DIRECT_BITS address bits: LEAF | value, or a node index
+    std::vector<Node> _nodes{};
+    std::vector<uint32_t> _leaves{};
+
+    bool _popcnt;  //!< Does the CPU have a POPCNT instruction?
+
+    //! Go down one level from `entry`, a node reached at bit `offset` of `key` (the address, left-aligned)
+    void _descend(uint32_t &entry, const uint64_t key, unsigned &offset) const;
+
+    //! The value of a leaf entry, if it has one
+    static std::optional<uint32_t> _value(const uint32_t entry);
+
+    //! \name The lookups, built for CPUs with and without a POPCNT instruction
+    //!@{
+    std::optional<uint32_t> _lookup(const uint32_t address) const;
+    std::optional<uint32_t> _lookup_popcnt(const uint32_t address) const;
+    std::optional<uint32_t> _lookup_generic(const uint32_t address) const;
+
+    void _lookup_batch(const uint32_t *addresses, std::optional<uint32_t> *values, const size_t count) const;
+    void _lookup_batch_popcnt(const uint32_t *addresses, std::optional<uint32_t> *values, const size_t count) const;
+    void _lookup_batch_generic(const uint32_t *addresses, std::optional<uint32_t> *values, const size_t count) const;
+    //!@}
+
+    //! Does the CPU have a POPCNT instruction?
+    static bool _cpu_has_popcnt();
+
+    //! Compile the prefixes `routes[begin, end)`, which all agree on their first `offset` bits and
+    //! are longer than that, into node `index`; `inherited` is the value of a slot none of them match
+    void _build_node(const std::vector<Route> &routes,
+                     const size_t begin,
+                     const size_t end,
+                     const size_t index,
+                     const unsigned offset,
+                     const uint32_t inherited);
+
+  public:
+    //! Construct an empty table
+    Poptrie() : _direct(size_t(1) << DIRECT_BITS, LEAF | NO_VALUE), _popcnt(_cpu_has_popcnt()) {}
+
+    //! \brief Add a prefix: the `length` high-order bits of `prefix`, which map to `value`
+    //! \note If the same prefix is added twice, the first value is the one that is found
+    void insert(const uint32_t prefix, const uint8_t length, const uint32_t value);
+
+    //! \brief Compile the prefixes into the trie
+    void build();
+
+    //! Have prefixes been added that lookup() won't see until build() is called?
+    bool stale() const { return _stale; }
+
+    //! \brief The value of the longest prefix that matches `address`, if any does (as of the last build())
+    std::optional<uint32_t> lookup(const uint32_t address) const {
+        return _popcnt ? _lookup_popcnt(address) : _lookup_generic(address);
+    }
+
+    //! \brief Look up `count` addresses at once, into `values`
+    //! \details Walks BATCH addresses down the trie together, a level at a time, prefetching the node
+    //! each will visit next, so that their cache misses overlap instead of following one another
+    void lookup(const uint32_t *addresses, std::optional<uint32_t> *values, const size_t count) const {
+        _popcnt ? _lookup_batch_popcnt(addresses, values, count) : _lookup_batch_generic(addresses, values, count);
+    }
+
+    //! Number of prefixes (a prefix added more than once is only counted once after build())
+    size_t size() const { return _routes.size(); }
+
+    //! Bytes used by the compiled trie
+    size_t memory_usage() const {
+        return _direct.size() * sizeof(uint32_t) + _nodes.size() * sizeof(Node) + _leaves.size() * sizeof(uint32_t);
+    }
+};
+
+#endif  // SPONGE_LIBSPONGE_POPTRIE_HH
@@ -0,0 +1,144 @@
+#ifndef SPONGE_LIBSPONGE_RCU_SNAPSHOT_HH
+#define SPONGE_LIBSPONGE_RCU_SNAPSHOT_HH
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+//! \brief An immutable value that one writer replaces while any number of readers use it, without locks
+//! \details Read-copy-update: readers get the current snapshot through read(), and the writer builds
+//! a new one off to the side and swaps it in with publish(). A snapshot that has been replaced is
+//! only freed once no reader can still be using it, which is tracked with epochs: a reader announces
+//! the epoch it started in by claiming one of READERS slots (a compare-and-swap, so readers need no
+//! registration), and publish() retires the old snapshot under the epoch current when it was
+//! replaced. Snapshots retired before the oldest epoch a reader has announced are unreachable.
+//!
+//! The newest snapshot that no reader can see any more is kept as a spare rather than freed, so that
+//! the writer can recycle() it into the next snapshot instead of allocating (and copying) a whole one.
+//!
+//! Readers never block or wait on the writer. There must be only one writer at a time.
+template <typename T>
+class RcuSnapshot {
+  public:
+    static constexpr size_t READERS = 64;  //!< Readers that can be inside read() at once
+
+  private:
+    static constexpr size_t CACHE_LINE = 64;
+
+    //! A reader's announced epoch, or 0 if the slot is free
+    struct alignas(CACHE_LINE) Slot {
+        std::atomic<uint64_t> epoch{0};
+    };
+
+    mutable std::array<Slot, READERS> _slots{};
+    std::atomic<uint64_t> _epoch{1};  //!< Bumped by each publish()
+    std::atomic<T *> _current;
+
+    //! Replaced snapshots not yet freed, with the epoch each was retired in (writer only)
+    std::vector<std::pair<uint64_t, std::unique_ptr<T>>> _retired{};
+
+    //! The newest replaced snapshot that no reader can see, for recycle() (writer only)
+    std::unique_ptr<T> _spare{};
+
+    //! Claim a free slot, announcing the current epoch in it; returns the slot's index
+    size_t _enter() const {
+        const uint64_t epoch = _epoch.load(std::memory_order_acquire);
+        for (size_t i = 0;; i = (i + 1) % READERS) {
+            uint64_t expected = 0;
+            // sequentially consistent: the writer either sees the claim, or published before it
+            if (_slots[i].epoch.compare_exchange_strong(expected, epoch, std::memory_order_seq_cst)) {
+                return i;
+            }
+        }
+    }
+
+  public:
+    //! \brief A reader's hold on a snapshot, which stays valid until the guard is destroyed
+    class ReadGuard {
+        const RcuSnapshot &_rcu;
+        size_t _slot;
+        const T *_snapshot;
+
+      public:
+        explicit ReadGuard(const RcuSnapshot &rcu)
+            : _rcu(rcu), _slot(rcu._enter()), _snapshot(rcu._current.load(std::memory_order_seq_cst)) {}
+        ~ReadGuard() { _rcu._slots[_slot].epoch.store(0, std::memory_order_release); }
+
+        ReadGuard(const ReadGuard &other) = delete;
+        ReadGuard &operator=(const ReadGuard &other) = delete;
+
+        const T &operator*() const { return *_snapshot; }
+        const T *operator->() const { return _snapshot; }
+    };
+
+    //! Construct, publishing `initial`
+    explicit RcuSnapshot(std::unique_ptr<T> initial) : _current(initial.release()) {
+        if (not _current.load()) {
+            throw std::runtime_error("RcuSnapshot: no initial snapshot");
+        }
+    }
+
+    //! \note There must be no readers left
+    ~RcuSnapshot() { delete _current.load(); }
+
+    RcuSnapshot(const RcuSnapshot &other) = delete;
+    RcuSnapshot &operator=(const RcuSnapshot &other) = delete;
+
+    //! \brief Hold the current snapshot (lock-free; any thread)
+    ReadGuard read() const { return ReadGuard(*this); }
+
+    //! \brief The current snapshot, for the writer to copy (writer only)
+    const T &writer_view() const { return *_current.load(std::memory_order_relaxed); }
+
+    //! \brief Swap in a new snapshot, and free those that no reader can still see (writer only)
+    void publish(std::unique_ptr<T> next) {
+        if (not next) {
+            throw std::runtime_error("RcuSnapshot: no snapshot to publish");
+        }
+        T *previous = _current.exchange(next.release(), std::memory_order_seq_cst);
+        _retired.emplace_back(_epoch.fetch_add(1, std::memory_order_seq_cst), previous);
+        reclaim();
+    }
+
+    //! \brief Free the retired snapshots that no reader can still see, keeping the newest as the spare
+    //! (writer only)
+    //! \returns the number still waiting for readers to move on
+    size_t reclaim() {
+        uint64_t oldest = UINT64_MAX;
+        for (const auto &slot : _slots) {
+            const uint64_t epoch = slot.epoch.load(std::memory_order_seq_cst);
+            if (epoch != 0 and epoch < oldest) {
+                oldest = epoch;
+            }
+        }
+        // a reader that announced epoch E may hold anything retired in E or later (and the snapshots
+        // are retired in order of epoch)
+        const auto unreachable_end = std::find_if(
+            _retired.begin(), _retired.end(), [&](const auto &retired) { return retired.first >= oldest; });
+        if (unreachable_end != _retired.begin()) {
+            _spare = std::move(std::prev(unreachable_end)->second);
+        }
+        _retired.erase(_retired.begin(), unreachable_end);
+        return _retired.size();
+    }
+
+    //! \brief Take the newest replaced snapshot that no reader can still see, to make the next one out
+    //! of (writer only)
+    //! \returns nullptr if there is none
+    std::unique_ptr<T> recycle() {
+        reclaim();
+        return std::move(_spare);
+    }
+
+    //! Number of retired snapshots not yet freed
+    size_t retired() const { return _retired.size(); }
+};
+
+#endif  // SPONGE_LIBSPONGE_RCU_SNAPSHOT_HH
@@ -0,0 +1,98 @@
+#include "resilient_hash_table.hh"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+using namespace std;
+
+//! \details Each member gets the whole part of its proportional share, and the buckets left over
+//! go one each to the members with the largest fractional parts (the first of them on ties).
+vector<size_t> ResilientHashTable::_shares(const vector<unsigned> &weights) {
+    if (weights.empty() or weights.size() > MAX_MEMBERS) {
+        throw runtime_error("ResilientHashTable: needs between 1 and " + to_string(MAX_MEMBERS) + " members");
+    }
+    if (any_of(weights.begin(), weights.end(), [](const unsigned weight) { return weight == 0; })) {
+        throw runtime_error("ResilientHashTable: weights must be positive");
+    }
+
+    const uint64_t total = accumulate(weights.begin(), weights.end(), uint64_t(0));
+    vector<size_t> shares(weights.size());
+    vector<uint64_t> remainders(weights.size());
+    size_t assigned = 0;
+    for (size_t i = 0; i < weights.size(); i++) {
+        shares[i] = BUCKETS * weights[i] / total;
+        remainders[i] = BUCKETS * weights[i] % total;
+        assigned += shares[i];
+    }
+
+    vector<size_t> order(weights.size());
+    iota(order.begin(), order.end(), 0);
+    stable_sort(
+        order.begin(), order.end(), [&](const size_t a, const size_t b) { return remainders[a] > remainders[b]; });
+    for (size_t i = 0; assigned < BUCKETS; i++, assigned++) {
+        shares[order[i]]++;
+    }
+    return shares;
+}
+
+ResilientHashTable::ResilientHashTable(const vector<unsigned> &weights) : _members(weights.size()) {
+    const vector<size_t> shares = _shares(weights);
+
+    // interleave the members, so that each one's buckets are spread across the table
+    vector<size_t> given(_members, 0);
+    for (size_t bucket = 0, member = 0; bucket < BUCKETS; member = (member + 1) % _members) {
+        if (given[member] < shares[member]) {
+            _buckets[bucket++] = member;
+            given[member]++;
+        }
+    }
+}
+
+ResilientHashTable::ResilientHashTable(const ResilientHashTable &old,
+                                       const vector<unsigned> &weights,
+                                       const vector<size_t> &previous)
+    : _members(weights.size()) {
+    if (previous.size() != weights.size()) {
+        throw runtime_error("ResilientHashTable: need a predecessor (or NEW) for every member");
+    }
+    const vector<size_t> shares = _shares(weights);
+
+    // each old member's successor, if it has one
+    vector<size_t> successor(old._members, NEW);
+    for (size_t member = 0; member < previous.size(); member++) {
+        if (previous[member] != NEW) {
+            successor.at(previous[member]) = member;
+        }
+    }
+
+    // keep a bucket's member while it survives and is within its share...
+    vector<size_t> given(_members, 0);
+    array<bool, BUCKETS> kept{};
+    for (size_t bucket = 0; bucket < BUCKETS; bucket++) {
+        const size_t member = successor[old._buckets[bucket]];
+        if (member != NEW and given[member] < shares[member]) {
+            _buckets[bucket] = member;
+            given[member]++;
+            kept[bucket] = true;
+        }
+    }
+
+    // ...and hand the rest to members short of theirs
+    size_t member = 0;
+    for (size_t bucket = 0; bucket < BUCKETS; bucket++) {
+        if (kept[bucket]) {
+            continue;
+        }
+        while (given[member] == shares[member]) {
+            member = (member + 1) % _members;
+        }
+        _buckets[bucket] = member;
+        given[member]++;
+        member = (member + 1) % _members;
+    }
+}
+
+size_t ResilientHashTable::buckets_of(const size_t member) const {
+    return count(_buckets.begin(), _buckets.end(), member);
+}
@@ -0,0 +1,49 @@
+#ifndef SPONGE_LIBSPONGE_RESILIENT_HASH_TABLE_HH
+#define SPONGE_LIBSPONGE_RESILIENT_HASH_TABLE_HH
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//! \brief Spreads flows over weighted members (e.g. the next hops of a multipath route) by hash
+//! \details A fixed array of BUCKETS buckets, each naming a member; a member gets a share of the
+//! buckets in proportion to its weight, and a flow goes to the member of the bucket its hash picks.
+//! When the members or weights change, the new table is made from the old one: a bucket keeps its
+//! member as long as that member survives and is not over its new share, so only the flows in the
+//! buckets that have to move change member (unlike hashing modulo the number of members, where
+//! nearly every flow would).
+class ResilientHashTable {
+  public:
+    static constexpr size_t BUCKETS = 256;      //!< Buckets in a table
+    static constexpr size_t MAX_MEMBERS = 256;  //!< Members a table can spread over
+    static constexpr size_t NEW = SIZE_MAX;     //!< A member with no counterpart in the old table
+
+  private:
+    std::array<uint8_t, BUCKETS> _buckets{};  //!< Member of each bucket
+    size_t _members;
+
+    //! The number of buckets each member gets, in proportion to `weights`
+    static std::vector<size_t> _shares(const std::vector<unsigned> &weights);
+
+  public:
+    //! \brief A table over members with `weights` (one per member; each positive)
+    explicit ResilientHashTable(const std::vector<unsigned> &weights);
+
+    //! \brief A table over new members with `weights`, moving as few buckets as it can from `old`
+    //! \param[in] previous gives, for each new member, its index in `old` (or NEW)
+    ResilientHashTable(const ResilientHashTable &old,
+                       const std::vector<unsigned> &weights,
+                       const std::vector<size_t> &previous);
+
+    //! The member that a flow with `hash` goes to
+    size_t select(const uint64_t hash) const { return _buckets[hash % BUCKETS]; }
+
+    //! Number of members
+    size_t members() const { return _members; }
+
+    //! Number of buckets whose member is `member`
+    size_t buckets_of(const size_t member) const;
+};
+
+#endif  // SPONGE_LIBSPONGE_RESILIENT_HASH_TABLE_HH
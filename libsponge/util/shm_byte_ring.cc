@@ -0,0 +1,162 @@
+#include "shm_byte_ring.hh"
+
+#include "util.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace std;
+
+static constexpr size_t MIN_CAPACITY = 4096;
+
+static size_t round_up_to_power_of_two(const size_t n) {
+    size_t rounded = MIN_CAPACITY;
+    while (rounded < n) {
+        rounded <<= 1;
+    }
+    return rounded;
+}
+
+static int make_doorbell() { return SystemCall("eventfd", ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)); }
+
+//! \param[in] capacity is the minimum number of bytes the ring must hold
+ShmByteRing::ShmByteRing(const size_t capacity)
+    : _capacity(round_up_to_power_of_two(capacity))
+    , _mapping_size(MIN_CAPACITY + _capacity)
+    , _mapping(::mmap(nullptr, _mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0))
+    , _control(nullptr)
+    , _data(nullptr)
+    , _data_doorbell(make_doorbell())
+    , _space_doorbell(make_doorbell()) {
+    static_assert(sizeof(Control) <= MIN_CAPACITY, "control block must fit in the first page");
+    if (_mapping == MAP_FAILED) {
+        throw unix_error("mmap");
+    }
+    _control = new (_mapping) Control{{0}, {0}, {false}, {false}, {false}, {false}};
+    _data = static_cast<char *>(_mapping) + MIN_CAPACITY;
+}
+
+ShmByteRing::~ShmByteRing() {
+    _control->~Control();
+    if (::munmap(_mapping, _mapping_size) != 0) {
+        cerr << "Warning: munmap of ShmByteRing failed\n";
+    }
+}
+
+void ShmByteRing::_ring(const FileDescriptor &doorbell) {
+    const uint64_t one = 1;
+    SystemCall("write", ::write(doorbell.fd_num(), &one, sizeof(one)));
+}
+
+void ShmByteRing::_sleep_on(FileDescriptor &doorbell) {
+    pollfd pfd{doorbell.fd_num(), POLLIN, 0};
+    try {
+        SystemCall("poll", ::poll(&pfd, 1, -1));
+    } catch (const unix_error &e) {
+        if (e.code().value() != EINTR) {
+            throw;
+        }
+        return;
+    }
+    doorbell.read(sizeof(uint64_t));
+}
+
+size_t ShmByteRing::space() const {
+    return _capacity - (_control->tail.load(memory_order_relaxed) - _control->head.load(memory_order_acquire));
+}
+
+size_t ShmByteRing::size() const {
+    return _control->tail.load(memory_order_acquire) - _control->head.load(memory_order_relaxed);
+}
+
+bool ShmByteRing::eof() const { return _control->closed.load(memory_order_acquire) and size() == 0; }
+
+size_t ShmByteRing::write(const string_view data) {
+    const uint64_t tail = _control->tail.load(memory_order_relaxed);
+    const size_t amount = min(space(), data.size());
+    if (amount == 0) {
+        return 0;
+    }
+
+    const size_t offset = tail & (_capacity - 1);
+    const size_t first = min(amount, _capacity - offset);
+    memcpy(_data + offset, data.data(), first);
+    memcpy(_data, data.data() + first, amount - first);
+    _control->tail.store(tail + amount, memory_order_release);
+
+    // pairs with the fence in prepare_to_wait_for_data(): either the reader sees the new bytes, or we see it waiting
+    atomic_thread_fence(memory_order_seq_cst);
+    if (_control->reader_waiting.load(memory_order_relaxed) and _control->reader_waiting.exchange(false)) {
+        _ring(_data_doorbell);
+    }
+    return amount;
+}
+
+void ShmByteRing::close() {
+    _control->closed.store(true, memory_order_release);
+    _ring(_data_doorbell);
+}
+
+//! \param[out] str receives the bytes that were read (empty if the ring is empty)
+//! \param[in] limit is the maximum number of bytes to read
+void ShmByteRing::read(string &str, const size_t limit) {
+    const uint64_t head = _control->head.load(memory_order_relaxed);
+    const size_t amount = min(size(), limit);
+    str.resize(amount);
+    if (amount == 0) {
+        return;
+    }
+
+    const size_t offset = head & (_capacity - 1);
+    const size_t first = min(amount, _capacity - offset);
+    memcpy(str.data(), _data + offset, first);
+    memcpy(str.data() + first, _data, amount - first);
+    _control->head.store(head + amount, memory_order_release);
+
+    atomic_thread_fence(memory_order_seq_cst);
+    if (_control->writer_waiting.load(memory_order_relaxed) and _control->writer_waiting.exchange(false)) {
+        _ring(_space_doorbell);
+    }
+}
+
+void ShmByteRing::close_reader() {
+    _control->reader_gone.store(true, memory_order_release);
+    _ring(_space_doorbell);
+}
+
+void ShmByteRing::prepare_to_wait_for_space() {
+    _control->writer_waiting.store(true);
+    atomic_thread_fence(memory_order_seq_cst);
+    if (space() > 0 or reader_gone()) {
+        _ring(_space_doorbell);
+    }
+}
+
+void ShmByteRing::prepare_to_wait_for_data() {
+    _control->reader_waiting.store(true);
+    atomic_thread_fence(memory_order_seq_cst);
+    if (size() > 0 or _control->closed.load()) {
+        _ring(_data_doorbell);
+    }
+}
+
+void ShmByteRing::wait_for_space() {
+    while (space() == 0 and not reader_gone()) {
+        prepare_to_wait_for_space();
+        _sleep_on(_space_doorbell);
+    }
+}
+
+void ShmByteRing::wait_for_data() {
+    while (size() == 0 and not _control->closed.load()) {
+        prepare_to_wait_for_data();
+        _sleep_on(_data_doorbell);
+    }
+}
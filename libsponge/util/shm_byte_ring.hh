@@ -0,0 +1,118 @@
+#ifndef SPONGE_LIBSPONGE_SHM_BYTE_RING_HH
+#define SPONGE_LIBSPONGE_SHM_BYTE_RING_HH
+
+#include "file_descriptor.hh"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+//! \brief A byte stream between one writer thread and one reader thread, through shared memory
+//! \details The bytes live in a power-of-two ring in an mmap(2)ed region, so passing them from
+//! writer to reader is a pair of memcpy()s rather than a trip through the kernel. Each side has
+//! an eventfd(2) "doorbell" on which it can sleep: the data doorbell wakes the reader and the
+//! space doorbell wakes the writer. A side only rings the other's doorbell if the other has
+//! announced (with one of the `prepare_to_wait_*` methods) that it is about to sleep.
+//!
+//! A side that waits in an EventLoop polls its doorbell for Direction::In, calls the matching
+//! `prepare_to_wait_*` method from the rule's interest callback, and calls the matching
+//! `clear_*_doorbell` method from the rule's callback. A side that has nothing else to do uses
+//! the blocking `wait_for_*` methods.
+class ShmByteRing {
+  private:
+    static constexpr size_t CACHE_LINE = 64;
+
+    //! State shared by reader and writer, at the start of the mapping
+    struct Control {
+        alignas(CACHE_LINE) std::atomic<uint64_t> head;  //!< Bytes read so far (written by the reader)
+        alignas(CACHE_LINE) std::atomic<uint64_t> tail;  //!< Bytes written so far (written by the writer)
+        alignas(CACHE_LINE) std::atomic<bool> closed;    //!< Writer has ended the stream
+        std::atomic<bool> reader_gone;                    //!< Reader will never read again
+        std::atomic<bool> reader_waiting;                 //!< Reader may be asleep on the data doorbell
+        std::atomic<bool> writer_waiting;                 //!< Writer may be asleep on the space doorbell
+    };
+
+    size_t _capacity;      //!< Size of the data area (a power of two)
+    size_t _mapping_size;  //!< Size of the whole mapping
+    void *_mapping;        //!< Control block followed by the data area
+    Control *_control;
+    char *_data;
+
+    FileDescriptor _data_doorbell;   //!< Readable when the reader should look at the ring
+    FileDescriptor _space_doorbell;  //!< Readable when the writer should look at the ring
+
+    static void _ring(const FileDescriptor &doorbell);
+    static void _sleep_on(FileDescriptor &doorbell);
+
+  public:
+    //! Construct a ring holding at least `capacity` bytes
+    explicit ShmByteRing(const size_t capacity);
+
+    //! Unmaps the shared memory
+    ~ShmByteRing();
+
+    //! \name Writer
+    //!@{
+
+    //! \brief Copy as much of `data` as fits into the ring, without blocking
+    //! \returns the number of bytes copied
+    size_t write(std::string_view data);
+
+    //! \brief End the stream; the reader sees EOF once it has read everything before this point
+    void close();
+
+    //! \brief Number of bytes that can be written right now
+    size_t space() const;
+
+    //! \brief Has the reader gone away?
+    bool reader_gone() const { return _control->reader_gone.load(); }
+
+    //! \brief Block until there is space in the ring (or the reader has gone away)
+    void wait_for_space();
+
+    //! \brief Ask to be woken when there is space (rings right away if there already is)
+    void prepare_to_wait_for_space();
+
+    const FileDescriptor &space_doorbell() const { return _space_doorbell; }  //!< Polled by the writer
+    void clear_space_doorbell() { _space_doorbell.read(sizeof(uint64_t)); }  //!< After the doorbell fired
+    //!@}
+
+    //! \name Reader
+    //!@{
+
+    //! \brief Take up to `limit` bytes out of the ring, without blocking
+    void read(std::string &str, const size_t limit);
+
+    //! \brief Tell the writer that nothing will be read from now on
+    void close_reader();
+
+    //! \brief Number of bytes that can be read right now
+    size_t size() const;
+
+    //! \brief Has the writer ended the stream, and has everything been read?
+    bool eof() const;
+
+    //! \brief Block until there is data in the ring (or it has reached EOF)
+    void wait_for_data();
+
+    //! \brief Ask to be woken when there is data (rings right away if there already is)
+    void prepare_to_wait_for_data();
+
+    const FileDescriptor &data_doorbell() const { return _data_doorbell; }  //!< Polled by the reader
+    void clear_data_doorbell() { _data_doorbell.read(sizeof(uint64_t)); }  //!< After the doorbell fired
+    //!@}
+
+    //! \name
+    //! The ring owns its mapping, so it cannot be copied or moved
+
+    //!@{
+    ShmByteRing(const ShmByteRing &other) = delete;
+    ShmByteRing &operator=(const ShmByteRing &other) = delete;
+    ShmByteRing(ShmByteRing &&other) = delete;
+    ShmByteRing &operator=(ShmByteRing &&other) = delete;
+    //!@}
+};
+
+#endif  // SPONGE_LIBSPONGE_SHM_BYTE_RING_HH
@@ -0,0 +1,155 @@
+#ifndef SPONGE_LIBSPONGE_SMALL_VECTOR_HH
+#define SPONGE_LIBSPONGE_SMALL_VECTOR_HH
+
+#include "packet_pool.hh"
+
+#include <cstddef>
+#include <initializer_list>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+//! \brief A vector that keeps up to `N` elements inside itself, and only allocates (from the
+//! PacketPool) once it grows past them
+//! \details Meant for short sequences built and discarded at packet rate, like the headers and
+//! payload of one packet. Besides the usual operations it can pop_front(), by shifting the rest
+//! down, which is cheap for the few elements it is meant for.
+template <typename T, size_t N>
+class SmallVector {
+  private:
+    alignas(T) unsigned char _inline[N * sizeof(T)];  //!< Room for the first `N` elements
+    T *_data;                                         //!< `_inline`, or a pooled block once grown
+    size_t _size{0};
+    size_t _capacity{N};
+
+    bool _is_inline() const { return _data == reinterpret_cast<const T *>(_inline); }
+
+    //! Move the elements to a pooled block with room for `capacity` elements
+    void _grow(const size_t capacity) {
+        T *grown = PoolAllocator<T>().allocate(capacity);
+        for (size_t i = 0; i < _size; i++) {
+            new (grown + i) T(std::move(_data[i]));
+            _data[i].~T();
+        }
+        _free_block();
+        _data = grown;
+        _capacity = capacity;
+    }
+
+    //! Return a pooled block (if there is one) to the pool; the elements must already be destroyed
+    void _free_block() {
+        if (not _is_inline()) {
+            PoolAllocator<T>().deallocate(_data, _capacity);
+        }
+    }
+
+  public:
+    //! Construct an empty SmallVector
+    SmallVector() : _inline(), _data(reinterpret_cast<T *>(_inline)) {}
+
+    //! Construct from a list of elements
+    SmallVector(std::initializer_list<T> elements) : SmallVector() {
+        for (const auto &element : elements) {
+            push_back(element);
+        }
+    }
+
+    //! \name Copying copies the elements; moving moves them (the inline ones one by one)
+    //!@{
+    SmallVector(const SmallVector &other) : SmallVector() {
+        for (const auto &element : other) {
+            push_back(element);
+        }
+    }
+
+    SmallVector(SmallVector &&other) noexcept : SmallVector() { *this = std::move(other); }
+
+    SmallVector &operator=(const SmallVector &other) {
+        if (this != &other) {
+            clear();
+            for (const auto &element : other) {
+                push_back(element);
+            }
+        }
+        return *this;
+    }
+
+    SmallVector &operator=(SmallVector &&other) noexcept {
+        if (this == &other) {
+            return *this;
+        }
+        clear();
+        if (other._is_inline()) {
+            for (auto &element : other) {
+                new (_data + _size++) T(std::move(element));
+            }
+            other.clear();
+        } else {
+            _free_block();
+            _data = std::exchange(other._data, reinterpret_cast<T *>(other._inline));
+            _size = std::exchange(other._size, 0);
+            _capacity = std::exchange(other._capacity, N);
+        }
+        return *this;
+    }
+
+    ~SmallVector() {
+        clear();
+        _free_block();
+    }
+    //!@}
+
+    //! \name Element access
+    //!@{
+    T &operator[](const size_t i) { return _data[i]; }
+    const T &operator[](const size_t i) const { return _data[i]; }
+    T &front() { return _data[0]; }
+    const T &front() const { return _data[0]; }
+    T &back() { return _data[_size - 1]; }
+    const T &back() const { return _data[_size - 1]; }
+
+    T *begin() { return _data; }
+    T *end() { return _data + _size; }
+    const T *begin() const { return _data; }
+    const T *end() const { return _data + _size; }
+    //!@}
+
+    size_t size() const { return _size; }   //!< Number of elements
+    bool empty() const { return _size == 0; }  //!< Are there no elements?
+
+    //! Is the SmallVector still using only its inline storage?
+    bool is_inline() const { return _is_inline(); }
+
+    //! Append an element, constructed in place from `args`
+    template <typename... Targs>
+    T &emplace_back(Targs &&... args) {
+        if (_size == _capacity) {
+            _grow(2 * _capacity);
+        }
+        return *new (_data + _size++) T(std::forward<Targs>(args)...);
+    }
+
+    void push_back(const T &element) { emplace_back(element); }        //!< Append a copy of an element
+    void push_back(T &&element) { emplace_back(std::move(element)); }  //!< Append an element
+
+    //! Remove the first element
+    void pop_front() {
+        if (empty()) {
+            throw std::out_of_range("SmallVector::pop_front");
+        }
+        for (size_t i = 1; i < _size; i++) {
+            _data[i - 1] = std::move(_data[i]);
+        }
+        _data[--_size].~T();
+    }
+
+    //! Remove every element (keeping any pooled block for reuse)
+    void clear() {
+        for (size_t i = 0; i < _size; i++) {
+            _data[i].~T();
+        }
+        _size = 0;
+    }
+};
+
+#endif  // SPONGE_LIBSPONGE_SMALL_VECTOR_HH
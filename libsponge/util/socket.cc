@@ -2,9 +2,14 @@
 
 #include "util.hh"
 
+#include <array>
 #include <cstddef>
+#include <cstring>
+#include <netinet/udp.h>
 #include <stdexcept>
+#include <string_view>
 #include <unistd.h>
+#include <vector>
 
 using namespace std;
 
@@ -121,19 +126,107 @@ UDPSocket::received_datagram UDPSocket::recv(const size_t mtu) {
     return ret;
 }
 
+//! \param[in] capacity is the largest number of datagrams received by one call to recv_batch()
+//! \param[in] mtu is the size of each datagram's buffer
+UDPSocket::DatagramBatch::DatagramBatch(const size_t capacity, const size_t mtu)
+    : _mtu(mtu)
+    , _storage(capacity * mtu, 0)
+    , _sources(capacity)
+    , _controls(capacity)
+    , _iovecs(capacity)
+    , _headers(capacity)
+    , _segment_sizes(capacity) {
+    if (capacity == 0) {
+        throw runtime_error("DatagramBatch: capacity must be positive");
+    }
+}
+
+string_view UDPSocket::DatagramBatch::payload(const size_t i) const {
+    if (i >= _count) {
+        throw out_of_range("DatagramBatch::payload");
+    }
+    return {_storage.data() + i * _mtu, _headers[i].msg_len};
+}
+
+Address UDPSocket::DatagramBatch::source_address(const size_t i) const {
+    if (i >= _count) {
+        throw out_of_range("DatagramBatch::source_address");
+    }
+    return {_sources[i], _headers[i].msg_hdr.msg_namelen};
+}
+
+size_t UDPSocket::DatagramBatch::segment_size(const size_t i) const {
+    if (i >= _count) {
+        throw out_of_range("DatagramBatch::segment_size");
+    }
+    return _segment_sizes[i];
+}
+
+//! \details Blocks until at least one datagram arrives (unless the socket is non-blocking), then
+//! takes whatever else is already waiting without blocking again.
+//! \note If a datagram is too big for the batch's `mtu`, this method throws a std::runtime_error
+//! \returns the number of datagrams received (also available as `batch.size()`)
+size_t UDPSocket::recv_batch(DatagramBatch &batch) {
+    // point the headers at the batch's storage (it may have moved since the last call)
+    for (size_t i = 0; i < batch.capacity(); i++) {
+        batch._iovecs[i] = {batch._storage.data() + i * batch._mtu, batch._mtu};
+        batch._headers[i] = {};
+        batch._headers[i].msg_hdr.msg_name = static_cast<sockaddr *>(batch._sources[i]);
+        batch._headers[i].msg_hdr.msg_namelen = sizeof(batch._sources[i].storage);
+        batch._headers[i].msg_hdr.msg_iov = &batch._iovecs[i];
+        batch._headers[i].msg_hdr.msg_iovlen = 1;
+        batch._headers[i].msg_hdr.msg_control = batch._controls[i].buffer;
+        batch._headers[i].msg_hdr.msg_controllen = sizeof(batch._controls[i].buffer);
+    }
+
+    batch._count = 0;
+    const int count = SystemCall(
+        "recvmmsg", ::recvmmsg(fd_num(), batch._headers.data(), batch.capacity(), MSG_WAITFORONE, nullptr));
+
+    for (int i = 0; i < count; i++) {
+        msghdr &header = batch._headers[i].msg_hdr;
+        if (header.msg_flags & MSG_TRUNC) {
+            throw runtime_error("recvmmsg (oversized datagram)");
+        }
+
+        // with UDP_GRO, a control message says how big the coalesced datagrams were
+        batch._segment_sizes[i] = batch._headers[i].msg_len;
+        for (cmsghdr *cmsg = CMSG_FIRSTHDR(&header); cmsg != nullptr; cmsg = CMSG_NXTHDR(&header, cmsg)) {
+            if (cmsg->cmsg_level == SOL_UDP and cmsg->cmsg_type == UDP_GRO) {
+                int segment_size;
+                memcpy(&segment_size, CMSG_DATA(cmsg), sizeof(segment_size));
+                batch._segment_sizes[i] = segment_size;
+            }
+        }
+    }
+
+    register_read();
+    batch._count = count;
+    return batch._count;
+}
+
 // 发送UDP数据报: socket描述符,存放目的地址的缓冲区,缓冲区大小,要发送的数据载荷
 void sendmsg_helper(const int fd_num,
                     const sockaddr *destination_address,
                     const socklen_t destination_address_len,
                     const BufferViewList &payload) {
-    auto iovecs = payload.as_iovecs();
+    // 数据包的分片(首部+载荷)通常很少, 放在栈上的数组里即可; 分片太多时才用vector
+    array<iovec, 16> stack_iovecs;
+    vector<iovec> heap_iovecs;
+    iovec *iovecs = stack_iovecs.data();
+    size_t iovec_count = payload.as_iovecs(stack_iovecs.data(), stack_iovecs.size());
+    if (iovec_count == stack_iovecs.size()) {
+        heap_iovecs = payload.as_iovecs();
+        iovecs = heap_iovecs.data();
+        iovec_count = heap_iovecs.size();
+    }
 
     // 构造数据包
     msghdr message{};
     message.msg_name = const_cast<sockaddr *>(destination_address);
     message.msg_namelen = destination_address_len;
-    message.msg_iov = iovecs.data();
-    message.msg_iovlen = iovecs.size();
+    message.msg_iov = iovecs;
+    message.msg_iovlen = iovec_count;
 
     const ssize_t bytes_sent = SystemCall("sendmsg", ::sendmsg(fd_num, &message, 0));
 
@@ -155,6 +248,98 @@ void UDPSocket::send(const BufferViewList &payload) {
     register_write();
 }
 
+//! Largest UDP payload that fits in an IPv4 datagram (the limit for a whole UDP_SEGMENT send)
+static constexpr size_t MAX_UDP_PAYLOAD = 65507;
+
+//! Most datagrams the kernel will split one UDP_SEGMENT send into (UDP_MAX_SEGMENTS)
+static constexpr size_t MAX_GSO_SEGMENTS = 64;
+
+//! \param[in] destination is the Address to which every datagram is sent
+//! \param[in] payloads are the datagrams' payloads
+//! \param[in] segment_offload is `true` to send runs of same-size datagrams with UDP_SEGMENT
+void UDPSocket::send_batch(const Address &destination,
+                           const vector<BufferViewList> &payloads,
+                           const bool segment_offload) {
+    // a "message" is one datagram, or with segment offload a run of datagrams the kernel splits up
+    struct Message {
+        vector<iovec> iovecs{};
+        size_t size{0};
+        size_t segment_size{0};
+        size_t segments{0};
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(uint16_t))]{};
+    };
+
+    vector<Message> messages;
+    messages.reserve(payloads.size());
+    for (const auto &payload : payloads) {
+        const size_t size = payload.size();
+        // a run continues while the datagrams are the same size, and ends after a shorter one
+        const bool extends_run = segment_offload and not messages.empty() and size > 0 and
+                                 size <= messages.back().segment_size and
+                                 messages.back().size % messages.back().segment_size == 0 and
+                                 messages.back().segments < MAX_GSO_SEGMENTS and
+                                 messages.back().size + size <= MAX_UDP_PAYLOAD;
+        if (not extends_run) {
+            messages.emplace_back();
+            messages.back().segment_size = size;
+        }
+
+        Message &message = messages.back();
+        for (const auto &iov : payload.as_iovecs()) {
+            message.iovecs.push_back(iov);
+        }
+        message.size += size;
+        message.segments++;
+    }
+
+    vector<mmsghdr> headers(messages.size());
+    for (size_t i = 0; i < messages.size(); i++) {
+        Message &message = messages[i];
+        msghdr &header = headers[i].msg_hdr;
+        header.msg_name = const_cast<sockaddr *>(static_cast<const sockaddr *>(destination));
+        header.msg_namelen = destination.size();
+        header.msg_iov = message.iovecs.data();
+        header.msg_iovlen = message.iovecs.size();
+
+        if (message.segments > 1) {
+            header.msg_control = message.control;
+            header.msg_controllen = sizeof(message.control);
+            cmsghdr *cmsg = CMSG_FIRSTHDR(&header);
+            cmsg->cmsg_level = SOL_UDP;
+            cmsg->cmsg_type = UDP_SEGMENT;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+            const uint16_t segment_size = message.segment_size;
+            memcpy(CMSG_DATA(cmsg), &segment_size, sizeof(segment_size));
+        }
+    }
+
+    // sendmmsg() may stop early, e.g. if the socket buffer fills up; keep going until everything is sent
+    size_t sent = 0;
+    while (sent < headers.size()) {
+        const int count =
+            SystemCall("sendmmsg", ::sendmmsg(fd_num(), headers.data() + sent, headers.size() - sent, 0));
+        for (int i = 0; i < count; i++) {
+            if (headers[sent + i].msg_len != messages[sent + i].size) {
+                throw runtime_error("datagram payload too big for sendmmsg()");
+            }
+        }
+        sent += count;
+        register_write();
+    }
+}
+
+//! \details Asks for the socket's UDP_SEGMENT setting, which kernels without UDP GSO do not know about.
+bool UDPSocket::gso_supported() const {
+    int segment_size = 0;
+    socklen_t len = sizeof(segment_size);
+    return ::getsockopt(fd_num(), SOL_UDP, UDP_SEGMENT, &segment_size, &len) == 0;
+}
+
+bool UDPSocket::enable_gro() {
+    const int enable = 1;
+    return ::setsockopt(fd_num(), SOL_UDP, UDP_GRO, &enable, sizeof(enable)) == 0;
+}
+
 // mark the socket as listening for incoming connections
 //! \param[in] backlog is the number of waiting connections to queue (see [listen(2)](\ref man2::listen))
 void TCPSocket::listen(const int backlog) { SystemCall("listen", ::listen(fd_num(), backlog)); }
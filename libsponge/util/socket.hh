@@ -7,7 +7,10 @@
 #include <cstdint>
 #include <functional>
 #include <string>
+#include <string_view>
 #include <sys/socket.h>
+#include <sys/uio.h>
+#include <vector>
 
 //! \brief Base class for network sockets (TCP, UDP, etc.)
 //! \details Socket is generally used via a subclass. See TCPSocket and UDPSocket for usage examples.
@@ -73,11 +76,72 @@ class UDPSocket : public Socket {
     //! Receive a datagram and the Address of its sender (caller can allocate storage)
     void recv(received_datagram &datagram, const size_t mtu = 65536);
 
+    //! \brief Storage for UDPSocket::recv_batch, allocated once and reused for every batch
+    //! \details Holds up to `capacity` datagrams of up to `mtu` bytes each. The payloads returned by
+    //! payload() point into the batch, so they are only valid until the next call to recv_batch();
+    //! whatever is kept longer must be copied out.
+    class DatagramBatch {
+        friend class UDPSocket;
+
+      private:
+        //! Room for the UDP_GRO control message that comes with a coalesced datagram
+        struct Control {
+            alignas(cmsghdr) char buffer[CMSG_SPACE(sizeof(int))];
+        };
+
+        size_t _mtu;
+        std::string _storage;                //!< `capacity` buffers of `mtu` bytes, back to back
+        std::vector<Address::Raw> _sources;  //!< Filled in by recvmmsg(2)
+        std::vector<Control> _controls;      //!< Filled in by recvmmsg(2)
+        std::vector<iovec> _iovecs;          //!< One per buffer (pointed at the storage by recv_batch())
+        std::vector<mmsghdr> _headers;       //!< One per buffer (pointed at the above by recv_batch())
+        std::vector<size_t> _segment_sizes;  //!< Filled in by recv_batch() from the UDP_GRO control messages
+        size_t _count{0};                    //!< Datagrams received by the last recv_batch()
+
+      public:
+        //! Allocate room for `capacity` datagrams of up to `mtu` bytes each
+        explicit DatagramBatch(const size_t capacity = 32, const size_t mtu = 65536);
+
+        size_t capacity() const { return _headers.size(); }  //!< Largest number of datagrams per batch
+        size_t size() const { return _count; }               //!< Datagrams in the current batch
+
+        //! Payload of the `i`th datagram of the current batch
+        std::string_view payload(const size_t i) const;
+
+        //! Address from which the `i`th datagram of the current batch was received
+        Address source_address(const size_t i) const;
+
+        //! \brief Size of the datagrams that were coalesced into the `i`th payload of the current batch
+        //! \details Only differs from the payload's size if UDPSocket::enable_gro() is in effect. Every
+        //! coalesced datagram but the last is exactly this size; the last may be shorter.
+        size_t segment_size(const size_t i) const;
+    };
+
+    //! Receive as many datagrams as are waiting (at least one, at most the batch's capacity) in one system call
+    size_t recv_batch(DatagramBatch &batch);
+
     //! Send a datagram to specified Address
     void sendto(const Address &destination, const BufferViewList &payload);
 
     //! Send datagram to the socket's connected address (must call connect() first)
     void send(const BufferViewList &payload);
+
+    //! \brief Send several datagrams to the specified Address, in as few system calls as possible
+    //! \details With `segment_offload`, each run of datagrams of the same size (optionally ending with a
+    //! shorter one) is handed to the kernel as a single UDP_SEGMENT "super-datagram" that it splits up
+    //! (see udp(7)). Only use `segment_offload` if gso_supported() is `true`.
+    void send_batch(const Address &destination,
+                    const std::vector<BufferViewList> &payloads,
+                    const bool segment_offload = false);
+
+    //! Can the kernel split datagrams sent with UDP_SEGMENT (generic segmentation offload)?
+    bool gso_supported() const;
+
+    //! \brief Let the kernel coalesce received datagrams into one payload (UDP_GRO)
+    //! \returns `false` if the kernel does not support it
+    //! \details Coalesced datagrams are reported by DatagramBatch::segment_size, so this only makes sense
+    //! for sockets read with recv_batch().
+    bool enable_gro();
 };
 
 //! \class UDPSocket
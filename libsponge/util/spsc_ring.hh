@@ -0,0 +1,84 @@
+#ifndef SPONGE_LIBSPONGE_SPSC_RING_HH
+#define SPONGE_LIBSPONGE_SPSC_RING_HH
+
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+//! \brief A bounded, lock-free queue for exactly one producer thread and one consumer thread
+//! \details The capacity is rounded up to a power of two. The producer only writes `_tail` and
+//! the consumer only writes `_head`; each is on its own cache line so that the two threads do
+//! not contend for it, and each side keeps a cached copy of the other side's index so that it
+//! only has to read the shared one when the ring looks full (or empty).
+template <typename T>
+class SPSCRing {
+  private:
+    static constexpr size_t CACHE_LINE = 64;
+
+    std::vector<std::optional<T>> _slots;
+    size_t _mask;
+
+    alignas(CACHE_LINE) std::atomic<size_t> _head{0};  //!< Next slot to pop (written by the consumer)
+    size_t _cached_tail{0};                             //!< Consumer's copy of `_tail`
+
+    alignas(CACHE_LINE) std::atomic<size_t> _tail{0};  //!< Next slot to push (written by the producer)
+    size_t _cached_head{0};                             //!< Producer's copy of `_head`
+
+    static size_t _round_up(const size_t capacity) {
+        if (capacity == 0) {
+            throw std::runtime_error("SPSCRing: capacity must be positive");
+        }
+        size_t rounded = 1;
+        while (rounded < capacity) {
+            rounded <<= 1;
+        }
+        return rounded;
+    }
+
+  public:
+    //! Construct a ring holding at least `capacity` elements
+    explicit SPSCRing(const size_t capacity) : _slots(_round_up(capacity)), _mask(_slots.size() - 1) {}
+
+    //! \brief Append an element (producer only)
+    //! \returns `false` if the ring is full, in which case `value` is left untouched
+    bool push(T &&value) {
+        const size_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail - _cached_head == _slots.size()) {
+            _cached_head = _head.load(std::memory_order_acquire);
+            if (tail - _cached_head == _slots.size()) {
+                return false;
+            }
+        }
+        _slots[tail & _mask].emplace(std::move(value));
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    //! \brief Remove the oldest element (consumer only)
+    //! \returns the element, or empty if the ring is empty
+    std::optional<T> pop() {
+        const size_t head = _head.load(std::memory_order_relaxed);
+        if (head == _cached_tail) {
+            _cached_tail = _tail.load(std::memory_order_acquire);
+            if (head == _cached_tail) {
+                return {};
+            }
+        }
+        auto &slot = _slots[head & _mask];
+        std::optional<T> ret{std::move(slot)};
+        slot.reset();
+        _head.store(head + 1, std::memory_order_release);
+        return ret;
+    }
+
+    //! \brief Is the ring empty? (exact only when called by the consumer)
+    bool empty() const { return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire); }
+
+    //! \brief Maximum number of elements the ring can hold
+    size_t capacity() const { return _slots.size(); }
+};
+
+#endif  // SPONGE_LIBSPONGE_SPSC_RING_HH
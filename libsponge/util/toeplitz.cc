@@ -0,0 +1,69 @@
+#include "toeplitz.hh"
+
+#include <stdexcept>
+
+using namespace std;
+
+//! The 32 key bits starting at bit `offset` (counting from the most significant bit of the key)
+static uint32_t key_window(const ToeplitzHash::Key &key, const size_t offset) {
+    uint32_t window = 0;
+    for (size_t i = 0; i < 32; i++) {
+        const size_t bit = offset + i;
+        window = (window << 1) | ((key[bit / 8] >> (7 - bit % 8)) & 1);
+    }
+    return window;
+}
+
+ToeplitzHash::ToeplitzHash(const Key &key) : _key(key) {
+    for (size_t i = 0; i < IPV4_TCP_INPUT_LENGTH; i++) {
+        for (unsigned byte = 0; byte < 256; byte++) {
+            uint32_t value = 0;
+            for (size_t bit = 0; bit < 8; bit++) {
+                if (byte & (0x80 >> bit)) {
+                    value ^= key_window(_key, i * 8 + bit);
+                }
+            }
+            _table[i][byte] = value;
+        }
+    }
+}
+
+//! \param[in] input is the byte string to hash
+//! \returns the 32-bit Toeplitz hash of `input`
+uint32_t ToeplitzHash::operator()(const string_view input) const {
+    if (input.size() > KEY_LENGTH - 4) {
+        throw runtime_error("ToeplitzHash: input longer than the key allows");
+    }
+
+    uint32_t result = 0;
+    for (size_t i = 0; i < input.size(); i++) {
+        const auto byte = static_cast<uint8_t>(input[i]);
+        if (i < IPV4_TCP_INPUT_LENGTH) {
+            result ^= _table[i][byte];
+            continue;
+        }
+        for (size_t bit = 0; bit < 8; bit++) {
+            if (byte & (0x80 >> bit)) {
+                result ^= key_window(_key, i * 8 + bit);
+            }
+        }
+    }
+    return result;
+}
+
+uint32_t ToeplitzHash::hash_ipv4_tcp(const uint32_t source_address,
+                                     const uint32_t destination_address,
+                                     const uint16_t source_port,
+                                     const uint16_t destination_port) const {
+    const array<uint32_t, 3> words{{source_address, destination_address,
+                                    (uint32_t{source_port} << 16) | destination_port}};
+
+    uint32_t result = 0;
+    size_t offset = 0;
+    for (const uint32_t word : words) {
+        for (int shift = 24; shift >= 0; shift -= 8) {
+            result ^= _table[offset++][(word >> shift) & 0xff];
+        }
+    }
+    return result;
+}
@@ -0,0 +1,51 @@
+#ifndef SPONGE_LIBSPONGE_TOEPLITZ_HH
+#define SPONGE_LIBSPONGE_TOEPLITZ_HH
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+//! \brief The Toeplitz hash used for receive-side scaling (RSS) by most NICs
+//! \details Each set bit of the input, most significant first, XORs in the 32-bit window of the
+//! key starting at that bit position. With the default key, hashing (source address,
+//! destination address, source port, destination port) gives the same value a NIC reports for
+//! an IPv4/TCP packet, so software steering agrees with hardware steering.
+//!
+//! The 12-byte IPv4/TCP input is hashed with one table lookup per byte; other inputs fall
+//! back to the bitwise definition.
+class ToeplitzHash {
+  public:
+    static constexpr size_t KEY_LENGTH = 40;             //!< Length of an RSS key, in bytes
+    static constexpr size_t IPV4_TCP_INPUT_LENGTH = 12;  //!< Two IPv4 addresses and two ports
+
+    using Key = std::array<uint8_t, KEY_LENGTH>;
+
+    //! The key from Microsoft's RSS specification, used by default by most drivers
+    static constexpr Key DEFAULT_KEY{{0x6d, 0x5a, 0x56, 0xda, 0x25, 0x5b, 0x0e, 0xc2, 0x41, 0x67,
+                                      0x25, 0x3d, 0x43, 0xa3, 0x8f, 0xb0, 0xd0, 0xca, 0x2b, 0xcb,
+                                      0xae, 0x7b, 0x30, 0xb4, 0x77, 0xcb, 0x2d, 0xa3, 0x80, 0x30,
+                                      0xf2, 0x0c, 0x6a, 0x42, 0xb7, 0x3b, 0xbe, 0xac, 0x01, 0xfa}};
+
+  private:
+    Key _key;
+
+    //! `_table[i][b]` is the contribution of byte value `b` at input offset `i`
+    std::array<std::array<uint32_t, 256>, IPV4_TCP_INPUT_LENGTH> _table{};
+
+  public:
+    //! Construct with the given key (by default, DEFAULT_KEY)
+    explicit ToeplitzHash(const Key &key = DEFAULT_KEY);
+
+    //! \brief Hash an arbitrary input of at most `KEY_LENGTH - 4` bytes
+    uint32_t operator()(std::string_view input) const;
+
+    //! \brief Hash an IPv4/TCP flow, as an RSS-capable NIC would
+    //! \note Addresses and ports are in host byte order
+    uint32_t hash_ipv4_tcp(const uint32_t source_address,
+                           const uint32_t destination_address,
+                           const uint16_t source_port,
+                           const uint16_t destination_port) const;
+};
+
+#endif  // SPONGE_LIBSPONGE_TOEPLITZ_HH
@@ -2,10 +2,12 @@
 
 #include "util.hh"
 
+#include <cerrno>
 #include <cstring>
 #include <fcntl.h>
 #include <linux/if.h>
 #include <linux/if_tun.h>
+#include <stdexcept>
 #include <sys/ioctl.h>
 
 static constexpr const char *CLONEDEV = "/dev/net/tun";
@@ -14,23 +16,46 @@ using namespace std;
 
 //! \param[in] devname is the name of the TUN or TAP device, specified at its creation.
 //! \param[in] is_tun is `true` for a TUN device (expects IP datagrams), or `false` for a TAP device (expects Ethernet frames)
+//! \param[in] multi_queue is `true` to open one more queue of a multi-queue device
+//! \param[in] vnet_hdr is `true` for frames to start with a virtio-net header
 //!
 //! To create a TUN device, you should already have run
 //!
 //!     ip tuntap add mode tun user `username` name `devname`
 //!
-//! as root before calling this function.
+//! as root before calling this function (add `multi_queue` to open several queues).
 
-TunTapFD::TunTapFD(const string &devname, const bool is_tun)
-    : FileDescriptor(SystemCall("open", open(CLONEDEV, O_RDWR))) {
+TunTapFD::TunTapFD(const string &devname, const bool is_tun, const bool multi_queue, const bool vnet_hdr)
+    : FileDescriptor(SystemCall("open", open(CLONEDEV, O_RDWR))), _vnet_hdr(vnet_hdr) {
     struct ifreq tun_req {};
 
     tun_req.ifr_flags = (is_tun ? IFF_TUN : IFF_TAP) | IFF_NO_PI;  // tun device with no packetinfo
+    if (multi_queue) {
+        tun_req.ifr_flags |= IFF_MULTI_QUEUE;
+    }
+    if (vnet_hdr) {
+        tun_req.ifr_flags |= IFF_VNET_HDR;
+    }
 
     // copy devname to ifr_name, making sure to null terminate
 
     strncpy(static_cast<char *>(tun_req.ifr_name), devname.data(), IFNAMSIZ - 1);
     tun_req.ifr_name[IFNAMSIZ - 1] = '\0';
 
-    SystemCall("ioctl", ioctl(fd_num(), TUNSETIFF, static_cast<void *>(&tun_req)));
+    const int ret = ioctl(fd_num(), TUNSETIFF, static_cast<void *>(&tun_req));
+    if (ret < 0 and errno == EINVAL and not multi_queue) {
+        // the kernel insists that IFF_MULTI_QUEUE match the device, so open a multi-queue device as one queue
+        tun_req.ifr_flags |= IFF_MULTI_QUEUE;
+        SystemCall("ioctl", ioctl(fd_num(), TUNSETIFF, static_cast<void *>(&tun_req)));
+    } else {
+        SystemCall("ioctl", ret);
+    }
+}
+
+//! \param[in] flags is a combination of `TUN_F_CSUM`, `TUN_F_TSO4` and the other `TUN_F_*` flags
+void TunTapFD::set_offload(const unsigned int flags) {
+    if (not _vnet_hdr) {
+        throw runtime_error("TunTapFD::set_offload() requires a device opened with vnet_hdr");
+    }
+    SystemCall("ioctl", ioctl(fd_num(), TUNSETOFFLOAD, flags));
 }
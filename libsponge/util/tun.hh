@@ -6,24 +6,46 @@
 #include <string>
 
 //! A FileDescriptor to a [Linux TUN/TAP](https://www.kernel.org/doc/Documentation/networking/tuntap.txt) device
+//! \details A device created with `multi_queue` (see tun.sh) can be opened any number of times with
+//! `multi_queue` set; each FileDescriptor is then one queue of the device, and the kernel spreads
+//! the device's flows over the queues. Opening such a device without `multi_queue` gives one queue.
+//!
+//! With `vnet_hdr`, every frame read or written starts with a VirtioNetHeader, through which the
+//! kernel and the program can hand checksums and segmentation to each other (see set_offload()).
 class TunTapFD : public FileDescriptor {
+  private:
+    bool _vnet_hdr;  //!< Do frames start with a virtio-net header?
+
   public:
     //! Open an existing persistent [TUN or TAP device](https://www.kernel.org/doc/Documentation/networking/tuntap.txt).
-    explicit TunTapFD(const std::string &devname, const bool is_tun);
+    explicit TunTapFD(const std::string &devname,
+                      const bool is_tun,
+                      const bool multi_queue = false,
+                      const bool vnet_hdr = false);
+
+    //! Do frames read from and written to the device start with a virtio-net header?
+    bool vnet_hdr() const { return _vnet_hdr; }
+
+    //! \brief Tell the kernel which offloads (`TUN_F_*` flags) we accept in frames it hands us
+    //! \details Only meaningful with `vnet_hdr`; e.g. `TUN_F_CSUM | TUN_F_TSO4` lets the kernel send
+    //! TCP/IPv4 super-segments without checksums, flagged in their virtio-net headers.
+    void set_offload(const unsigned int flags);
 };
 
 //! A FileDescriptor to a [Linux TUN](https://www.kernel.org/doc/Documentation/networking/tuntap.txt) device
 class TunFD : public TunTapFD {
   public:
     //! Open an existing persistent [TUN device](https://www.kernel.org/doc/Documentation/networking/tuntap.txt).
-    explicit TunFD(const std::string &devname) : TunTapFD(devname, true) {}
+    explicit TunFD(const std::string &devname, const bool multi_queue = false, const bool vnet_hdr = false)
+        : TunTapFD(devname, true, multi_queue, vnet_hdr) {}
 };
 
 //! A FileDescriptor to a [Linux TAP](https://www.kernel.org/doc/Documentation/networking/tuntap.txt) device
 class TapFD : public TunTapFD {
   public:
     //! Open an existing persistent [TAP device](https://www.kernel.org/doc/Documentation/networking/tuntap.txt).
-    explicit TapFD(const std::string &devname) : TunTapFD(devname, false) {}
+    explicit TapFD(const std::string &devname, const bool multi_queue = false, const bool vnet_hdr = false)
+        : TunTapFD(devname, false, multi_queue, vnet_hdr) {}
 };
 
 #endif  // SPONGE_LIBSPONGE_TUN_HH
@@ -1,13 +1,20 @@
 #include "util.hh"
 
 #include <array>
+#include <byteswap.h>
 #include <cctype>
 #include <chrono>
+#include <cstring>
+#include <endian.h>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
 #include <sys/socket.h>
 
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
 using namespace std;
 
 //! \returns the number of milliseconds since the program started
@@ -84,27 +91,190 @@ mt19937 get_random_generator() {
 //!
 //! For more information, see the [Wikipedia page](https://en.wikipedia.org/wiki/IPv4_header_checksum)
 //! on the Internet checksum, and consult the [IP](\ref rfc::rfc791) and [TCP](\ref rfc::rfc793) RFCs.
-InternetChecksum::InternetChecksum(const uint32_t initial_sum) : _sum(initial_sum) {}
+//! Adds with an end-around carry, as ones' complement addition does
+static uint64_t add_with_carry(const uint64_t a, const uint64_t b) {
+    const uint64_t sum = a + b;
+    return sum + (sum < a);
+}
 
-void InternetChecksum::add(std::string_view data) {
-    for (size_t i = 0; i < data.size(); i++) {
-        uint16_t val = uint8_t(data[i]);
-        if (not _parity) {
-            val <<= 8;
+//! Folds a sum of 16-bit words to 16 bits
+static uint16_t fold(uint64_t sum) {
+    while (sum > 0xffff) {
+        sum = (sum >> 16) + (sum & 0xffff);
+    }
+    return sum;
+}
+
+//! \brief Sums host-order words of `data` (zero-padded to a multiple of eight bytes), eight bytes at a time
+//! \details Each kernel returns a sum that folds to the ones' complement sum of the host-order 16-bit words.
+//! With `Copy`, it also copies `data` to `dst` as it goes, so that each byte is read once.
+template <bool Copy>
+static uint64_t sum_scalar(const char *data, size_t len, [[maybe_unused]] char *dst) {
+    uint64_t sum = 0;
+    for (; len >= 8; data += 8, len -= 8) {
+        uint64_t word;
+        memcpy(&word, data, 8);
+        if constexpr (Copy) {
+            memcpy(dst, &word, 8);
+            dst += 8;
+        }
+        sum = add_with_carry(sum, word);
+    }
+
+    uint64_t tail = 0;
+    memcpy(&tail, data, len);
+    if constexpr (Copy) {
+        memcpy(dst, &tail, len);
+    }
+    return add_with_carry(sum, tail);
+}
+
+#if defined(__x86_64__)
+//! Sums host-order words of `data`, 16 bytes at a time, widening 32-bit words into two 64-bit lanes
+template <bool Copy>
+static uint64_t sum_sse2(const char *data, size_t len, [[maybe_unused]] char *dst) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc = zero;
+    for (; len >= 16; data += 16, len -= 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+        if constexpr (Copy) {
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), v);
+            dst += 16;
         }
-        _sum += val;
-        _parity = !_parity;
+        acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(v, zero));
+        acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(v, zero));
     }
+
+    array<uint64_t, 2> lanes{};
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes.data()), acc);
+    return add_with_carry(add_with_carry(lanes[0], lanes[1]), sum_scalar<Copy>(data, len, dst));
 }
 
-uint16_t InternetChecksum::value() const {
-    uint32_t ret = _sum;
+//! Sums host-order words of `data`, 32 bytes at a time, widening 32-bit words into four 64-bit lanes
+template <bool Copy>
+__attribute__((target("avx2"))) static uint64_t sum_avx2(const char *data, size_t len, [[maybe_unused]] char *dst) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i acc = zero;
+    for (; len >= 32; data += 32, len -= 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data));
+        if constexpr (Copy) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), v);
+            dst += 32;
+        }
+        acc = _mm256_add_epi64(acc, _mm256_unpacklo_epi32(v, zero));
+        acc = _mm256_add_epi64(acc, _mm256_unpackhi_epi32(v, zero));
+    }
 
-    while (ret > 0xffff) {
-        ret = (ret >> 16) + (ret & 0xffff);
+    array<uint64_t, 4> lanes{};
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(lanes.data()), acc);
+    uint64_t sum = sum_scalar<Copy>(data, len, dst);
+    for (const auto lane : lanes) {
+        sum = add_with_carry(sum, lane);
     }
+    return sum;
+}
+#endif
+
+//! Sums (and with `Copy`, copies) `data` with `kernel`
+template <bool Copy>
+static uint64_t sum_with(const InternetChecksum::Kernel kernel, const string_view data, char *dst) {
+    switch (kernel) {
+#if defined(__x86_64__)
+        case InternetChecksum::Kernel::AVX2:
+            return sum_avx2<Copy>(data.data(), data.size(), dst);
+        case InternetChecksum::Kernel::SSE2:
+            return sum_sse2<Copy>(data.data(), data.size(), dst);
+#endif
+        default:
+            return sum_scalar<Copy>(data.data(), data.size(), dst);
+    }
+}
+
+bool InternetChecksum::supported(const Kernel kernel) {
+    switch (kernel) {
+        case Kernel::Scalar:
+            return true;
+#if defined(__x86_64__)
+        case Kernel::SSE2:
+            return true;  // part of x86-64
+        case Kernel::AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+    }
+}
+
+InternetChecksum::Kernel InternetChecksum::fastest_kernel() {
+    static const Kernel fastest = supported(Kernel::AVX2)   ? Kernel::AVX2
+                                  : supported(Kernel::SSE2) ? Kernel::SSE2
+                                                            : Kernel::Scalar;
+    return fastest;
+}
+
+//! \param[in] initial_sum is a sum to start from (e.g. IPv4Header::pseudo_cksum)
+//! \param[in] kernel is how add() sums its data (it must be supported())
+InternetChecksum::InternetChecksum(const uint32_t initial_sum, const Kernel kernel) : _sum(initial_sum), _kernel(kernel) {}
+
+void InternetChecksum::add(std::string_view data) {
+    if (data.empty()) {
+        return;  // leaves a 16-bit word left open by the last call open
+    }
+
+    // a byte that completes the 16-bit word left open by the last call is its low half
+    if (_parity) {
+        _sum += uint8_t(data.front());
+        data.remove_prefix(1);
+        _parity = false;
+    }
+
+    _sum += be16toh(fold(sum_with<false>(_kernel, data, nullptr)));
+    _parity = data.size() % 2;
+}
+
+//! \param[out] dst is where to copy `data` (it must have room for `data.size()` bytes)
+//! \param[in] data is the data to copy and add
+void InternetChecksum::add_copy(char *dst, std::string_view data) {
+    if (data.empty()) {
+        return;
+    }
+
+    if (_parity) {
+        *dst++ = data.front();
+        _sum += uint8_t(data.front());
+        data.remove_prefix(1);
+        _parity = false;
+    }
+
+    _sum += be16toh(fold(sum_with<true>(_kernel, data, dst)));
+    _parity = data.size() % 2;
+}
+
+//! \param[in] sum is the bytes' folded sum, i.e. `~value()` of a checksum that added just those bytes
+//! \param[in] len is the number of bytes
+void InternetChecksum::add_sum(const uint16_t sum, const size_t len) {
+    // bytes that start in the low half of a 16-bit word contribute their sum with its halves swapped
+    _sum += _parity ? bswap_16(sum) : sum;
+    _parity ^= len % 2;
+}
+
+uint16_t InternetChecksum::value() const { return ~fold(_sum); }
+
+//! \param[in] cksum is the checksum before the change
+//! \param[in] old_word is the 16-bit word before the change
+//! \param[in] new_word is the 16-bit word after the change
+uint16_t InternetChecksum::update_u16(const uint16_t cksum, const uint16_t old_word, const uint16_t new_word) {
+    const uint32_t sum = uint16_t(~cksum) + uint16_t(~old_word) + new_word;
+    return ~fold(sum);
+}
 
-    return ~ret;
+//! \param[in] cksum is the checksum before the change
+//! \param[in] old_field is the 32-bit field before the change
+//! \param[in] new_field is the 32-bit field after the change
+uint16_t InternetChecksum::update_u32(const uint16_t cksum, const uint32_t old_field, const uint32_t new_field) {
+    const uint32_t sum = uint16_t(~cksum) + uint16_t(~(old_field >> 16)) + uint16_t(~old_field) +
+                         (new_field >> 16) + (new_field & 0xffff);
+    return ~fold(sum);
 }
 
 //! \param[in] data is a pointer to the bytes to show
@@ -52,15 +52,44 @@ std::mt19937 get_random_generator();
 uint64_t timestamp_ms();
 
 //! The internet checksum algorithm
+//! \details add() sums eight bytes at a time into a 64-bit accumulator or, on x86-64, 16 or 32 bytes
+//! at a time with SSE2 or AVX2 (whichever is the fastest Kernel the CPU supports). The sum of
+//! little-endian words folds to the byte-swapped sum of big-endian words ([RFC 1071](\ref rfc::rfc1071)),
+//! so the kernels need not swap bytes.
 class InternetChecksum {
+  public:
+    //! The ways add() can sum its data
+    enum class Kernel { Scalar, SSE2, AVX2 };
+
   private:
-    uint32_t _sum;
-    bool _parity{};
+    uint64_t _sum;   //!< Sum of big-endian 16-bit words so far, not yet folded
+    bool _parity{};  //!< Has an odd number of bytes been added?
+    Kernel _kernel;  //!< How add() sums its data
 
   public:
-    InternetChecksum(const uint32_t initial_sum = 0);
+    InternetChecksum(const uint32_t initial_sum = 0, const Kernel kernel = fastest_kernel());
     void add(std::string_view data);
     uint16_t value() const;
+
+    //! \brief Copy `data` to `dst` and add it, reading each byte once
+    void add_copy(char *dst, std::string_view data);
+
+    //! \brief Add bytes whose sum is already known (e.g. Buffer::cksum_partial()), as add() would
+    void add_sum(const uint16_t sum, const size_t len);
+
+    //! The fastest Kernel this CPU supports
+    static Kernel fastest_kernel();
+
+    //! Does this CPU support `kernel`?
+    static bool supported(const Kernel kernel);
+
+    //! \brief Patch a checksum after a 16-bit word it covers changes, without summing the rest again
+    //! \details [RFC 1624](\ref rfc::rfc1624), eqn. 3: HC' = ~(~HC + ~m + m')
+    static uint16_t update_u16(const uint16_t cksum, const uint16_t old_word, const uint16_t new_word);
+
+    //! \brief Patch a checksum after a 32-bit field it covers (e.g. an IPv4 address) changes
+    //! \details The field must start on a 16-bit boundary of the checksummed data
+    static uint16_t update_u32(const uint16_t cksum, const uint32_t old_field, const uint32_t new_field);
 };
 
 //! Hexdump the contents of a packet (or any other sequence of bytes)
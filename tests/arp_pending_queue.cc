@@ -0,0 +1,124 @@
+#include "arp_message.hh"
+#include "ethernet_frame.hh"
+#include "ipv4_datagram.hh"
+#include "network_interface.hh"
+#include "test_should_be.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static const EthernetAddress local{2, 0, 0, 0, 0, 1};
+
+static EthernetAddress neighbor_ethernet_address(const uint32_t n) {
+    return {2, 0, uint8_t(n >> 24), uint8_t(n >> 16), uint8_t(n >> 8), uint8_t(n)};
+}
+
+static uint32_t neighbor_ip(const uint32_t n) { return 0x0a01'0000 + n; }
+
+//! The ARP reply of neighbor `n` to `interface`
+static void hear_from(NetworkInterface &interface, const uint32_t n) {
+    ARPMessage arp;
+    arp.opcode = ARPMessage::OPCODE_REPLY;
+    arp.sender_ethernet_address = neighbor_ethernet_address(n);
+    arp.sender_ip_address = neighbor_ip(n);
+    arp.target_ethernet_address = local;
+    arp.target_ip_address = Address("10.0.0.1").ipv4_numeric();
+    EthernetFrame frame;
+    frame.header() = {local, neighbor_ethernet_address(n), EthernetHeader::TYPE_ARP};
+    frame.payload() = arp.serialize();
+    interface.recv_frame(frame);
+}
+
+//! Send neighbor `n` a datagram whose payload is `payload`
+static void send_to(NetworkInterface &interface, const uint32_t n, const string &payload) {
+    InternetDatagram dgram;
+    dgram.header().dst = neighbor_ip(n);
+    dgram.payload() = string(payload);
+    dgram.header().len = dgram.header().hlen * 4 + dgram.payload().size();
+    interface.send_datagram(dgram, Address::from_ipv4_numeric(neighbor_ip(n)));
+}
+
+//! The frames the interface has sent (emptying its queue): the payloads of the datagrams, and "ARP" for ARP
+static vector<string> sent(NetworkInterface &interface) {
+    vector<string> frames;
+    for (auto &queue = interface.frames_out(); not queue.empty(); queue.pop()) {
+        if (queue.front().header().type == EthernetHeader::TYPE_ARP) {
+            frames.push_back("ARP");
+            continue;
+        }
+        InternetDatagram dgram;
+        test_should_be(dgram.parse(queue.front().payload().concatenate()) == ParseResult::NoError, true);
+        frames.push_back(dgram.payload().concatenate());
+    }
+    return frames;
+}
+
+//! Datagrams past the limit are dropped and counted; the rest go out in order once the neighbor
+//! answers, and only the datagrams for that neighbor
+static void test_limit_and_flush() {
+    NetworkInterface interface{local, Address("10.0.0.1"), 3};
+    for (const char *payload : {"a", "b", "c", "d", "e"}) {
+        send_to(interface, 1, payload);
+    }
+    send_to(interface, 2, "x");
+    test_should_be((sent(interface) == vector<string>{"ARP", "ARP"}), true);
+    test_should_be(interface.pending_datagrams(), size_t(4));
+    test_should_be(interface.pending_drops(), uint64_t(2));
+
+    // they keep waiting while the request is repeated
+    interface.tick(5'000);
+    test_should_be((sent(interface) == vector<string>{"ARP", "ARP"}), true);
+    test_should_be(interface.pending_datagrams(), size_t(4));
+
+    hear_from(interface, 1);
+    test_should_be((sent(interface) == vector<string>{"a", "b", "c"}), true);
+    test_should_be(interface.pending_datagrams(), size_t(1));
+    send_to(interface, 1, "f");
+    test_should_be((sent(interface) == vector<string>{"f"}), true);
+
+    hear_from(interface, 2);
+    test_should_be((sent(interface) == vector<string>{"x"}), true);
+    test_should_be(interface.pending_datagrams(), size_t(0));
+    test_should_be(interface.pending_drops(), uint64_t(2));
+}
+
+//! Thousands of neighbors resolving at once each get just their own datagrams, in order
+static void test_many_neighbors() {
+    constexpr uint32_t NEIGHBORS = 5000;
+    constexpr unsigned PER_NEIGHBOR = 10;
+    NetworkInterface interface{local, Address("10.0.0.1")};
+    for (unsigned i = 0; i < PER_NEIGHBOR; i++) {
+        for (uint32_t n = 0; n < NEIGHBORS; n++) {
+            send_to(interface, n, to_string(n) + "/" + to_string(i));
+        }
+    }
+    test_should_be(sent(interface).size(), size_t(NEIGHBORS));  // an ARP request each
+    test_should_be(interface.pending_datagrams(), size_t(NEIGHBORS * PER_NEIGHBOR));
+
+    for (uint32_t n = NEIGHBORS; n-- > 0;) {
+        hear_from(interface, n);
+        vector<string> expected;
+        for (unsigned i = 0; i < PER_NEIGHBOR; i++) {
+            expected.push_back(to_string(n) + "/" + to_string(i));
+        }
+        test_should_be(sent(interface) == expected, true);
+    }
+    test_should_be(interface.pending_datagrams(), size_t(0));
+    test_should_be(interface.pending_drops(), uint64_t(0));
+}
+
+int main() {
+    try {
+        test_limit_and_flush();
+        test_many_neighbors();
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
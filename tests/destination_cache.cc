@@ -0,0 +1,213 @@
+#include "arp_message.hh"
+#include "destination_cache.hh"
+#include "ethernet_frame.hh"
+#include "ipv4_datagram.hh"
+#include "router.hh"
+#include "test_should_be.hh"
+
+#include <array>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static void test_basics() {
+    DestinationCache cache{16};
+    test_should_be(cache.capacity(), size_t(64));
+    cache.validate(1);
+
+    optional<uint32_t> value;
+    test_should_be(cache.lookup(0x0a000001, value), false);
+    cache.insert(0x0a000001, 7);
+    cache.insert(0x0a000002, {});  // an address no route matches is cached too
+    test_should_be(cache.lookup(0x0a000001, value), true);
+    test_should_be(value == 7u, true);
+    test_should_be(cache.lookup(0x0a000002, value), true);
+    test_should_be(value.has_value(), false);
+    test_should_be(cache.hits(), uint64_t(2));
+    test_should_be(cache.misses(), uint64_t(1));
+
+    // the same generation keeps the entries, and a new one drops them all
+    cache.validate(1);
+    test_should_be(cache.lookup(0x0a000001, value), true);
+    cache.validate(2);
+    test_should_be(cache.lookup(0x0a000001, value), false);
+    test_should_be(cache.lookup(0x0a000002, value), false);
+
+    // looked up in a batch: the hits' results, and the misses' indices
+    cache.insert(0x0a000001, 7);
+    cache.insert(0x0a000003, 9);
+    const array<uint32_t, 4> addresses{0x0a000001, 0x0a000002, 0x0a000003, 0x0a000004};
+    array<optional<uint32_t>, 4> values{};
+    array<size_t, 4> missed{};
+    test_should_be(cache.lookup(addresses.data(), values.data(), missed.data(), addresses.size()), size_t(2));
+    test_should_be(values[0] == 7u, true);
+    test_should_be(values[2] == 9u, true);
+    test_should_be(missed[0], size_t(1));
+    test_should_be(missed[1], size_t(3));
+    test_should_be(cache.hits(), uint64_t(5));
+    test_should_be(cache.misses(), uint64_t(5));
+
+    // a cache without sets never hits
+    DestinationCache none{0};
+    none.insert(0x0a000001, 7);
+    test_should_be(none.lookup(0x0a000001, value), false);
+    test_should_be(none.lookup(addresses.data(), values.data(), missed.data(), addresses.size()), size_t(4));
+    test_should_be(none.capacity(), size_t(0));
+    test_should_be(none.hits(), uint64_t(0));
+    test_should_be(none.misses(), uint64_t(5));
+}
+
+//! Addresses that hash to the same set share its WAYS entries, evicting one another in turn
+static void test_eviction() {
+    DestinationCache cache{1};
+    cache.validate(1);
+    optional<uint32_t> value;
+    for (uint32_t address = 0; address < DestinationCache::WAYS; address++) {
+        cache.insert(address, address);
+    }
+    cache.insert(0, 0);  // already cached: takes no second entry
+    for (uint32_t address = 0; address < DestinationCache::WAYS; address++) {
+        test_should_be(cache.lookup(address, value), true);
+        test_should_be(value == address, true);
+    }
+
+    cache.insert(100, 100);  // evicts the first
+    test_should_be(cache.lookup(0, value), false);
+    test_should_be(cache.lookup(1, value), true);
+    test_should_be(cache.lookup(100, value), true);
+    cache.insert(101, 101);  // then the second
+    test_should_be(cache.lookup(1, value), false);
+    test_should_be(cache.lookup(2, value), true);
+}
+
+//! Whatever is inserted, a lookup gives the last value inserted for the address in its generation, or misses
+static void test_against_map() {
+    mt19937 rng(0xcac4e);
+    DestinationCache cache{64};
+    vector<optional<uint32_t>> inserted(1000);
+    uint64_t generation = 1;
+    cache.validate(generation);
+    for (unsigned i = 0; i < 100'000; i++) {
+        const uint32_t address = rng() % inserted.size();
+        optional<uint32_t> value;
+        if (rng() % 1000 == 0) {
+            cache.validate(++generation);
+            inserted.assign(inserted.size(), {});
+        } else if (rng() % 2 == 0) {
+            value = rng() % 3 == 0 ? nullopt : optional<uint32_t>(rng() % 1000);
+            cache.insert(address, value);
+            inserted[address] = value.value_or(UINT32_MAX - 1);
+        } else if (cache.lookup(address, value)) {
+            test_should_be(inserted[address].has_value(), true);
+            test_should_be(value.value_or(UINT32_MAX - 1) == inserted[address].value(), true);
+        }
+    }
+    test_should_be(cache.hits() > 0, true);
+}
+
+//! Teach a router interface the Ethernet address of a neighbor, with an ARP reply from it
+static void learn_neighbor(AsyncNetworkInterface &interface,
+                           const EthernetAddress &interface_ethernet_address,
+                           const string &interface_ip,
+                           const EthernetAddress &neighbor_ethernet_address,
+                           const string &neighbor_ip) {
+    ARPMessage arp;
+    arp.opcode = ARPMessage::OPCODE_REPLY;
+    arp.sender_ethernet_address = neighbor_ethernet_address;
+    arp.sender_ip_address = Address(neighbor_ip).ipv4_numeric();
+    arp.target_ethernet_address = interface_ethernet_address;
+    arp.target_ip_address = Address(interface_ip).ipv4_numeric();
+
+    EthernetFrame frame;
+    frame.header() = {interface_ethernet_address, neighbor_ethernet_address, EthernetHeader::TYPE_ARP};
+    frame.payload() = arp.serialize();
+    interface.recv_frame(frame);
+}
+
+//! The number of frames an interface has sent (emptying its queue)
+static size_t frames_sent(AsyncNetworkInterface &interface) {
+    size_t count = 0;
+    for (auto &frames = interface.frames_out(); not frames.empty(); frames.pop()) {
+        count++;
+    }
+    return count;
+}
+
+//! A router's cached routes give way to the routes added after them
+static void test_router_invalidation() {
+    const EthernetAddress eth1{2, 0, 0, 0, 0, 2}, eth2{2, 0, 0, 0, 0, 3};
+    Router router;
+    router.add_interface({EthernetAddress{2, 0, 0, 0, 0, 1}, Address("10.0.0.1")});
+    router.add_interface({eth1, Address("10.1.0.1")});
+    router.add_interface({eth2, Address("10.2.0.1")});
+    learn_neighbor(router.interface(1), eth1, "10.1.0.1", {2, 0, 0, 0, 1, 2}, "10.1.0.2");
+    learn_neighbor(router.interface(2), eth2, "10.2.0.1", {2, 0, 0, 0, 1, 3}, "10.2.0.2");
+    router.add_route(0, 0, Address("10.1.0.2"), 1);
+
+    const auto route_to = [&](const string &destination) {
+        InternetDatagram dgram;
+        dgram.header().src = Address("10.0.0.2").ipv4_numeric();
+        dgram.header().dst = Address(destination).ipv4_numeric();
+        dgram.header().len = dgram.header().hlen * 4;
+        router.interface(0).datagrams_out().push(dgram);
+        router.route();
+    };
+
+    route_to("192.168.0.1");
+    route_to("192.168.0.1");
+    test_should_be(router.route_cache_misses(), uint64_t(1));
+    test_should_be(router.route_cache_hits(), uint64_t(1));
+    test_should_be(frames_sent(router.interface(1)), size_t(2));
+
+    router.add_route(Address("192.168.0.0").ipv4_numeric(), 16, Address("10.2.0.2"), 2);
+    route_to("192.168.0.1");
+    test_should_be(router.route_cache_misses(), uint64_t(2));
+    test_should_be(frames_sent(router.interface(2)), size_t(1));
+
+    router.remove_route(Address("192.168.0.0").ipv4_numeric(), 16);
+    route_to("192.168.0.1");
+    test_should_be(router.route_cache_misses(), uint64_t(3));
+    test_should_be(frames_sent(router.interface(1)), size_t(1));
+    test_should_be(frames_sent(router.interface(2)), size_t(0));
+}
+
+//! A router without a cache (as DIR-24-8's is by default) counts every lookup as a miss
+static void test_router_without_cache() {
+    const EthernetAddress eth1{2, 0, 0, 0, 0, 2};
+    Router router{Router::LPM::Dir24_8};
+    router.add_interface({EthernetAddress{2, 0, 0, 0, 0, 1}, Address("10.0.0.1")});
+    router.add_interface({eth1, Address("10.1.0.1")});
+    learn_neighbor(router.interface(1), eth1, "10.1.0.1", {2, 0, 0, 0, 1, 2}, "10.1.0.2");
+    router.add_route(0, 0, Address("10.1.0.2"), 1);
+
+    for (unsigned i = 0; i < 3; i++) {
+        InternetDatagram dgram;
+        dgram.header().dst = Address("192.168.0.1").ipv4_numeric();
+        dgram.header().len = dgram.header().hlen * 4;
+        router.interface(0).datagrams_out().push(dgram);
+        router.route();
+    }
+    test_should_be(frames_sent(router.interface(1)), size_t(3));
+    test_should_be(router.route_cache_hits(), uint64_t(0));
+    test_should_be(router.route_cache_misses(), uint64_t(3));
+}
+
+int main() {
+    try {
+        test_basics();
+        test_eviction();
+        test_against_map();
+        test_router_invalidation();
+        test_router_without_cache();
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
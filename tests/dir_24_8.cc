@@ -0,0 +1,109 @@
+#include "dir_24_8.hh"
+#include "linear_prefix_table.hh"
+#include "test_should_be.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+//! An address in or near `prefix`: it keeps a random number of the prefix's high-order bits
+static uint32_t address_near(mt19937 &rng, const uint32_t prefix) {
+    const unsigned kept = rng() % 33;
+    const uint32_t random_bits = kept == 32 ? 0 : rng() >> kept;
+    return prefix ^ random_bits;
+}
+
+//! Tables of prefixes clustered around a few addresses (so that they nest and overlap, and shorter
+//! prefixes land on /24s that longer ones have already split), inserted in random order, give the
+//! same answers as the linear scan after every insertion
+static void test_against_linear(mt19937 &rng) {
+    for (unsigned round = 0; round < 20; round++) {
+        Dir24_8 table;
+        LinearPrefixTable linear;
+        vector<uint32_t> prefixes;
+
+        const uint32_t cluster = rng();
+        const unsigned count = rng() % 400;
+        for (unsigned i = 0; i < count; i++) {
+            // mostly long prefixes, so that many /24s are split into blocks
+            const uint32_t prefix = address_near(rng, cluster);
+            const uint8_t length = rng() % 2 ? 16 + rng() % 17 : rng() % 33;
+            table.insert(prefix, length, i);
+            linear.insert(prefix, length, i);
+            prefixes.push_back(prefix);
+
+            for (unsigned j = 0; j < 50; j++) {
+                const uint32_t address = address_near(rng, prefixes[rng() % prefixes.size()]);
+                test_should_be(table.lookup(address) == linear.lookup(address), true);
+            }
+        }
+        test_should_be(table.size(), size_t(count));
+
+        // in batches (the last of them partial, and not a multiple of the gathers' eight lanes)
+        vector<uint32_t> addresses;
+        for (unsigned i = 0; i < 1003; i++) {
+            addresses.push_back(prefixes.empty() ? rng() : address_near(rng, prefixes[rng() % prefixes.size()]));
+        }
+        vector<optional<uint32_t>> values(addresses.size());
+        table.lookup(addresses.data(), values.data(), addresses.size());
+        for (size_t i = 0; i < addresses.size(); i++) {
+            test_should_be(values[i] == linear.lookup(addresses[i]), true);
+        }
+    }
+}
+
+static void test_basics() {
+    Dir24_8 table;
+    test_should_be(table.lookup(0x0a000001).has_value(), false);
+    const size_t empty_usage = table.memory_usage();
+    test_should_be(empty_usage, size_t(64) << 20);
+
+    table.insert(0x0a010203, 32, 3);  // 10.1.2.3/32, before the prefixes that cover it
+    test_should_be(table.memory_usage(), empty_usage + 256 * sizeof(uint32_t));
+    table.insert(0x0a000000, 8, 1);   // 10.0.0.0/8
+    table.insert(0x0a010000, 16, 2);  // 10.1.0.0/16
+    table.insert(0x0a0102ff, 24, 4);  // 10.1.2.0/24 (with host bits set, which are ignored)
+    table.insert(0x0a010200, 24, 5);  // 10.1.2.0/24 again: the first value stays
+    test_should_be(table.stale(), false);
+    test_should_be(table.lookup(0x0a000001) == 1u, true);
+    test_should_be(table.lookup(0x0a01ffff) == 2u, true);
+    test_should_be(table.lookup(0x0a010203) == 3u, true);
+    test_should_be(table.lookup(0x0a010204) == 4u, true);
+    test_should_be(table.lookup(0x0b000000).has_value(), false);
+
+    table.insert(0x0a010280, 25, 7);  // 10.1.2.128/25, in the block that 10.1.2.3/32 made
+    test_should_be(table.memory_usage(), empty_usage + 256 * sizeof(uint32_t));
+    test_should_be(table.lookup(0x0a010280) == 7u, true);
+    test_should_be(table.lookup(0x0a010203) == 3u, true);
+    test_should_be(table.lookup(0x0a01027f) == 4u, true);
+
+    table.insert(0, 0, 6);  // default route
+    test_should_be(table.lookup(0x0b000000) == 6u, true);
+    test_should_be(table.lookup(0x0a010204) == 4u, true);
+    test_should_be(table.lookup(0x0a010203) == 3u, true);
+
+    bool threw = false;
+    try {
+        table.insert(0, 33, 1);
+    } catch (const exception &) {
+        threw = true;
+    }
+    test_should_be(threw, true);
+}
+
+int main() {
+    try {
+        mt19937 rng(0x5eed);
+        test_basics();
+        test_against_linear(rng);
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,111 @@
+#include "arp_message.hh"
+#include "ethernet_frame.hh"
+#include "ipv4_datagram.hh"
+#include "network_interface.hh"
+#include "packet_buffer.hh"
+#include "test_should_be.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static const EthernetAddress local{2, 0, 0, 0, 0, 1};
+static const EthernetAddress neighbor{2, 0, 0, 0, 0, 2};
+static const EthernetAddress moved{2, 0, 0, 0, 0, 3};
+
+//! The ARP reply of the neighbor at 10.0.0.2, now at `ethernet_address`
+static void hear_from(NetworkInterface &interface, const EthernetAddress &ethernet_address) {
+    ARPMessage arp;
+    arp.opcode = ARPMessage::OPCODE_REPLY;
+    arp.sender_ethernet_address = ethernet_address;
+    arp.sender_ip_address = Address("10.0.0.2").ipv4_numeric();
+    arp.target_ethernet_address = local;
+    arp.target_ip_address = Address("10.0.0.1").ipv4_numeric();
+    EthernetFrame frame;
+    frame.header() = {local, ethernet_address, EthernetHeader::TYPE_ARP};
+    frame.payload() = arp.serialize();
+    interface.recv_frame(frame);
+}
+
+//! The frame the interface makes to send the neighbor a datagram holding `payload`
+static EthernetFrame send(NetworkInterface &interface, const string &payload) {
+    InternetDatagram dgram;
+    dgram.header().dst = Address("10.0.0.2").ipv4_numeric();
+    dgram.payload() = string(payload);
+    dgram.header().len = dgram.header().hlen * 4 + dgram.payload().size();
+    interface.send_datagram(dgram, Address("10.0.0.2"));
+    test_should_be(interface.frames_out().size(), size_t(1));
+    EthernetFrame frame = interface.frames_out().front();
+    interface.frames_out().pop();
+    return frame;
+}
+
+//! The bytes of the header `frame` serializes to
+static string header_bytes(const EthernetFrame &frame) {
+    return frame.serialize().concatenate().substr(0, EthernetHeader::LENGTH);
+}
+
+//! A frame given a serialized header serializes to it, in either way, until its header may change
+static void test_frame() {
+    const EthernetHeader header{neighbor, local, EthernetHeader::TYPE_IPv4};
+    const Buffer serialized{header.serialize()};
+    EthernetFrame frame;
+    frame.set_header(header, serialized);
+    frame.payload() = string("payload");
+
+    const BufferList bytes = frame.serialize();
+    test_should_be(bytes.buffers().front().str().data() == serialized.str().data(), true);  // not a copy
+    test_should_be(bytes.concatenate() == header.serialize() + "payload", true);
+    PacketBuffer packet{EthernetHeader::LENGTH, frame.payload()};
+    frame.serialize_into(packet);
+    test_should_be(packet.str() == header.serialize() + "payload", true);
+
+    frame.header().dst = moved;
+    test_should_be((header_bytes(frame) == EthernetHeader{moved, local, EthernetHeader::TYPE_IPv4}.serialize()), true);
+
+    bool threw = false;
+    try {
+        frame.set_header(header, Buffer(string("short")));
+    } catch (const runtime_error &) {
+        threw = true;
+    }
+    test_should_be(threw, true);
+}
+
+//! Every frame to a neighbor shares one header, which follows the neighbor when it moves
+static void test_interface() {
+    NetworkInterface interface{local, Address("10.0.0.1")};
+    hear_from(interface, neighbor);
+    const EthernetFrame first = send(interface, "a");
+    const EthernetFrame second = send(interface, "b");
+    const string expected = EthernetHeader{neighbor, local, EthernetHeader::TYPE_IPv4}.serialize();
+    test_should_be(header_bytes(first) == expected, true);
+    test_should_be(first.serialize().buffers().front().str().data() ==
+                       second.serialize().buffers().front().str().data(),
+                   true);
+    test_should_be(first.header().dst == neighbor, true);
+
+    hear_from(interface, neighbor);  // refreshed, but not moved: the same header
+    test_should_be(send(interface, "c").serialize().buffers().front().str().data() ==
+                       first.serialize().buffers().front().str().data(),
+                   true);
+
+    hear_from(interface, moved);
+    const EthernetFrame third = send(interface, "d");
+    test_should_be((header_bytes(third) == EthernetHeader{moved, local, EthernetHeader::TYPE_IPv4}.serialize()), true);
+    test_should_be(third.header().dst == moved, true);
+}
+
+int main() {
+    try {
+        test_frame();
+        test_interface();
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
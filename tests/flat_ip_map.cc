@@ -0,0 +1,143 @@
+#include "arp_message.hh"
+#include "ethernet_frame.hh"
+#include "flat_ip_map.hh"
+#include "ipv4_datagram.hh"
+#include "network_interface.hh"
+#include "test_should_be.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+
+using namespace std;
+
+//! Random insertions and erasures, of addresses packed close together (as neighbors' are) and
+//! scattered, leave the map holding just what a std::map would
+static void test_against_map() {
+    mt19937 rng(0xf1a7);
+    FlatIpMap<uint64_t> flat;
+    map<uint32_t, uint64_t> reference;
+    for (unsigned i = 0; i < 200'000; i++) {
+        const uint32_t key = rng() % 4 == 0 ? uint32_t(rng()) : 0x0a00'0000 + rng() % 3000;
+        switch (rng() % 3) {
+            case 0:
+                flat.insert_or_assign(key, i);
+                reference[key] = i;
+                break;
+            case 1:
+                test_should_be(flat.erase(key), reference.erase(key) == 1);
+                break;
+            default: {
+                const uint64_t *value = flat.find(key);
+                const auto it = reference.find(key);
+                test_should_be(value != nullptr, it != reference.end());
+                if (value) {
+                    test_should_be(*value, it->second);
+                }
+            }
+        }
+        test_should_be(flat.size(), reference.size());
+    }
+    for (const auto &[key, value] : reference) {
+        test_should_be(*flat.find(key), value);
+    }
+    test_should_be(flat.find(0) == nullptr, true);
+}
+
+static EthernetAddress neighbor_ethernet_address(const uint32_t n) {
+    return {2, 0, uint8_t(n >> 24), uint8_t(n >> 16), uint8_t(n >> 8), uint8_t(n)};
+}
+
+//! \details An interface learns thousands of neighbors, then forgets each exactly 30 s after it last
+//! heard from it; one it asks for again is asked for every 5 s until it answers
+static void test_many_neighbors() {
+    constexpr uint32_t NEIGHBORS = 5000;
+    const EthernetAddress local{2, 0, 0, 0, 0, 1};
+    NetworkInterface interface{local, Address("10.0.0.1")};
+
+    const auto hear_from = [&](const uint32_t n) {
+        ARPMessage arp;
+        arp.opcode = ARPMessage::OPCODE_REPLY;
+        arp.sender_ethernet_address = neighbor_ethernet_address(n);
+        arp.sender_ip_address = 0x0a01'0000 + n;
+        arp.target_ethernet_address = local;
+        arp.target_ip_address = Address("10.0.0.1").ipv4_numeric();
+        EthernetFrame frame;
+        frame.header() = {local, neighbor_ethernet_address(n), EthernetHeader::TYPE_ARP};
+        frame.payload() = arp.serialize();
+        interface.recv_frame(frame);
+    };
+    // the type of the one frame that sending to neighbor `n` makes
+    const auto send_to = [&](const uint32_t n) {
+        InternetDatagram dgram;
+        dgram.header().dst = 0x0a01'0000 + n;
+        dgram.header().len = dgram.header().hlen * 4;
+        interface.send_datagram(dgram, Address::from_ipv4_numeric(0x0a01'0000 + n));
+        test_should_be(interface.frames_out().size(), size_t(1));
+        const auto frame = interface.frames_out().front();
+        interface.frames_out().pop();
+        if (frame.header().type == EthernetHeader::TYPE_IPv4) {
+            test_should_be(frame.header().dst == neighbor_ethernet_address(n), true);
+        }
+        return frame.header().type;
+    };
+
+    // the even neighbors are heard from at 0 ms, and the odd ones at 10 s; the first hundred again at 20 s
+    for (uint32_t n = 0; n < NEIGHBORS; n += 2) {
+        hear_from(n);
+    }
+    interface.tick(10'000);
+    for (uint32_t n = 1; n < NEIGHBORS; n += 2) {
+        hear_from(n);
+    }
+    interface.tick(10'000);
+    for (uint32_t n = 0; n < 100; n++) {
+        hear_from(n);
+    }
+
+    interface.tick(9'999);
+    for (uint32_t n = 0; n < NEIGHBORS; n++) {
+        test_should_be(send_to(n), EthernetHeader::TYPE_IPv4);
+    }
+    interface.tick(1);  // 30 s: the even ones past the first hundred are forgotten
+    for (uint32_t n = 0; n < NEIGHBORS; n++) {
+        const bool known = n < 100 or n % 2 == 1;
+        test_should_be(send_to(n), known ? EthernetHeader::TYPE_IPv4 : EthernetHeader::TYPE_ARP);
+    }
+
+    // those asked for are asked for again every 5 s until they answer
+    interface.tick(4'999);
+    test_should_be(interface.frames_out().size(), size_t(0));
+    interface.tick(1);
+    test_should_be(interface.frames_out().size(), size_t(NEIGHBORS / 2 - 50));
+    while (not interface.frames_out().empty()) {
+        interface.frames_out().pop();
+    }
+    hear_from(4998);
+    test_should_be(interface.frames_out().size(), size_t(1));  // its datagram, sent at last
+    interface.frames_out().pop();
+
+    // 40 s: the odd ones past the first hundred are forgotten
+    interface.tick(5'000);
+    test_should_be(interface.frames_out().size(), size_t(NEIGHBORS / 2 - 51));
+    while (not interface.frames_out().empty()) {
+        interface.frames_out().pop();
+    }
+    test_should_be(send_to(4999), EthernetHeader::TYPE_ARP);
+    test_should_be(send_to(99), EthernetHeader::TYPE_IPv4);
+    test_should_be(send_to(4998), EthernetHeader::TYPE_IPv4);
+}
+
+int main() {
+    try {
+        test_against_map();
+        test_many_neighbors();
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,72 @@
+#include "ipv4_datagram.hh"
+#include "ipv4_header.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "test_should_be.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+//! A serialized TCP/IPv4 datagram from 10.0.0.2:`sport` to 10.0.0.1:`dport`
+static string make_datagram(const uint16_t sport, const uint16_t dport, const bool syn) {
+    TCPSegment seg;
+    seg.header().sport = sport;
+    seg.header().dport = dport;
+    seg.header().seqno = WrappingInt32(0xdeadbeef);
+    seg.header().syn = syn;
+    seg.header().win = 4321;
+    seg.payload() = Buffer{string("hello")};
+
+    IPv4Datagram dgram;
+    dgram.header().src = 0x0a000002;
+    dgram.header().dst = 0x0a000001;
+    dgram.header().ttl = 17;
+    dgram.header().len = IPv4Header::LENGTH + TCPHeader::LENGTH + seg.payload().size();
+    dgram.payload() = seg.serialize(dgram.header().pseudo_cksum());
+    return dgram.serialize().concatenate();
+}
+
+//! The views read the same fields as the parsers
+static void test_fields() {
+    const string raw = make_datagram(5000, 80, true);
+
+    const auto ip_header = IPv4HeaderView::from(raw);
+    test_should_be(ip_header.has_value(), true);
+    test_should_be(ip_header->ver(), uint8_t(4));
+    test_should_be(ip_header->len(), uint16_t(raw.size()));
+    test_should_be(ip_header->ttl(), uint8_t(17));
+    test_should_be(ip_header->proto(), IPv4Header::PROTO_TCP);
+    test_should_be(ip_header->src(), uint32_t(0x0a000002));
+    test_should_be(ip_header->dst(), uint32_t(0x0a000001));
+
+    const auto tcp_header = TCPHeaderView::from(ip_header->payload());
+    test_should_be(tcp_header.has_value(), true);
+    test_should_be(tcp_header->sport(), uint16_t(5000));
+    test_should_be(tcp_header->dport(), uint16_t(80));
+    test_should_be(tcp_header->seqno() == WrappingInt32(0xdeadbeef), true);
+    test_should_be(tcp_header->syn(), true);
+    test_should_be(tcp_header->ack(), false);
+    test_should_be(tcp_header->win(), uint16_t(4321));
+    test_should_be(tcp_header->payload() == "hello", true);
+
+    // too short, or not IPv4
+    test_should_be(IPv4HeaderView::from(string_view(raw).substr(0, 19)).has_value(), false);
+    test_should_be(TCPHeaderView::from(ip_header->payload().substr(0, 19)).has_value(), false);
+    string ipv6 = raw;
+    ipv6[0] = 0x65;
+    test_should_be(IPv4HeaderView::from(ipv6).has_value(), false);
+}
+
+int main() {
+    try {
+        test_fields();
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
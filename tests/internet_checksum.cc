@@ -0,0 +1,202 @@
+#include "address.hh"
+#include "byte_stream.hh"
+#include "ipv4_datagram.hh"
+#include "test_should_be.hh"
+#include "util.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//! The checksum one byte at a time, as the RFC 1071 definition reads
+static uint16_t reference_checksum(const uint32_t initial_sum, const string &data) {
+    uint64_t sum = initial_sum;
+    for (size_t i = 0; i < data.size(); i++) {
+        sum += i % 2 ? uint8_t(data[i]) : uint8_t(data[i]) << 8;
+    }
+    while (sum > 0xffff) {
+        sum = (sum >> 16) + (sum & 0xffff);
+    }
+    return ~sum;
+}
+
+static vector<InternetChecksum::Kernel> supported_kernels() {
+    vector<InternetChecksum::Kernel> ret;
+    for (const auto kernel :
+         {InternetChecksum::Kernel::Scalar, InternetChecksum::Kernel::SSE2, InternetChecksum::Kernel::AVX2}) {
+        if (InternetChecksum::supported(kernel)) {
+            ret.push_back(kernel);
+        }
+    }
+    return ret;
+}
+
+//! Every kernel agrees with the reference, whatever the length, alignment and split of the data
+static void test_kernels(mt19937 &rd) {
+    const vector<InternetChecksum::Kernel> kernels = supported_kernels();
+    string storage(4096 + 64, 0);
+    for (auto &ch : storage) {
+        ch = rd();
+    }
+
+    for (size_t len = 0; len < 300; len++) {
+        for (size_t misalignment = 0; misalignment < 4; misalignment++) {
+            const string data = storage.substr(misalignment, len);
+            const uint32_t initial_sum = rd();
+            const uint16_t expected = reference_checksum(initial_sum, data);
+            const size_t split = len ? rd() % len : 0;
+
+            for (const auto kernel : kernels) {
+                InternetChecksum whole(initial_sum, kernel);
+                whole.add(data);
+                test_should_be(whole.value(), expected);
+
+                InternetChecksum in_pieces(initial_sum, kernel);
+                in_pieces.add(string_view(data).substr(0, split));
+                in_pieces.add(string_view(data).substr(split));
+                test_should_be(in_pieces.value(), expected);
+
+                // an empty piece between two others changes nothing, even after an odd number of bytes
+                InternetChecksum with_empty(initial_sum, kernel);
+                with_empty.add(string_view(data).substr(0, split));
+                with_empty.add("");
+                with_empty.add(string_view(data).substr(split));
+                test_should_be(with_empty.value(), expected);
+            }
+        }
+    }
+
+    InternetChecksum odd_then_empty;
+    odd_then_empty.add("a");
+    odd_then_empty.add("");
+    odd_then_empty.add("b");
+    test_should_be(odd_then_empty.value(), reference_checksum(0, "ab"));
+
+    // long enough for every lane of every kernel to carry
+    const string ones(1 << 20, char(0xff));
+    for (const auto kernel : kernels) {
+        InternetChecksum check(0, kernel);
+        check.add(ones);
+        test_should_be(check.value(), reference_checksum(0, ones));
+    }
+}
+
+//! Copying while summing gives the same copy and checksum, and a known sum can stand in for its bytes
+static void test_copy_and_known_sums(mt19937 &rd) {
+    for (size_t i = 0; i < 1000; i++) {
+        string data(rd() % 2000, 0);
+        for (auto &ch : data) {
+            ch = rd();
+        }
+        const string prefix(rd() % 3, 'p');
+        const uint16_t expected = reference_checksum(0, prefix + data);
+
+        for (const auto kernel : supported_kernels()) {
+            InternetChecksum fused(0, kernel);
+            fused.add(prefix);
+            string copy(data.size(), 0);
+            fused.add_copy(copy.data(), data);
+            test_should_be(copy == data, true);
+            test_should_be(fused.value(), expected);
+
+            // an empty copy (e.g. the second part of a read that doesn't wrap) changes nothing
+            InternetChecksum with_empty(0, kernel);
+            with_empty.add(prefix);
+            with_empty.add_copy(copy.data(), "");
+            with_empty.add_copy(copy.data(), data);
+            with_empty.add_copy(copy.data() + data.size(), "");
+            test_should_be(with_empty.value(), expected);
+
+            InternetChecksum data_only(0, kernel);
+            data_only.add(data);
+            InternetChecksum from_sum(0, kernel);
+            from_sum.add(prefix);
+            from_sum.add_sum(~data_only.value(), data.size());
+            from_sum.add("x");
+            test_should_be(from_sum.value(), reference_checksum(0, prefix + data + "x"));
+        }
+    }
+
+    // a ByteStream sums what it reads, even across the end of its ring buffer
+    ByteStream stream(1000);
+    for (size_t i = 0; i < 100; i++) {
+        string data(rd() % 700, 0);
+        for (auto &ch : data) {
+            ch = rd();
+        }
+        data.resize(stream.write(data));
+        const Buffer read = stream.read_checksummed(data.size());
+        test_should_be(read.str() == data, true);
+        test_should_be(read.cksum_partial().has_value(), true);
+        test_should_be(uint16_t(~read.cksum_partial().value()), reference_checksum(0, data));
+    }
+}
+
+//! Patching a checksum gives what summing the changed data again gives
+static void test_incremental_update(mt19937 &rd) {
+    for (size_t i = 0; i < 10000; i++) {
+        string data(20, 0);
+        for (auto &ch : data) {
+            ch = rd();
+        }
+        const uint16_t cksum = reference_checksum(0, data);
+
+        // change the 16-bit word at offset 8
+        const uint16_t old_word = uint8_t(data[8]) << 8 | uint8_t(data[9]);
+        const uint16_t new_word = i == 0 ? 0 : rd();
+        data[8] = char(new_word >> 8);
+        data[9] = char(new_word & 0xff);
+        const uint16_t patched = InternetChecksum::update_u16(cksum, old_word, new_word);
+        test_should_be(patched, reference_checksum(0, data));
+
+        // and the 32-bit field at offset 12
+        const uint32_t old_field = uint32_t(uint8_t(data[12])) << 24 | uint8_t(data[13]) << 16 |
+                                   uint8_t(data[14]) << 8 | uint8_t(data[15]);
+        const uint32_t new_field = rd();
+        for (size_t j = 0; j < 4; j++) {
+            data[12 + j] = char(new_field >> (24 - 8 * j));
+        }
+        test_should_be(InternetChecksum::update_u32(patched, old_field, new_field), reference_checksum(0, data));
+    }
+}
+
+//! A datagram whose TTL is decremented serializes with the checksum a recomputation would give
+static void test_decrement_ttl() {
+    InternetDatagram original;
+    original.header().ttl = 64;
+    original.header().src = Address("10.0.0.1").ipv4_numeric();
+    original.header().dst = Address("192.168.0.7").ipv4_numeric();
+    original.header().len = original.header().hlen * 4 + 5;
+    original.payload() = string("hello");
+
+    InternetDatagram forwarded;
+    test_should_be(forwarded.parse(original.serialize().concatenate()) == ParseResult::NoError, true);
+    forwarded.decrement_ttl();
+    const string patched = forwarded.serialize().concatenate();
+
+    original.header().ttl = 63;
+    test_should_be(patched == original.serialize().concatenate(), true);
+
+    InternetDatagram reparsed;
+    test_should_be(reparsed.parse(string(patched)) == ParseResult::NoError, true);
+    test_should_be(reparsed.header().ttl, uint8_t(63));
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        test_kernels(rd);
+        test_copy_and_known_sums(rd);
+        test_incremental_update(rd);
+        test_decrement_ttl();
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,81 @@
+#include "mpsc_ring.hh"
+#include "test_should_be.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+static void test_single_thread() {
+    MPSCRing<int> ring{3};
+    test_should_be(ring.capacity(), size_t(4));
+    test_should_be(ring.pop().has_value(), false);
+
+    for (int i = 0; i < 4; i++) {
+        test_should_be(ring.push(int(i)), true);
+    }
+    test_should_be(ring.push(4), false);
+
+    // around the ring a few times, in order
+    for (int i = 0; i < 20; i++) {
+        test_should_be(ring.pop() == i, true);
+        test_should_be(ring.push(i + 4), true);
+    }
+    for (int i = 20; i < 24; i++) {
+        test_should_be(ring.pop() == i, true);
+    }
+    test_should_be(ring.pop().has_value(), false);
+}
+
+//! Every element pushed by several producers comes out exactly once, each producer's in order
+static void test_producers() {
+    constexpr unsigned PRODUCERS = 4;
+    constexpr unsigned PER_PRODUCER = 100'000;
+    MPSCRing<pair<unsigned, unsigned>> ring{64};
+
+    vector<thread> producers;
+    for (unsigned p = 0; p < PRODUCERS; p++) {
+        producers.emplace_back([&ring, p] {
+            for (unsigned i = 0; i < PER_PRODUCER; i++) {
+                while (not ring.push({p, i})) {
+                    this_thread::yield();
+                }
+            }
+        });
+    }
+
+    vector<unsigned> next(PRODUCERS, 0);
+    for (unsigned received = 0; received < PRODUCERS * PER_PRODUCER;) {
+        const auto value = ring.pop();
+        if (not value) {
+            this_thread::yield();
+            continue;
+        }
+        if (value->second != next[value->first]) {
+            throw runtime_error("MPSCRing delivered " + to_string(value->second) + " from producer " +
+                                to_string(value->first) + ", expected " + to_string(next[value->first]));
+        }
+        next[value->first]++;
+        received++;
+    }
+    for (auto &producer : producers) {
+        producer.join();
+    }
+    test_should_be(ring.pop().has_value(), false);
+}
+
+int main() {
+    try {
+        test_single_thread();
+        test_producers();
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
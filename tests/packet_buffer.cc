@@ -0,0 +1,97 @@
+#include "arp_message.hh"
+#include "ethernet_frame.hh"
+#include "ipv4_datagram.hh"
+#include "packet_buffer.hh"
+#include "tcp_segment.hh"
+#include "test_should_be.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+//! Headers prepended into the headroom make the same bytes as serializing each layer into a BufferList
+static void test_same_as_bufferlist(const bool checksum_offload) {
+    TCPSegment seg;
+    seg.header().sport = 1234;
+    seg.header().dport = 80;
+    seg.header().seqno = WrappingInt32(0x01020304);
+    seg.header().ack = true;
+    seg.header().win = 1000;
+    seg.payload() = Buffer{string(1001, 'p')};
+
+    IPv4Datagram dgram;
+    dgram.header().src = 0x0a000001;
+    dgram.header().dst = 0x0a000002;
+    dgram.header().len = IPv4Header::LENGTH + TCPHeader::LENGTH + seg.payload().size();
+    dgram.payload() = checksum_offload ? seg.serialize_for_checksum_offload(dgram.header().pseudo_cksum())
+                                       : seg.serialize(dgram.header().pseudo_cksum());
+
+    EthernetFrame frame;
+    frame.header() = {{1, 2, 3, 4, 5, 6}, {7, 8, 9, 10, 11, 12}, EthernetHeader::TYPE_IPv4};
+    frame.payload() = dgram.serialize();
+
+    PacketBuffer packet{EthernetHeader::LENGTH + IPv4Header::LENGTH + TCPHeader::LENGTH, seg.payload()};
+    seg.serialize_into(packet, dgram.header().pseudo_cksum(), checksum_offload);
+    dgram.serialize_into(packet);
+    frame.serialize_into(packet);
+
+    test_should_be(packet.headroom(), size_t(0));
+    test_should_be(packet.str() == frame.serialize().concatenate(), true);
+
+    if (not checksum_offload) {
+        IPv4Datagram parsed_dgram;
+        test_should_be(parsed_dgram.parse(string(packet.str().substr(EthernetHeader::LENGTH))) == ParseResult::NoError,
+                       true);
+        TCPSegment parsed_seg;
+        test_should_be(parsed_seg.parse(parsed_dgram.payload().concatenate(), parsed_dgram.header().pseudo_cksum()) ==
+                           ParseResult::NoError,
+                       true);
+    }
+}
+
+//! The in-place ARP serializer matches the parser
+static void test_arp() {
+    ARPMessage arp;
+    arp.opcode = ARPMessage::OPCODE_REQUEST;
+    arp.sender_ethernet_address = {1, 2, 3, 4, 5, 6};
+    arp.sender_ip_address = 0x0a000001;
+    arp.target_ip_address = 0x0a000002;
+
+    ARPMessage parsed;
+    test_should_be(parsed.parse(arp.serialize()) == ParseResult::NoError, true);
+    test_should_be(parsed.sender_ethernet_address == arp.sender_ethernet_address, true);
+    test_should_be(parsed.target_ip_address, arp.target_ip_address);
+}
+
+//! Prepending more than the headroom is an error
+static void test_headroom() {
+    PacketBuffer packet{4, BufferList{string("payload")}};
+    test_should_be(packet.str() == "payload", true);
+    packet.prepend(3);
+    test_should_be(packet.size(), size_t(10));
+
+    bool threw = false;
+    try {
+        packet.prepend(2);
+    } catch (const runtime_error &) {
+        threw = true;
+    }
+    test_should_be(threw, true);
+}
+
+int main() {
+    try {
+        test_same_as_bufferlist(false);
+        test_same_as_bufferlist(true);
+        test_arp();
+        test_headroom();
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,85 @@
+#include "buffer.hh"
+#include "packet_pool.hh"
+#include "test_should_be.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+//! Freed blocks are reused by later allocations of the same size class
+static void test_reuse() {
+    const auto before = PacketPool::stats();
+    void *block = PacketPool::allocate(100);
+    PacketPool::deallocate(block, 100);
+    void *again = PacketPool::allocate(120);  // same size class (128 bytes)
+    test_should_be(again == block, true);
+    PacketPool::deallocate(again, 120);
+
+    void *large = PacketPool::allocate(PacketPool::SIZE_CLASSES.back() + 1);
+    PacketPool::deallocate(large, PacketPool::SIZE_CLASSES.back() + 1);
+
+    const auto after = PacketPool::stats();
+    test_should_be(after.allocations - before.allocations, uint64_t(3));
+    test_should_be(after.reuses - before.reuses, uint64_t(1));
+    test_should_be(after.oversized - before.oversized, uint64_t(1));
+    test_should_be(after.deallocations - before.deallocations, uint64_t(3));
+}
+
+//! Copies of a Buffer share one pooled string, which is freed with the last copy
+static void test_buffer_sharing() {
+    const auto before = PacketPool::stats();
+    {
+        Buffer original{string(2000, 'x')};
+        Buffer copy = original;
+        Buffer moved = move(original);
+        test_should_be(copy.str().data() == moved.str().data(), true);
+        test_should_be(original.size(), size_t(0));
+
+        copy.remove_prefix(2000);  // drops copy's reference
+        test_should_be(moved.size(), size_t(2000));
+
+        BufferList list{moved};
+        list.append(BufferList{string("tail")});
+        test_should_be(list.concatenate() == string(2000, 'x') + "tail", true);
+    }
+    const auto after = PacketPool::stats();
+    test_should_be(after.allocations - before.allocations, after.deallocations - before.deallocations);
+}
+
+//! A block freed on another thread is kept (and reused) by that thread
+static void test_cross_thread() {
+    void *block = nullptr;
+    thread other([&] { block = PacketPool::allocate(64); });
+    other.join();
+
+    PacketPool::deallocate(block, 64);
+    void *again = PacketPool::allocate(64);
+    test_should_be(again == block, true);
+    PacketPool::deallocate(again, 64);
+}
+
+static void test_allocator() {
+    vector<int, PoolAllocator<int>> numbers;
+    for (int i = 0; i < 1000; i++) {
+        numbers.push_back(i);
+    }
+    test_should_be(numbers.at(999), 999);
+}
+
+int main() {
+    try {
+        test_reuse();
+        test_buffer_sharing();
+        test_cross_thread();
+        test_allocator();
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
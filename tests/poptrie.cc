@@ -0,0 +1,92 @@
+#include "linear_prefix_table.hh"
+#include "poptrie.hh"
+#include "test_should_be.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+//! An address in or near `prefix`: it keeps a random number of the prefix's high-order bits
+static uint32_t address_near(mt19937 &rng, const uint32_t prefix) {
+    const unsigned kept = rng() % 33;
+    const uint32_t random_bits = kept == 32 ? 0 : rng() >> kept;
+    return prefix ^ random_bits;
+}
+
+//! Tables of prefixes clustered around a few addresses (so that they nest and overlap), of every
+//! length, give the same answers as the linear scan
+static void test_against_linear(mt19937 &rng) {
+    for (unsigned round = 0; round < 200; round++) {
+        Poptrie poptrie;
+        LinearPrefixTable linear;
+        vector<uint32_t> prefixes;
+
+        const uint32_t cluster = rng();
+        const unsigned count = rng() % 400;
+        for (unsigned i = 0; i < count; i++) {
+            const uint32_t prefix = address_near(rng, cluster);
+            const uint8_t length = rng() % 33;
+            poptrie.insert(prefix, length, i);
+            linear.insert(prefix, length, i);
+            prefixes.push_back(prefix);
+        }
+        poptrie.build();
+        test_should_be(poptrie.stale(), false);
+
+        // looked up one at a time, and in batches (the last of them partial)
+        vector<uint32_t> addresses;
+        for (unsigned i = 0; i < 5003; i++) {
+            const uint32_t address = prefixes.empty() ? rng() : address_near(rng, prefixes[rng() % prefixes.size()]);
+            test_should_be(poptrie.lookup(address) == linear.lookup(address), true);
+            addresses.push_back(address);
+        }
+        vector<optional<uint32_t>> values(addresses.size());
+        poptrie.lookup(addresses.data(), values.data(), addresses.size());
+        for (size_t i = 0; i < addresses.size(); i++) {
+            test_should_be(values[i] == linear.lookup(addresses[i]), true);
+        }
+    }
+}
+
+static void test_basics() {
+    Poptrie poptrie;
+    test_should_be(poptrie.lookup(0x0a000001).has_value(), false);
+
+    poptrie.insert(0x0a000000, 8, 1);   // 10.0.0.0/8
+    poptrie.insert(0x0a010000, 16, 2);  // 10.1.0.0/16
+    poptrie.insert(0x0a010203, 32, 3);  // 10.1.2.3/32
+    poptrie.insert(0x0a0102ff, 24, 4);  // 10.1.2.0/24 (with host bits set, which are ignored)
+    poptrie.insert(0x0a010200, 24, 5);  // 10.1.2.0/24 again: the first value stays
+    test_should_be(poptrie.stale(), true);
+    test_should_be(poptrie.lookup(0x0a000001).has_value(), false);
+
+    poptrie.build();
+    test_should_be(poptrie.size(), size_t(4));
+    test_should_be(poptrie.lookup(0x0a000001) == 1u, true);
+    test_should_be(poptrie.lookup(0x0a01ffff) == 2u, true);
+    test_should_be(poptrie.lookup(0x0a010203) == 3u, true);
+    test_should_be(poptrie.lookup(0x0a010204) == 4u, true);
+    test_should_be(poptrie.lookup(0x0b000000).has_value(), false);
+
+    poptrie.insert(0, 0, 6);  // default route
+    poptrie.build();
+    test_should_be(poptrie.lookup(0x0b000000) == 6u, true);
+    test_should_be(poptrie.lookup(0x0a010204) == 4u, true);
+}
+
+int main() {
+    try {
+        mt19937 rng(0x5eed);
+        test_basics();
+        test_against_linear(rng);
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,95 @@
+#include "resilient_hash_table.hh"
+#include "test_should_be.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+constexpr size_t NEW = ResilientHashTable::NEW;
+
+//! Number of buckets whose member is different in `a` and `b`, with `b`'s members numbered as in `a`
+static size_t moved(const ResilientHashTable &a, const ResilientHashTable &b, const vector<size_t> &previous) {
+    size_t count = 0;
+    for (uint64_t bucket = 0; bucket < ResilientHashTable::BUCKETS; bucket++) {
+        count += previous[b.select(bucket)] != a.select(bucket);
+    }
+    return count;
+}
+
+static void test_shares() {
+    const ResilientHashTable even({1, 1});
+    test_should_be(even.members(), size_t(2));
+    test_should_be(even.buckets_of(0), size_t(128));
+    test_should_be(even.buckets_of(1), size_t(128));
+    // interleaved, so that consecutive hashes alternate
+    test_should_be(even.select(0) != even.select(1), true);
+
+    const ResilientHashTable weighted({3, 1});
+    test_should_be(weighted.buckets_of(0), size_t(192));
+    test_should_be(weighted.buckets_of(1), size_t(64));
+
+    // shares that don't divide evenly round to the largest remainders
+    const ResilientHashTable thirds({1, 1, 1});
+    test_should_be(thirds.buckets_of(0), size_t(86));
+    test_should_be(thirds.buckets_of(1), size_t(85));
+    test_should_be(thirds.buckets_of(2), size_t(85));
+
+    // the hash wraps around the buckets
+    test_should_be(thirds.select(5) == thirds.select(5 + ResilientHashTable::BUCKETS), true);
+
+    bool threw = false;
+    try {
+        ResilientHashTable({1, 0});
+    } catch (const exception &) {
+        threw = true;
+    }
+    test_should_be(threw, true);
+}
+
+static void test_resilience() {
+    const ResilientHashTable three({1, 1, 1});
+
+    // removing a member moves only its buckets
+    const ResilientHashTable two(three, {1, 1}, {0, 2});
+    test_should_be(two.buckets_of(0), size_t(128));
+    test_should_be(two.buckets_of(1), size_t(128));
+    test_should_be(moved(three, two, {0, 2}), three.buckets_of(1));
+
+    // adding one back takes only its share
+    const ResilientHashTable again(two, {1, 1, 1}, {0, 1, NEW});
+    test_should_be(again.buckets_of(2), size_t(85));
+    size_t taken = 0;
+    for (uint64_t bucket = 0; bucket < ResilientHashTable::BUCKETS; bucket++) {
+        if (again.select(bucket) != 2) {
+            test_should_be(again.select(bucket), two.select(bucket));
+        } else {
+            taken++;
+        }
+    }
+    test_should_be(taken, size_t(85));
+
+    // reweighting 1:1 to 3:1 moves only the buckets the second member gives up
+    const ResilientHashTable even({1, 1});
+    const ResilientHashTable weighted(even, {3, 1}, {0, 1});
+    test_should_be(weighted.buckets_of(0), size_t(192));
+    test_should_be(moved(even, weighted, {0, 1}), size_t(64));
+
+    // reordering the members moves nothing
+    const ResilientHashTable swapped(even, {1, 1}, {1, 0});
+    test_should_be(moved(even, swapped, {1, 0}), size_t(0));
+}
+
+int main() {
+    try {
+        test_shares();
+        test_resilience();
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,337 @@
+#include "arp_message.hh"
+#include "ethernet_frame.hh"
+#include "ipv4_datagram.hh"
+#include "rcu_snapshot.hh"
+#include "router.hh"
+#include "test_should_be.hh"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+//! A snapshot whose words all hold the same number; freeing it scribbles over them first, so a
+//! reader still using it after it is freed would (very likely) see them disagree
+struct Poisoned {
+    vector<uint64_t> words;
+    explicit Poisoned(const uint64_t value) : words(64, value) {}
+    ~Poisoned() {
+        for (size_t i = 0; i < words.size(); i++) {
+            volatile uint64_t *word = &words[i];  // not a dead store to the optimizer
+            *word = i;
+        }
+    }
+};
+
+static void test_snapshot_basics() {
+    RcuSnapshot<Poisoned> rcu{make_unique<Poisoned>(1)};
+    test_should_be(rcu.read()->words[0], uint64_t(1));
+
+    {
+        const auto guard = rcu.read();
+        rcu.publish(make_unique<Poisoned>(2));
+        // the reader keeps the snapshot it started with, so the writer can't free it yet
+        test_should_be(guard->words[0], uint64_t(1));
+        test_should_be(rcu.read()->words[0], uint64_t(2));
+        test_should_be(rcu.retired(), size_t(1));
+        test_should_be(rcu.reclaim(), size_t(1));
+    }
+    test_should_be(rcu.reclaim(), size_t(0));
+
+    // with no readers, publish() frees the replaced snapshot at once
+    rcu.publish(make_unique<Poisoned>(3));
+    test_should_be(rcu.retired(), size_t(0));
+    test_should_be(rcu.writer_view().words[0], uint64_t(3));
+}
+
+//! The writer gets back the newest replaced snapshot, but only once no reader can still see it
+static void test_snapshot_recycle() {
+    RcuSnapshot<Poisoned> rcu{make_unique<Poisoned>(1)};
+    test_should_be(rcu.recycle() == nullptr, true);  // nothing replaced yet
+
+    {
+        const auto guard = rcu.read();
+        rcu.publish(make_unique<Poisoned>(2));
+        test_should_be(rcu.recycle() == nullptr, true);
+        test_should_be(guard->words[0], uint64_t(1));
+    }
+    rcu.publish(make_unique<Poisoned>(3));
+    unique_ptr<Poisoned> spare = rcu.recycle();
+    test_should_be(spare != nullptr, true);
+    test_should_be(spare->words[0], uint64_t(2));  // the newest; the oldest was freed
+    test_should_be(rcu.recycle() == nullptr, true);
+    test_should_be(rcu.retired(), size_t(0));
+
+    spare->words.assign(64, 4);
+    rcu.publish(move(spare));
+    test_should_be(rcu.read()->words[0], uint64_t(4));
+}
+
+//! Readers in other threads never see a snapshot torn or freed under them, or go back in time
+static void test_snapshot_stress() {
+    RcuSnapshot<Poisoned> rcu{make_unique<Poisoned>(1)};
+    atomic<bool> done{false};
+    atomic<uint64_t> reads{0};
+    atomic<bool> failed{false};
+
+    vector<thread> readers;
+    for (unsigned r = 0; r < 3; r++) {
+        readers.emplace_back([&] {
+            uint64_t last = 0;
+            while (not done.load()) {
+                const auto guard = rcu.read();
+                const uint64_t value = guard->words.front();
+                for (const auto word : guard->words) {
+                    failed = failed or word != value;
+                }
+                failed = failed or value < last;
+                last = value;
+                reads++;
+            }
+        });
+    }
+
+    const auto start = steady_clock::now();
+    uint64_t value = 1;
+    while (steady_clock::now() - start < milliseconds(300)) {
+        rcu.publish(make_unique<Poisoned>(++value));
+        this_thread::yield();
+    }
+    done = true;
+    for (auto &reader : readers) {
+        reader.join();
+    }
+
+    test_should_be(failed.load(), false);
+    test_should_be(rcu.reclaim(), size_t(0));
+    cerr << "RcuSnapshot: " << value << " snapshots published under " << reads.load() << " reads\n";
+}
+
+static uint32_t ip(const string &address) { return Address(address).ipv4_numeric(); }
+
+//! Teach a router interface the Ethernet address of a neighbor, with an ARP reply from it
+static void learn_neighbor(AsyncNetworkInterface &interface,
+                           const EthernetAddress &interface_ethernet_address,
+                           const string &interface_ip,
+                           const EthernetAddress &neighbor_ethernet_address,
+                           const string &neighbor_ip) {
+    ARPMessage arp;
+    arp.opcode = ARPMessage::OPCODE_REPLY;
+    arp.sender_ethernet_address = neighbor_ethernet_address;
+    arp.sender_ip_address = ip(neighbor_ip);
+    arp.target_ethernet_address = interface_ethernet_address;
+    arp.target_ip_address = ip(interface_ip);
+
+    EthernetFrame frame;
+    frame.header() = {interface_ethernet_address, neighbor_ethernet_address, EthernetHeader::TYPE_ARP};
+    frame.payload() = arp.serialize();
+    interface.recv_frame(frame);
+}
+
+//! The destinations of the datagrams an interface has sent (emptying its queue)
+static vector<uint32_t> sent_destinations(AsyncNetworkInterface &interface) {
+    vector<uint32_t> destinations;
+    auto &frames = interface.frames_out();
+    for (; not frames.empty(); frames.pop()) {
+        InternetDatagram dgram;
+        if (frames.front().header().type != EthernetHeader::TYPE_IPv4 or
+            dgram.parse(frames.front().payload().concatenate()) != ParseResult::NoError) {
+            throw runtime_error("router sent something other than a valid IPv4 datagram");
+        }
+        destinations.push_back(dgram.header().dst);
+    }
+    return destinations;
+}
+
+//! \details One thread forwards datagrams while another adds and removes about 10,000 routes a
+//! second. A route that never changes must route every datagram it covers the whole time, a
+//! datagram must never be lost, and at the end the routes must be exactly what the writer left.
+static void test_router_under_churn() {
+    constexpr uint32_t STABLE = 0xc0a8'0000;  // 192.168.0.0/16, always via interface 1
+    constexpr uint32_t CHURNED = 0xac10'0000;  // 172.16.k.0/24, added and removed via interface 1
+    constexpr unsigned CHURNED_PREFIXES = 256;
+    constexpr size_t CHANGES_PER_BATCH = 10;
+    const auto change_interval = microseconds(100);  // 10k changes/s
+    const auto run_time = milliseconds(1000);
+
+    const EthernetAddress eth0{2, 0, 0, 0, 0, 1}, eth1{2, 0, 0, 0, 0, 2};
+    const EthernetAddress neighbor0{2, 0, 0, 0, 1, 1}, neighbor1{2, 0, 0, 0, 1, 2};
+
+    Router router;
+    const size_t if0 = router.add_interface({eth0, Address("10.0.0.1")});
+    const size_t if1 = router.add_interface({eth1, Address("10.1.0.1")});
+    learn_neighbor(router.interface(if0), eth0, "10.0.0.1", neighbor0, "10.0.0.2");
+    learn_neighbor(router.interface(if1), eth1, "10.1.0.1", neighbor1, "10.1.0.2");
+    router.update_routes({{true, 0, 0, Address("10.0.0.2"), if0}, {true, STABLE, 16, Address("10.1.0.2"), if1}});
+
+    vector<bool> present(CHURNED_PREFIXES);
+    size_t changes = 0;
+    atomic<bool> done{false};
+    thread writer([&] {
+        mt19937 rng(0xc0ffee);
+        const auto start = steady_clock::now();
+        while (steady_clock::now() - start < run_time) {
+            vector<Router::RouteChange> batch;
+            for (size_t i = 0; i < CHANGES_PER_BATCH; i++) {
+                const unsigned k = rng() % CHURNED_PREFIXES;
+                batch.push_back({not present[k], CHURNED | k << 8, 24, Address("10.1.0.2"), if1});
+                present[k] = not present[k];
+            }
+            router.update_routes(batch);
+            changes += batch.size();
+            this_thread::sleep_until(start + changes * change_interval);
+        }
+        done = true;
+    });
+
+    // forward until the writer stops, checking where each datagram went
+    mt19937 rng(0xbeef);
+    size_t stable_sent = 0, stable_received = 0, sent = 0, received = 0, misrouted = 0;
+    const auto start = steady_clock::now();
+    while (not done.load()) {
+        for (unsigned i = 0; i < 32; i++) {
+            InternetDatagram dgram;
+            switch (rng() % 3) {
+                case 0:
+                    dgram.header().dst = STABLE | (rng() & 0xffff);
+                    stable_sent++;
+                    break;
+                case 1:
+                    dgram.header().dst = CHURNED | (rng() % CHURNED_PREFIXES) << 8 | 1;
+                    break;
+                default:
+                    dgram.header().dst = ip("8.8.8.8");
+            }
+            dgram.header().src = ip("10.0.0.2");
+            dgram.header().len = dgram.header().hlen * 4;
+            router.interface(if0).datagrams_out().push(move(dgram));
+            sent++;
+        }
+        router.route();
+
+        // (checked once the writer has stopped)
+        for (const auto dst : sent_destinations(router.interface(if0))) {
+            misrouted += (dst & 0xffff'0000) == STABLE;
+            received++;
+        }
+        for (const auto dst : sent_destinations(router.interface(if1))) {
+            misrouted += (dst & 0xffff'0000) != STABLE and (dst & 0xffff'0000) != CHURNED;
+            stable_received += (dst & 0xffff'0000) == STABLE;
+            received++;
+        }
+    }
+    const auto elapsed = duration_cast<duration<double>>(steady_clock::now() - start).count();
+    writer.join();
+
+    test_should_be(misrouted, size_t(0));
+    test_should_be(received, sent);
+    test_should_be(stable_received, stable_sent);
+    cerr << "Router: " << sent << " datagrams forwarded during " << changes << " route changes ("
+         << size_t(changes / elapsed) << " changes/s)\n";
+
+    // nothing is left waiting for a reader, and the routes are the writer's last ones
+    router.update_routes({});
+    test_should_be(router.retired_route_tables(), size_t(0));
+    for (unsigned k = 0; k < CHURNED_PREFIXES; k++) {
+        InternetDatagram dgram;
+        dgram.header().dst = CHURNED | k << 8 | 1;
+        dgram.header().len = dgram.header().hlen * 4;
+        router.interface(if0).datagrams_out().push(move(dgram));
+        router.route();
+        test_should_be(sent_destinations(router.interface(present[k] ? if1 : if0)).size(), size_t(1));
+        test_should_be(sent_destinations(router.interface(present[k] ? if0 : if1)).size(), size_t(0));
+    }
+
+    // removing a route lets the shorter ones that it hid take over
+    router.remove_route(STABLE, 16);
+    router.interface(if0).datagrams_out().push([&] {
+        InternetDatagram dgram;
+        dgram.header().dst = STABLE | 1;
+        dgram.header().len = dgram.header().hlen * 4;
+        return dgram;
+    }());
+    router.route();
+    test_should_be(sent_destinations(router.interface(if0)).size(), size_t(1));
+}
+
+//! \details One thread forwards datagrams while another loads 2,000 routes into a DIR-24-8 router one
+//! at a time. Each load changes the previous table that route() has finished with instead of copying
+//! the 64 MiB lookup table, so it takes well under a millisecond, not tens of them; every datagram goes
+//! by a route loaded before it, and at the end every route is in effect.
+static void test_dir_24_8_loaded_one_at_a_time() {
+    constexpr uint32_t LOADED = 0x0a80'0000;  // 10.128.k.0/24 (k < ROUTES), via interface 1
+    constexpr unsigned ROUTES = 2000;
+
+    const EthernetAddress eth0{2, 0, 0, 0, 0, 1}, eth1{2, 0, 0, 0, 0, 2};
+    Router router{Router::LPM::Dir24_8};
+    const size_t if0 = router.add_interface({eth0, Address("10.0.0.1")});
+    const size_t if1 = router.add_interface({eth1, Address("10.1.0.1")});
+    learn_neighbor(router.interface(if0), eth0, "10.0.0.1", {2, 0, 0, 0, 1, 1}, "10.0.0.2");
+    learn_neighbor(router.interface(if1), eth1, "10.1.0.1", {2, 0, 0, 0, 1, 2}, "10.1.0.2");
+    router.update_routes({{true, 0, 0, Address("10.0.0.2"), if0}});
+
+    atomic<unsigned> loaded{0};
+    thread writer([&] {
+        for (unsigned k = 0; k < ROUTES; k++) {
+            router.update_routes({{true, LOADED + (k << 8), 24, Address("10.1.0.2"), if1}});
+            loaded = k + 1;
+        }
+    });
+
+    // a destination in a route loaded before the datagram was sent must go out interface 1
+    mt19937 rng(0x10ad);
+    size_t sent = 0, misrouted = 0;
+    const auto start = steady_clock::now();
+    while (loaded.load() < ROUTES) {
+        const unsigned k = rng() % ROUTES;
+        const bool was_loaded = k < loaded.load();
+        InternetDatagram dgram;
+        dgram.header().dst = LOADED + (k << 8) + 1;
+        dgram.header().len = dgram.header().hlen * 4;
+        router.interface(if0).datagrams_out().push(move(dgram));
+        router.route();
+        sent++;
+        misrouted += was_loaded and sent_destinations(router.interface(if1)).size() != 1;
+        sent_destinations(router.interface(if0));
+        sent_destinations(router.interface(if1));
+    }
+    const auto elapsed = duration_cast<duration<double>>(steady_clock::now() - start).count();
+    writer.join();
+
+    test_should_be(misrouted, size_t(0));
+    for (unsigned k = 0; k < ROUTES; k++) {
+        InternetDatagram dgram;
+        dgram.header().dst = LOADED + (k << 8) + 1;
+        dgram.header().len = dgram.header().hlen * 4;
+        router.interface(if0).datagrams_out().push(move(dgram));
+    }
+    router.route();
+    test_should_be(sent_destinations(router.interface(if1)).size(), size_t(ROUTES));
+    test_should_be(sent_destinations(router.interface(if0)).size(), size_t(0));
+    cerr << "Router: " << ROUTES << " routes loaded one at a time into DIR-24-8 in " << elapsed * 1000 << " ms ("
+         << sent << " datagrams forwarded meanwhile)\n";
+}
+
+int main() {
+    try {
+        test_snapshot_basics();
+        test_snapshot_recycle();
+        test_snapshot_stress();
+        test_router_under_churn();
+        test_dir_24_8_loaded_one_at_a_time();
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
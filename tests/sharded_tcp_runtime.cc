@@ -0,0 +1,178 @@
+#include "sharded_tcp_runtime.hh"
+#include "spsc_ring.hh"
+#include "test_should_be.hh"
+#include "toeplitz.hh"
+#include "util.hh"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+static uint32_t ip(const string &address) { return Address(address).ipv4_numeric(); }
+
+// verification suite from Microsoft's RSS specification (IPv4 with TCP ports)
+static void test_toeplitz() {
+    const ToeplitzHash hash;
+    test_should_be(hash.hash_ipv4_tcp(ip("66.9.149.187"), ip("161.142.100.80"), 2794, 1766), 0x51ccc178U);
+    test_should_be(hash.hash_ipv4_tcp(ip("199.92.111.2"), ip("65.69.140.83"), 14230, 4739), 0xc626b0eaU);
+    test_should_be(hash.hash_ipv4_tcp(ip("24.19.198.95"), ip("12.22.207.184"), 12898, 38024), 0x5c2b394aU);
+    test_should_be(hash.hash_ipv4_tcp(ip("38.27.205.30"), ip("209.142.163.6"), 48228, 2217), 0xafc7327fU);
+    test_should_be(hash.hash_ipv4_tcp(ip("153.39.163.191"), ip("202.188.127.2"), 44251, 1303), 0x10e828a2U);
+
+    // addresses only, through the generic interface
+    const string input{"\x42\x09\x95\xbb\xa1\x8e\x64\x50", 8};
+    test_should_be(hash(input), 0x323e8fc2U);
+}
+
+static void test_spsc_ring() {
+    SPSCRing<int> ring{3};
+    test_should_be(ring.capacity(), size_t{4});
+    for (int i = 0; i < 4; i++) {
+        test_should_be(ring.push(int{i}), true);
+    }
+    test_should_be(ring.push(4), false);
+    test_should_be(ring.pop().value_or(-1), 0);
+    test_should_be(ring.push(4), true);
+    for (int i = 1; i <= 4; i++) {
+        test_should_be(ring.pop().value_or(-1), i);
+    }
+    test_should_be(ring.pop().has_value(), false);
+
+    // one producer thread, one consumer thread: everything arrives, in order
+    constexpr int count = 200000;
+    SPSCRing<int> shared{64};
+    thread producer([&] {
+        for (int i = 0; i < count;) {
+            if (shared.push(int{i})) {
+                i++;
+            } else {
+                this_thread::yield();
+            }
+        }
+    });
+    int expected = 0;
+    while (expected < count) {
+        if (const auto value = shared.pop()) {
+            if (*value != expected) {
+                producer.join();
+                throw runtime_error("SPSCRing delivered " + to_string(*value) + ", expected " + to_string(expected));
+            }
+            expected++;
+        } else {
+            this_thread::yield();
+        }
+    }
+    producer.join();
+}
+
+static FourTuple reversed(const FourTuple &t) {
+    return {t.remote_address, t.remote_port, t.local_address, t.local_port};
+}
+
+// clients on one runtime connect to servers on another; check every connection works and stays on its shard
+static void test_runtime() {
+    constexpr size_t num_shards = 4;
+    constexpr size_t num_connections = 32;
+
+    ShardedRuntimeConfig cfg;
+    cfg.num_shards = num_shards;
+    cfg.num_producers = num_shards;
+
+    vector<FourTuple> client_tuples;
+    for (uint16_t i = 0; i < num_connections; i++) {
+        client_tuples.push_back({ip("10.0.0.2"), uint16_t(40000 + i), ip("10.0.0.1"), 80});
+    }
+
+    atomic<size_t> messages_received{0};
+    atomic<size_t> misplaced{0};
+    vector<char> clients_started(num_shards, false);
+
+    unique_ptr<ShardedTCPRuntime> servers, clients;
+
+    servers = make_unique<ShardedTCPRuntime>(
+        cfg,
+        [&](ShardedTCPRuntime::Shard &shard, const FourTuple &tuple, TCPSegment &&seg) {
+            clients->deliver(shard.index(), reversed(tuple), move(seg));
+        },
+        [&](ShardedTCPRuntime::Shard &shard) {
+            while (const auto tuple = shard.listener().accept()) {
+                if (servers->shard_for(*tuple) != shard.index()) {
+                    misplaced++;
+                }
+            }
+            for (const auto &client_tuple : client_tuples) {
+                const FourTuple tuple = reversed(client_tuple);
+                if (servers->shard_for(tuple) != shard.index()) {
+                    continue;
+                }
+                try {
+                    auto &connection = shard.listener().connection(tuple);
+                    const string expected = "hello from " + to_string(client_tuple.local_port);
+                    if (connection.inbound_stream().buffer_size() >= expected.size()) {
+                        if (connection.inbound_stream().read(expected.size()) == expected) {
+                            messages_received++;
+                        }
+                    }
+                } catch (const out_of_range &) {
+                    // not accepted yet
+                }
+            }
+        });
+
+    clients = make_unique<ShardedTCPRuntime>(
+        cfg,
+        [&](ShardedTCPRuntime::Shard &shard, const FourTuple &tuple, TCPSegment &&seg) {
+            servers->deliver(shard.index(), reversed(tuple), move(seg));
+        },
+        [&](ShardedTCPRuntime::Shard &shard) {
+            if (clients_started[shard.index()]) {
+                return;
+            }
+            clients_started[shard.index()] = true;
+            for (const auto &tuple : client_tuples) {
+                if (clients->shard_for(tuple) == shard.index()) {
+                    shard.listener().connect(tuple).write("hello from " + to_string(tuple.local_port));
+                }
+            }
+        });
+
+    servers->start();
+    clients->start();
+
+    const auto deadline = timestamp_ms() + 5000;
+    while (messages_received.load() < num_connections and timestamp_ms() < deadline) {
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    clients->stop();
+    servers->stop();
+
+    test_should_be(messages_received.load(), num_connections);
+    test_should_be(misplaced.load(), size_t{0});
+
+    size_t total_connections = 0;
+    for (size_t i = 0; i < num_shards; i++) {
+        total_connections += servers->shard(i).listener().connection_count();
+        test_should_be(servers->shard(i).ring_drops(), uint64_t{0});
+    }
+    test_should_be(total_connections, num_connections);
+}
+
+int main() {
+    try {
+        test_toeplitz();
+        test_spsc_ring();
+        test_runtime();
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,108 @@
+#include "shm_byte_ring.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+static void test_single_thread() {
+    ShmByteRing ring{100};
+    test_should_be(ring.space(), size_t{4096});
+    test_should_be(ring.size(), size_t{0});
+
+    test_should_be(ring.write("hello"), size_t{5});
+    test_should_be(ring.size(), size_t{5});
+
+    string data;
+    ring.read(data, 3);
+    test_should_be(data == "hel", true);
+    ring.read(data, 100);
+    test_should_be(data == "lo", true);
+    test_should_be(ring.eof(), false);
+
+    // a write that does not fit is cut short, and the bytes wrap around the end of the ring
+    const string big(5000, 'x');
+    test_should_be(ring.write(big), size_t{4096});
+    test_should_be(ring.space(), size_t{0});
+    test_should_be(ring.write("y"), size_t{0});
+    ring.read(data, 4000);
+    test_should_be(ring.write("abc"), size_t{3});
+    ring.read(data, 1000);
+    test_should_be(data == string(96, 'x') + "abc", true);
+
+    // EOF only once everything written before close() has been read
+    ring.write("end");
+    ring.close();
+    test_should_be(ring.eof(), false);
+    ring.wait_for_data();
+    ring.read(data, 10);
+    test_should_be(data == "end", true);
+    test_should_be(ring.eof(), true);
+
+    // the writer learns that the reader has gone away
+    ShmByteRing other{100};
+    test_should_be(other.reader_gone(), false);
+    other.close_reader();
+    test_should_be(other.reader_gone(), true);
+    other.wait_for_space();
+}
+
+// a writer thread and a reader thread, both sleeping on their doorbells when the ring is full or empty
+static void test_two_threads() {
+    constexpr size_t total = 8 * 1024 * 1024;
+    ShmByteRing ring{4096};
+
+    thread writer([&] {
+        string chunk;
+        for (size_t i = 0; i < 1500; i++) {
+            chunk.push_back(char(i % 251));
+        }
+        size_t written = 0;
+        while (written < total) {
+            const size_t offset = written % 251;
+            const size_t amount = min(total - written, chunk.size() - offset);
+            const size_t n = ring.write(string_view(chunk).substr(offset, amount));
+            written += n;
+            if (n == 0) {
+                ring.wait_for_space();
+            }
+        }
+        ring.close();
+    });
+
+    size_t received = 0;
+    string data;
+    while (true) {
+        ring.wait_for_data();
+        if (ring.eof()) {
+            break;
+        }
+        ring.read(data, 3000);
+        for (const char c : data) {
+            if (c != char(received % 251)) {
+                writer.join();
+                throw runtime_error("ShmByteRing corrupted byte " + to_string(received));
+            }
+            received++;
+        }
+    }
+    writer.join();
+    test_should_be(received, total);
+}
+
+int main() {
+    try {
+        test_single_thread();
+        test_two_threads();
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
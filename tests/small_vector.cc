@@ -0,0 +1,78 @@
+#include "buffer.hh"
+#include "ethernet_frame.hh"
+#include "ipv4_datagram.hh"
+#include "small_vector.hh"
+#include "tcp_segment.hh"
+#include "test_should_be.hh"
+
+#include <array>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+//! Elements stay inline up to the inline capacity, then move to a pooled block
+static void test_spill() {
+    SmallVector<string, 2> strings;
+    strings.push_back("a");
+    strings.emplace_back(3, 'b');
+    test_should_be(strings.is_inline(), true);
+
+    strings.push_back("c");
+    test_should_be(strings.is_inline(), false);
+    test_should_be(strings.size(), size_t(3));
+    test_should_be(strings[1] == "bbb", true);
+
+    strings.pop_front();
+    test_should_be(strings.front() == "bbb", true);
+    test_should_be(strings.back() == "c", true);
+
+    SmallVector<string, 2> copy = strings;
+    SmallVector<string, 2> moved = move(strings);
+    test_should_be(strings.empty(), true);
+    test_should_be(strings.is_inline(), true);
+    test_should_be(moved.size(), size_t(2));
+    test_should_be(copy[0] == moved[0], true);
+
+    SmallVector<string, 2> small{"x"};
+    SmallVector<string, 2> moved_small = move(small);
+    test_should_be(moved_small.is_inline(), true);
+    test_should_be(moved_small.front() == "x", true);
+}
+
+//! A TCP segment wrapped in an IPv4 datagram and an Ethernet frame needs no spill
+static void test_packet_stays_inline() {
+    TCPSegment seg;
+    seg.payload() = Buffer{string(100, 'p')};
+
+    IPv4Datagram dgram;
+    dgram.payload() = seg.serialize();
+    dgram.header().len = dgram.header().hlen * 4 + dgram.payload().size();
+    test_should_be(dgram.payload().buffers().is_inline(), true);
+
+    EthernetFrame frame;
+    frame.payload() = dgram.serialize();
+    const BufferList serialized = frame.serialize();
+    test_should_be(serialized.buffers().size(), size_t(4));
+    test_should_be(serialized.buffers().is_inline(), true);
+
+    // a caller-provided array gets as many slices as it has room for
+    array<iovec, 3> iovecs;
+    const BufferViewList views{serialized};
+    test_should_be(views.as_iovecs(iovecs.data(), iovecs.size()), size_t(3));
+    test_should_be(iovecs[2].iov_len, size_t(20));
+    test_should_be(views.as_iovecs().size(), size_t(4));
+}
+
+int main() {
+    try {
+        test_spill();
+        test_packet_stays_inline();
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,98 @@
+#include "ipv4_datagram.hh"
+#include "tcp_over_ip.hh"
+#include "tcp_segment.hh"
+#include "test_should_be.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+using Drop = TCPOverIPv4Adapter::Drop;
+
+//! A serialized TCP/IPv4 datagram from 10.0.0.2:`sport` to 10.0.0.1:`dport`
+static string make_datagram(const uint16_t sport, const uint16_t dport, const bool syn = false) {
+    TCPSegment seg;
+    seg.header().sport = sport;
+    seg.header().dport = dport;
+    seg.header().syn = syn;
+    seg.payload() = Buffer{string("hello")};
+
+    IPv4Datagram dgram;
+    dgram.header().src = 0x0a000002;
+    dgram.header().dst = 0x0a000001;
+    dgram.header().len = IPv4Header::LENGTH + TCPHeader::LENGTH + seg.payload().size();
+    dgram.payload() = seg.serialize(dgram.header().pseudo_cksum());
+    return dgram.serialize().concatenate();
+}
+
+//! Datagrams for other connections are dropped by the first stage, and counted by reason
+static void test_connected() {
+    TCPOverIPv4Adapter adapter;
+    adapter.config_mut().source = {"10.0.0.1", 80};
+    adapter.config_mut().destination = {"10.0.0.2", 5000};
+
+    test_should_be(adapter.early_demux(make_datagram(5000, 80)).has_value(), false);
+    test_should_be(adapter.receive(make_datagram(5000, 80)).has_value(), true);
+
+    test_should_be(adapter.early_demux(make_datagram(5000, 81)) == Drop::OtherPort, true);
+    test_should_be(adapter.receive(make_datagram(5000, 81)).has_value(), false);
+    test_should_be(adapter.receive(make_datagram(5001, 80)).has_value(), false);
+    test_should_be(adapter.dropped(Drop::OtherPort), uint64_t(2));
+
+    string other_address = make_datagram(5000, 80);
+    other_address[19] = 9;  // last byte of the destination address
+    test_should_be(adapter.receive(move(other_address)).has_value(), false);
+    test_should_be(adapter.dropped(Drop::OtherAddress), uint64_t(1));
+
+    string not_tcp = make_datagram(5000, 80);
+    not_tcp[9] = 17;  // UDP
+    test_should_be(adapter.receive(move(not_tcp)).has_value(), false);
+    test_should_be(adapter.dropped(Drop::NotTCP), uint64_t(1));
+
+    test_should_be(adapter.receive(string("short")).has_value(), false);
+    test_should_be(adapter.dropped(Drop::Malformed), uint64_t(1));
+
+    // the checksum is only checked for datagrams that pass the first stage
+    string corrupt = make_datagram(5000, 80);
+    corrupt.back() ^= 1;
+    test_should_be(adapter.early_demux(corrupt).has_value(), false);
+    test_should_be(adapter.receive(move(corrupt)).has_value(), false);
+    test_should_be(adapter.dropped(Drop::BadChecksum), uint64_t(1));
+
+    string corrupt_elsewhere = make_datagram(5000, 81);
+    corrupt_elsewhere.back() ^= 1;
+    test_should_be(adapter.receive(move(corrupt_elsewhere)).has_value(), false);
+    test_should_be(adapter.dropped(Drop::BadChecksum), uint64_t(1));
+    test_should_be(adapter.dropped(Drop::OtherPort), uint64_t(3));
+}
+
+//! While listening, only a SYN to the right port gets through, and then the connection's tuple applies
+static void test_listening() {
+    TCPOverIPv4Adapter adapter;
+    adapter.config_mut().source = {"0", 80};
+    adapter.set_listening(true);
+
+    test_should_be(adapter.receive(make_datagram(6000, 80)).has_value(), false);
+    test_should_be(adapter.dropped(Drop::NotSYN), uint64_t(1));
+    test_should_be(adapter.receive(make_datagram(6000, 81, true)).has_value(), false);
+    test_should_be(adapter.dropped(Drop::OtherPort), uint64_t(1));
+
+    test_should_be(adapter.receive(make_datagram(6000, 80, true)).has_value(), true);
+    test_should_be(adapter.listening(), false);
+    test_should_be(adapter.receive(make_datagram(6000, 80)).has_value(), true);
+    test_should_be(adapter.early_demux(make_datagram(5000, 80)) == Drop::OtherPort, true);
+}
+
+int main() {
+    try {
+        test_connected();
+        test_listening();
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
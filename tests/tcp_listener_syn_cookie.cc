@@ -0,0 +1,154 @@
+#include "syn_cookie.hh"
+#include "tcp_listener.hh"
+#include "test_should_be.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+
+using namespace std;
+
+static FourTuple tuple_for(const uint16_t remote_port) {
+    FourTuple t;
+    t.local_address = Address("10.0.0.1").ipv4_numeric();
+    t.local_port = 80;
+    t.remote_address = Address("10.0.0.2").ipv4_numeric();
+    t.remote_port = remote_port;
+    return t;
+}
+
+static TCPSegment spoofed_syn(const uint32_t isn) {
+    TCPSegment seg;
+    seg.header().syn = true;
+    seg.header().seqno = WrappingInt32{isn};
+    return seg;
+}
+
+//! Deliver everything `client` wants sent to the listener
+static void client_to_listener(TCPConnection &client, TCPListener &listener, const FourTuple &tuple) {
+    while (not client.segments_out().empty()) {
+        listener.segment_received(tuple, client.segments_out().front());
+        client.segments_out().pop();
+    }
+}
+
+//! Deliver everything the listener wants sent on `tuple` to `client`, and drop the rest
+static void listener_to_client(TCPListener &listener, TCPConnection &client, const FourTuple &tuple) {
+    while (not listener.segments_out().empty()) {
+        if (listener.segments_out().front().first == tuple) {
+            client.segment_received(listener.segments_out().front().second);
+        }
+        listener.segments_out().pop();
+    }
+}
+
+static void test_codec() {
+    const SYNCookieCodec codec{{{0x0123456789abcdefULL, 0xfedcba9876543210ULL}}};
+    const FourTuple tuple = tuple_for(1234);
+    const WrappingInt32 peer_isn{0xdeadbeef};
+    const uint64_t now = 5 * SYNCookieCodec::COUNTER_PERIOD_MS + 17;
+
+    const WrappingInt32 cookie = codec.encode(tuple, peer_isn, 1460, now);
+    test_should_be(codec.decode(tuple, peer_isn, cookie, now).value_or(0), uint16_t{1460});
+
+    // MSS is rounded down to a representable value
+    const WrappingInt32 odd_mss = codec.encode(tuple, peer_isn, 1400, now);
+    test_should_be(codec.decode(tuple, peer_isn, odd_mss, now).value_or(0), uint16_t{1360});
+
+    // still valid a little later, but not once it is too old
+    const uint64_t later = now + SYNCookieCodec::MAX_COUNTER_AGE * SYNCookieCodec::COUNTER_PERIOD_MS;
+    test_should_be(codec.decode(tuple, peer_isn, cookie, later).has_value(), true);
+    test_should_be(codec.decode(tuple, peer_isn, cookie, later + SYNCookieCodec::COUNTER_PERIOD_MS).has_value(),
+                   false);
+
+    // bound to the tuple and the peer's ISN
+    test_should_be(codec.decode(tuple_for(1235), peer_isn, cookie, now).has_value(), false);
+    test_should_be(codec.decode(tuple, peer_isn + 1, cookie, now).has_value(), false);
+    test_should_be(codec.decode(tuple, peer_isn, cookie + 1, now).has_value(), false);
+}
+
+static void test_listener_under_flood() {
+    TCPConfig cfg;
+    TCPListenerConfig listener_cfg;
+    listener_cfg.syn_queue_capacity = 8;
+    listener_cfg.syn_cookie_threshold = 4;
+    TCPListener listener{cfg, listener_cfg};
+
+    // fill the SYN queue up to the cookie threshold with handshakes that will never complete
+    for (uint16_t port = 1000; port < 1100; port++) {
+        listener.segment_received(tuple_for(port), spoofed_syn(port * 7919));
+    }
+    test_should_be(listener.syn_queue_size(), size_t{4});
+    test_should_be(listener.cookies_active(), true);
+    test_should_be(listener.stats().cookies_sent, uint64_t{96});
+    while (not listener.segments_out().empty()) {
+        listener.segments_out().pop();
+    }
+
+    // a forged ACK does not create a connection
+    TCPSegment forged;
+    forged.header().ack = true;
+    forged.header().seqno = WrappingInt32{1};
+    forged.header().ackno = WrappingInt32{12345};
+    listener.segment_received(tuple_for(4000), forged);
+    test_should_be(listener.connection_count(), size_t{0});
+    test_should_be(listener.stats().cookies_rejected, uint64_t{1});
+
+    // a legitimate client still gets through, without occupying the SYN queue
+    const FourTuple tuple = tuple_for(5000);
+    TCPConnection client{cfg};
+    client.connect();
+    client_to_listener(client, listener, tuple);
+    test_should_be(listener.syn_queue_size(), size_t{4});
+    listener_to_client(listener, client, tuple);
+    test_should_be(client.state() == TCPState::State::ESTABLISHED, true);
+    client_to_listener(client, listener, tuple);
+
+    test_should_be(listener.accept() == optional<FourTuple>{tuple}, true);
+    test_should_be(listener.accept().has_value(), false);
+    test_should_be(listener.stats().cookies_accepted, uint64_t{1});
+
+    // and the connection carries data in both directions
+    TCPConnection &server = listener.connection(tuple);
+    test_should_be(server.state() == TCPState::State::ESTABLISHED, true);
+    client.write("hello");
+    client_to_listener(client, listener, tuple);
+    test_should_be(server.inbound_stream().read(5) == "hello", true);
+    server.write("world");
+    listener.tick(0);  // picks up what the server wrote
+    listener_to_client(listener, client, tuple);
+    test_should_be(client.inbound_stream().read(5) == "world", true);
+}
+
+static void test_listener_without_flood() {
+    TCPConfig cfg;
+    TCPListener listener{cfg, TCPListenerConfig{}};
+
+    const FourTuple tuple = tuple_for(6000);
+    TCPConnection client{cfg};
+    client.connect();
+    client_to_listener(client, listener, tuple);
+    test_should_be(listener.syn_queue_size(), size_t{1});
+    test_should_be(listener.stats().cookies_sent, uint64_t{0});
+    listener_to_client(listener, client, tuple);
+    client_to_listener(client, listener, tuple);
+
+    test_should_be(listener.syn_queue_size(), size_t{0});
+    test_should_be(listener.accept() == optional<FourTuple>{tuple}, true);
+}
+
+int main() {
+    try {
+        test_codec();
+        test_listener_under_flood();
+        test_listener_without_flood();
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
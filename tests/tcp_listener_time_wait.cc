@@ -0,0 +1,156 @@
+#include "tcp_listener.hh"
+#include "test_should_be.hh"
+#include "time_wait_table.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+
+using namespace std;
+
+static FourTuple tuple_for(const uint16_t remote_port) {
+    FourTuple t;
+    t.local_address = Address("10.0.0.1").ipv4_numeric();
+    t.local_port = 80;
+    t.remote_address = Address("10.0.0.2").ipv4_numeric();
+    t.remote_port = remote_port;
+    return t;
+}
+
+static TCPSegment fin(const uint32_t seqno) {
+    TCPSegment seg;
+    seg.header().fin = true;
+    seg.header().ack = true;
+    seg.header().seqno = WrappingInt32{seqno};
+    return seg;
+}
+
+static void test_table() {
+    TimeWaitTable table{1000, 10};
+    const FourTuple tuple = tuple_for(1000);
+    table.insert(tuple, TimeWaitRecord{WrappingInt32{100}, WrappingInt32{200}, 5000});
+    test_should_be(table.size(), size_t{1});
+
+    table.tick(990);
+    test_should_be(table.contains(tuple), true);
+
+    // a retransmitted FIN is ACKed and restarts the timer
+    const auto reply = table.segment_received(tuple, fin(199));
+    test_should_be(reply.has_value(), true);
+    test_should_be(reply->header().ack, true);
+    test_should_be(reply->header().seqno, WrappingInt32{100});
+    test_should_be(reply->header().ackno, WrappingInt32{200});
+    test_should_be(reply->header().win, uint16_t{5000});
+    test_should_be(reply->length_in_sequence_space(), size_t{0});
+
+    table.tick(990);
+    test_should_be(table.contains(tuple), true);
+    table.tick(20);
+    test_should_be(table.contains(tuple), false);
+
+    // a bare ACK restarts the timer without a reply; a RST ends TIME_WAIT
+    table.insert(tuple, TimeWaitRecord{});
+    TCPSegment ack;
+    ack.header().ack = true;
+    test_should_be(table.segment_received(tuple, ack).has_value(), false);
+    TCPSegment rst;
+    rst.header().rst = true;
+    test_should_be(table.segment_received(tuple, rst).has_value(), false);
+    test_should_be(table.size(), size_t{0});
+}
+
+static void test_table_long_linger() {
+    // the linger time spans several turns of the wheel
+    TimeWaitTable table{10 * TimeWaitTable::NUM_SLOTS * 10, 10};
+    for (uint16_t port = 0; port < 1000; port++) {
+        table.insert(tuple_for(port), TimeWaitRecord{}, port);
+    }
+
+    size_t elapsed = 0;
+    while (elapsed < 10 * TimeWaitTable::NUM_SLOTS * 10 - 1000) {
+        table.tick(100);
+        elapsed += 100;
+    }
+    test_should_be(table.size(), size_t{1000});
+
+    table.tick(500);
+    test_should_be(table.size() > 0 and table.size() < 1000, true);
+    table.tick(510);
+    test_should_be(table.size(), size_t{0});
+}
+
+//! Deliver everything `client` wants sent to the listener
+static void client_to_listener(TCPConnection &client, TCPListener &listener, const FourTuple &tuple) {
+    while (not client.segments_out().empty()) {
+        listener.segment_received(tuple, client.segments_out().front());
+        client.segments_out().pop();
+    }
+}
+
+//! Deliver everything the listener wants sent to `client`; returns the last segment
+static TCPSegment listener_to_client(TCPListener &listener, TCPConnection &client) {
+    TCPSegment last;
+    while (not listener.segments_out().empty()) {
+        last = listener.segments_out().front().second;
+        client.segment_received(last);
+        listener.segments_out().pop();
+    }
+    return last;
+}
+
+static void test_listener_active_close() {
+    TCPConfig cfg;
+    TCPListener listener{cfg, TCPListenerConfig{}};
+    const FourTuple tuple = tuple_for(2000);
+
+    TCPConnection client{cfg};
+    client.connect();
+    client_to_listener(client, listener, tuple);
+    listener_to_client(listener, client);
+    client_to_listener(client, listener, tuple);
+    test_should_be(listener.accept().has_value(), true);
+
+    // the server closes first, so it is the side that ends up in TIME_WAIT
+    listener.connection(tuple).end_input_stream();
+    listener.tick(0);
+    listener_to_client(listener, client);
+    client_to_listener(client, listener, tuple);
+
+    client.end_input_stream();
+    TCPSegment client_fin = client.segments_out().back();
+    client_to_listener(client, listener, tuple);
+    const TCPSegment final_ack = listener_to_client(listener, client);
+    test_should_be(client.active(), false);
+
+    test_should_be(listener.connection_count(), size_t{0});
+    test_should_be(listener.time_wait_count(), size_t{1});
+
+    // the client's FIN is retransmitted: TIME_WAIT answers it exactly as the connection did
+    listener.segment_received(tuple, client_fin);
+    test_should_be(listener.segments_out().size(), size_t{1});
+    const TCPSegment &reply = listener.segments_out().front().second;
+    test_should_be(reply.header().seqno, final_ack.header().seqno);
+    test_should_be(reply.header().ackno, final_ack.header().ackno);
+    test_should_be(reply.header().win, final_ack.header().win);
+    listener.segments_out().pop();
+
+    listener.tick(10 * cfg.rt_timeout - 1);
+    test_should_be(listener.time_wait_count(), size_t{1});
+    listener.tick(20);
+    test_should_be(listener.time_wait_count(), size_t{0});
+}
+
+int main() {
+    try {
+        test_table();
+        test_table_long_linger();
+        test_listener_active_close();
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
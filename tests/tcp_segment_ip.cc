@@ -0,0 +1,56 @@
+#include "ipv4_datagram.hh"
+#include "parser.hh"
+#include "tcp_over_ip.hh"
+#include "test_should_be.hh"
+#include "util.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        const uint32_t client = Address("169.254.144.1").ipv4_numeric();
+        const uint32_t server = Address("169.254.144.9").ipv4_numeric();
+
+        // the client sends a segment of its connection to the server...
+        TCPSegment seg;
+        seg.header().syn = true;
+        seg.header().seqno = WrappingInt32(12345);
+        seg.payload() = string("hello");
+        const FourTuple client_tuple{client, 40000, server, 80};
+        const InternetDatagram sent = tcp_segment_to_ip(client_tuple, seg);
+        test_should_be(sent.header().src, client);
+        test_should_be(sent.header().dst, server);
+
+        // ...which arrives over the wire and is parsed as part of the server's connection
+        InternetDatagram received;
+        test_should_be(received.parse(sent.serialize().concatenate()) == ParseResult::NoError, true);
+        FourTuple server_tuple;
+        const auto parsed = tcp_segment_from_ip(received, server_tuple);
+        test_should_be(parsed.has_value(), true);
+        const FourTuple expected_tuple{server, 80, client, 40000};
+        test_should_be(server_tuple == expected_tuple, true);
+        test_should_be(parsed->header().syn, true);
+        test_should_be(parsed->header().seqno.raw_value(), 12345U);
+        test_should_be(parsed->payload().str() == "hello", true);
+
+        // a datagram whose TCP checksum does not match is rejected
+        string corrupted = sent.serialize().concatenate();
+        corrupted.back() ^= 1;
+        test_should_be(received.parse(move(corrupted)) == ParseResult::NoError, true);
+        test_should_be(tcp_segment_from_ip(received, server_tuple).has_value(), false);
+
+        // as is a datagram that does not carry TCP
+        InternetDatagram udp = sent;
+        udp.header().proto = 17;
+        test_should_be(tcp_segment_from_ip(udp, server_tuple).has_value(), false);
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
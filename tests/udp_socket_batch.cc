@@ -0,0 +1,123 @@
+#include "fd_adapter.hh"
+#include "socket.hh"
+#include "test_should_be.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static void test_socket() {
+    UDPSocket receiver;
+    receiver.bind({"127.0.0.1", "0"});
+    UDPSocket sender;
+    sender.bind({"127.0.0.1", "0"});
+
+    // three datagrams in one call, one of them gathered from two pieces
+    const string a = "a", bc = "bc", def = "def";
+    BufferList gathered{string("hello")};
+    gathered.append(BufferList(string(" world")));
+    vector<BufferViewList> payloads{a, bc, def, gathered};
+    sender.send_batch(receiver.local_address(), payloads);
+
+    UDPSocket::DatagramBatch batch{8, 100};
+    test_should_be(batch.capacity(), size_t{8});
+    test_should_be(receiver.recv_batch(batch), size_t{4});
+    test_should_be(batch.payload(0) == "a", true);
+    test_should_be(batch.payload(1) == "bc", true);
+    test_should_be(batch.payload(2) == "def", true);
+    test_should_be(batch.payload(3) == "hello world", true);
+    test_should_be(batch.source_address(3) == sender.local_address(), true);
+
+    // more datagrams than the batch holds arrive over several calls
+    const string x = "x";
+    payloads.assign(11, x);
+    sender.send_batch(receiver.local_address(), payloads);
+    test_should_be(receiver.recv_batch(batch), size_t{8});
+    test_should_be(receiver.recv_batch(batch), size_t{3});
+
+    // a datagram bigger than the batch's mtu is an error, as with recv()
+    sender.sendto(receiver.local_address(), string(200, 'y'));
+    bool threw = false;
+    try {
+        receiver.recv_batch(batch);
+    } catch (const runtime_error &) {
+        threw = true;
+    }
+    test_should_be(threw, true);
+}
+
+// runs of same-size datagrams go out as one UDP_SEGMENT message, and come back coalesced with UDP_GRO
+static void test_offload() {
+    UDPSocket receiver;
+    receiver.bind({"127.0.0.1", "0"});
+    UDPSocket sender;
+    sender.bind({"127.0.0.1", "0"});
+    if (not sender.gso_supported() or not receiver.enable_gro()) {
+        cerr << "UDP GSO/GRO not supported by this kernel, skipping offload test\n";
+        return;
+    }
+
+    const string ten(10, 'a'), four(4, 'b'), seven(7, 'c');
+    const vector<BufferViewList> payloads{ten, ten, ten, four, seven, seven};
+    sender.send_batch(receiver.local_address(), payloads, true);
+
+    UDPSocket::DatagramBatch batch{8, 1000};
+    test_should_be(receiver.recv_batch(batch), size_t{2});
+    test_should_be(batch.payload(0) == ten + ten + ten + four, true);
+    test_should_be(batch.segment_size(0), size_t{10});
+    test_should_be(batch.payload(1) == seven + seven, true);
+    test_should_be(batch.segment_size(1), size_t{7});
+}
+
+static void test_adapter() {
+    UDPSocket server_sock;
+    server_sock.bind({"127.0.0.1", "0"});
+    UDPSocket client_sock;
+    client_sock.bind({"127.0.0.1", "0"});
+
+    TCPOverUDPSocketAdapter server{move(server_sock)};
+    TCPOverUDPSocketAdapter client{move(client_sock)};
+    client.config_mut().source = static_cast<UDPSocket &>(client).local_address();
+    client.config_mut().destination = static_cast<UDPSocket &>(server).local_address();
+    server.config_mut().source = client.config().destination;
+    server.set_listening(true);
+
+    // nothing is sent until the batch is flushed
+    constexpr size_t count = 5;
+    for (size_t i = 0; i < count; i++) {
+        TCPSegment seg;
+        seg.header().syn = (i == 0);
+        seg.header().seqno = WrappingInt32(i);
+        seg.payload() = string(i == count - 1 ? 3 : 100, 'z');
+        client.write(seg);
+    }
+    client.flush();
+
+    // all of them arrive in one batch (perhaps coalesced), and read() hands them out one at a time
+    for (size_t i = 0; i < count; i++) {
+        const auto seg = server.read();
+        test_should_be(seg.has_value(), true);
+        test_should_be(seg->header().seqno.raw_value(), uint32_t(i));
+        test_should_be(seg->payload().size(), i == count - 1 ? size_t{3} : size_t{100});
+        test_should_be(server.has_pending_reads(), i + 1 < count);
+    }
+    test_should_be(server.listening(), false);
+    test_should_be(server.config().destination == client.config().source, true);
+}
+
+int main() {
+    try {
+        test_socket();
+        test_offload();
+        test_adapter();
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,133 @@
+#include "ipv4_datagram.hh"
+#include "parser.hh"
+#include "socket.hh"
+#include "tcp_sponge_socket.hh"
+#include "test_should_be.hh"
+#include "util.hh"
+#include "virtio_net_header.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+//! Completes a checksum left for offload, as the kernel does for a frame flagged F_NEEDS_CSUM
+static void complete_checksum(string &frame, const VirtioNetHeader &vnet) {
+    InternetChecksum check;
+    check.add(string_view(frame).substr(vnet.csum_start));
+    const uint16_t cksum = check.value();
+    frame.at(vnet.csum_start + vnet.csum_offset) = char(cksum >> 8);
+    frame.at(vnet.csum_start + vnet.csum_offset + 1) = char(cksum & 0xff);
+}
+
+//! A TCP segment whose checksum is left for offload parses once the checksum is completed
+static void test_checksum_offload() {
+    InternetDatagram dgram;
+    dgram.header().src = Address("169.254.10.9").ipv4_numeric();
+    dgram.header().dst = Address("169.254.10.1").ipv4_numeric();
+
+    TCPSegment seg;
+    seg.header().ack = true;
+    seg.header().ackno = WrappingInt32(54321);
+    seg.payload() = string(1001, 'x');
+    dgram.header().len = dgram.header().hlen * 4 + seg.header().doff * 4 + seg.payload().size();
+    const uint32_t pseudo_cksum = dgram.header().pseudo_cksum();
+
+    string partial = seg.serialize_for_checksum_offload(pseudo_cksum).concatenate();
+    TCPSegment parsed;
+    test_should_be(parsed.parse(string(partial), pseudo_cksum) == ParseResult::BadChecksum, true);
+    test_should_be(parsed.parse(string(partial), pseudo_cksum, true) == ParseResult::NoError, true);
+
+    VirtioNetHeader vnet;
+    vnet.flags = VirtioNetHeader::F_NEEDS_CSUM;
+    vnet.csum_start = 0;
+    vnet.csum_offset = 16;
+    complete_checksum(partial, vnet);
+    test_should_be(partial == seg.serialize(pseudo_cksum).concatenate(), true);
+    test_should_be(parsed.parse(move(partial), pseudo_cksum) == ParseResult::NoError, true);
+    test_should_be(parsed.payload().size(), size_t(1001));
+}
+
+static void test_header_round_trip() {
+    VirtioNetHeader vnet;
+    vnet.flags = VirtioNetHeader::F_NEEDS_CSUM;
+    vnet.gso_type = VirtioNetHeader::GSO_TCPV4;
+    vnet.hdr_len = 54;
+    vnet.gso_size = 1000;
+    vnet.csum_start = 34;
+    vnet.csum_offset = 16;
+
+    const string serialized = vnet.serialize();
+    test_should_be(serialized.size(), VirtioNetHeader::LENGTH);
+    // the fields are in host (little-endian, here) byte order
+    test_should_be(uint8_t(serialized.at(4)), uint8_t(1000 & 0xff));
+
+    VirtioNetHeader parsed;
+    NetParser p{string(serialized)};
+    test_should_be(parsed.parse(p) == ParseResult::NoError, true);
+    test_should_be(parsed.flags, vnet.flags);
+    test_should_be(parsed.gso_type, vnet.gso_type);
+    test_should_be(parsed.hdr_len, vnet.hdr_len);
+    test_should_be(parsed.gso_size, vnet.gso_size);
+    test_should_be(parsed.csum_start, vnet.csum_start);
+    test_should_be(parsed.csum_offset, vnet.csum_offset);
+
+    NetParser too_short{string(serialized.substr(0, 6))};
+    test_should_be(parsed.parse(too_short) == ParseResult::PacketTooShort, true);
+}
+
+//! Exchanges data with the kernel's TCP through tap10, with checksums and segmentation offloaded
+//! \param[in] listener is a kernel socket listening on tap10's address
+static void test_tap_exchange(TCPSocket &listener) {
+    const string request(300000, 'q');
+    const string response(200000, 'r');
+
+    string received_by_kernel;
+    thread kernel_side([&] {
+        TCPSocket conn = listener.accept();
+        while (not conn.eof()) {
+            received_by_kernel += conn.read();
+        }
+        conn.write(response);
+    });
+
+    FullStackSocket sock;
+    sock.connect(listener.local_address());
+    sock.write(request);
+    sock.shutdown(SHUT_WR);
+    string received_by_sponge;
+    while (not sock.eof()) {
+        received_by_sponge += sock.read();
+    }
+    sock.wait_until_closed();
+    kernel_side.join();
+
+    test_should_be(received_by_kernel == request, true);
+    test_should_be(received_by_sponge == response, true);
+}
+
+int main() {
+    try {
+        test_header_round_trip();
+        test_checksum_offload();
+
+        // tap10 (see tap.sh) must be up, with its address, for the kernel to listen there
+        TCPSocket listener;
+        try {
+            listener.set_reuseaddr();
+            listener.bind({"169.254.10.1", 9191});
+        } catch (const exception &e) {
+            cerr << "Skipping the TAP test (" << e.what() << "); run tap.sh to create tap10\n";
+            return EXIT_SUCCESS;
+        }
+        listener.listen();
+        test_tap_exchange(listener);
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}